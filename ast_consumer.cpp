@@ -1,84 +1,187 @@
 #include "ast_consumer.h"
 #include "clang/AST/ASTContext.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/JSON.h"
 #include "clang/Lex/Preprocessor.h"
 #include <memory>
+#include <set>
 #include <fstream>
 #include <algorithm>
 #include <sstream>
 
 // External declaration for global flag
 extern bool enableLoopParallelization;
+extern bool enableSoATransform;
+extern std::string numaProcBind;
+extern bool emitTimers;
+extern std::string reportFormat;
+extern bool timePhases;
+extern bool wholeProgram;
+extern bool planRegions;
+extern MachineModel machineModel;
 
 using namespace clang;
 
+// Functions with external linkage declared but not defined in this unit. Calls
+// into other units need such a declaration, so they are all covered.
+static void collectDeclaredFunctions(DeclContext* context, SourceManager& SM, std::set<std::string>& declared) {
+    for (Decl* D : context->decls()) {
+        if (auto* FD = dyn_cast<FunctionDecl>(D)) {
+            if (!FD->doesThisDeclarationHaveABody() && FD->hasExternalFormalLinkage() &&
+                !SM.isInSystemHeader(FD->getLocation())) {
+                declared.insert(FD->getNameAsString());
+            }
+        } else if (isa<NamespaceDecl>(D) || isa<LinkageSpecDecl>(D)) {
+            collectDeclaredFunctions(cast<DeclContext>(D), SM, declared);
+        }
+    }
+}
+
 HybridParallelizerConsumer::HybridParallelizerConsumer(CompilerInstance &CI, const std::string &inputFile) 
     : CI(CI), inputFileName(inputFile), functionAnalyzer(globalCollector.globalVariables),
       mainExtractor(&CI.getSourceManager()),
       loopAnalyzer(&CI.getSourceManager(), globalCollector.globalVariables),
-      typedefCollector(&CI.getSourceManager()) {}  // NEW: Initialize typedef collector
+      typedefCollector(&CI.getSourceManager()), phases(timePhases) {
+    // The consumer is created before parsing starts; HandleTranslationUnit ends this phase
+    phases.begin("Clang parse and Sema");
+}
+
+// AST size for --time-phases, including everything pulled in by the headers
+static PhaseProfiler::Counts countAstNodes(TranslationUnitDecl *TU) {
+    class NodeCounter : public RecursiveASTVisitor<NodeCounter> {
+    public:
+        size_t decls = 0, stmts = 0;
+        bool VisitDecl(Decl *D) { decls++; return true; }
+        bool VisitStmt(Stmt *S) { stmts++; return true; }
+    };
+    NodeCounter counter;
+    counter.TraverseDecl(TU);
+    return {{"decls", counter.decls}, {"stmts", counter.stmts}};
+}
 
 void HybridParallelizerConsumer::HandleTranslationUnit(ASTContext &Context) {
     TranslationUnitDecl *TU = Context.getTranslationUnitDecl();
+    phases.end(phases.active() ? countAstNodes(TU) : PhaseProfiler::Counts());
     
     // First pass: collect global variables
+    phases.begin("Collect globals");
     globalCollector.TraverseDecl(TU);
+    phases.end({{"globals", globalCollector.globalVariables.size()}});
     
     // NEW: First pass: collect typedefs and type aliases
+    phases.begin("Collect typedefs and records");
     typedefCollector.TraverseDecl(TU);
+    phases.end({{"typedefs", typedefCollector.sourceContext.typedefs.size()},
+                {"records", typedefCollector.sourceContext.records.size()}});
     
     // Update analyzers with global variables
     functionAnalyzer.globalVars = globalCollector.globalVariables;
     functionAnalyzer.setSourceManager(&CI.getSourceManager());
     
     // Second pass: analyze all functions (this will also find loops)
+    phases.begin("Analyze functions");
     functionAnalyzer.TraverseDecl(TU);
+    phases.end({{"functions", functionAnalyzer.functionInfo.size()}});
+    
+    // Functions defined in the other translation units, from the first pass
+    if (wholeProgram) {
+        std::set<std::string> declared;
+        collectDeclaredFunctions(TU, CI.getSourceManager(), declared);
+        size_t external = programIndex().mergeExternal(inputFileName, declared, functionAnalyzer.functionInfo,
+                                                       functionAnalyzer.functionAnalysis);
+        llvm::outs() << "Whole-program mode: " << external << " functions from other translation units\n";
+    }
     
     // Third pass: analyze loops across all functions
+    phases.begin("Analyze loops");
+    loopAnalyzer.setFunctionAnalysis(&functionAnalyzer.functionAnalysis);
     loopAnalyzer.TraverseDecl(TU);
+    size_t loopCount = 0;
+    for (const auto& pair : loopAnalyzer.getAllFunctionLoops()) {
+        loopCount += pair.second.size();
+    }
+    phases.end({{"loops", loopCount}});
     
     // Fourth pass: set loop information in function analyzer
-    functionAnalyzer.setFunctionLoops(loopAnalyzer.getAllFunctionLoops());
+    phases.begin("Attach loops to functions");
+    functionAnalyzer.setFunctionLoops(loopAnalyzer.takeAllFunctionLoops());
+    phases.end();
     
     // Fifth pass: extract main function calls (only visits main function)
+    phases.begin("Extract main calls");
     mainExtractor.setFunctionAnalysis(&functionAnalyzer.functionAnalysis);
     mainExtractor.TraverseDecl(TU);
+    phases.end({{"calls", mainExtractor.functionCalls.size()},
+                {"locals", mainExtractor.getLocalVariables().size()}});
     
     // Extract original includes from source file
     std::string originalIncludes = extractOriginalIncludes(Context);
     
     // Perform parallelization analysis
+    phases.begin("Build dependency graph");
     HybridParallelizer parallelizer(mainExtractor.functionCalls, 
                                    functionAnalyzer.functionAnalysis,
                                    mainExtractor.getLocalVariables(),
                                    functionAnalyzer.functionInfo,
                                    mainExtractor.getMainLoops(),
                                    globalCollector.globalVariables,
+                                   globalCollector.globalVariableInfo,
                                    originalIncludes,
                                    enableLoopParallelization,
                                    typedefCollector.sourceContext,
-                                   mainExtractor.mainFunctionBody);  // NEW: Pass main body for preservation
-    
-    // Generate output
-    std::string hybridCode = parallelizer.generateHybridMPIOpenMPCode();
+                                   mainExtractor.mainFunctionBody,  // NEW: Pass main body for preservation
+                                   enableSoATransform,
+                                   numaProcBind,
+                                   emitTimers,
+                                   planRegions,
+                                   machineModel);
+    size_t edgeCount = 0;
+    for (const auto& node : parallelizer.getDependencyGraph()) {
+        edgeCount += node.dependencies.size();
+    }
+    phases.end({{"nodes", parallelizer.getDependencyGraph().size()}, {"edges", edgeCount}});
     
-    // Write to output file
+    // Generate output straight into the output file
     std::string outputFileName = generateOutputFileName();
-    std::ofstream outFile(outputFileName);
-    if (outFile.is_open()) {
-        outFile << hybridCode;
+    phases.begin("Generate hybrid code");
+    std::error_code error;
+    llvm::raw_fd_ostream outFile(outputFileName, error);
+    if (!error) {
+        parallelizer.writeHybridMPIOpenMPCode(outFile);
+        size_t bytes = outFile.tell();
         outFile.close();
-        llvm::outs() << "Enhanced Hybrid MPI/OpenMP parallelized code generated: " << outputFileName << "\n";
+        phases.end({{"bytes", bytes}});
+        // Buffered writes (a full disk, a quota) only fail when they are flushed
+        if (outFile.has_error()) {
+            error = outFile.error();
+            outFile.clear_error();  // raw_fd_ostream aborts on an unhandled error
+        } else {
+            llvm::outs() << "Enhanced Hybrid MPI/OpenMP parallelized code generated: " << outputFileName << "\n";
+        }
     } else {
-        llvm::errs() << "Error: Could not create output file: " << outputFileName << "\n";
+        phases.end();
+    }
+    if (error) {
+        // Reported as a compiler error so the tool exits with a failure status
+        DiagnosticsEngine &diags = Context.getDiagnostics();
+        diags.Report(diags.getCustomDiagID(DiagnosticsEngine::Error, "could not write output file '%0': %1"))
+            << outputFileName << error.message();
     }
     
     // Generate dependency graph visualizations
+    phases.begin("Write graph visualizations");
     generateDependencyGraphVisualization(parallelizer);
     generateGraphvizDependencyGraph(parallelizer);
+    phases.end();
+    if (reportFormat == "json") {
+        phases.begin("Write JSON report");
+        generateJsonReport(parallelizer);
+        phases.end();
+    }
     
     // Print comprehensive analysis results
     printEnhancedAnalysisResults(parallelizer);
+    phases.report();
 }
 
 void HybridParallelizerConsumer::printEnhancedAnalysisResults(const HybridParallelizer& parallelizer) {
@@ -112,13 +215,13 @@ void HybridParallelizerConsumer::printEnhancedAnalysisResults(const HybridParall
     }
     
     llvm::outs() << "\n=== Comprehensive Loop Analysis (All Functions) ===\n";
-    const auto& allFunctionLoops = loopAnalyzer.getAllFunctionLoops();
     int totalLoops = 0;
     int parallelizableLoops = 0;
     
-    for (const auto& pair : allFunctionLoops) {
+    // The loop analyzer handed its loops over to the function info
+    for (const auto& pair : functionAnalyzer.functionInfo) {
         const std::string& funcName = pair.first;
-        const std::vector<LoopInfo>& loops = pair.second;
+        const std::vector<LoopInfo>& loops = pair.second.loops;
         
         if (!loops.empty()) {
             llvm::outs() << "\nFunction: " << funcName << "\n";
@@ -131,6 +234,10 @@ void HybridParallelizerConsumer::printEnhancedAnalysisResults(const HybridParall
                     parallelizableLoops++;
                     llvm::outs() << "    OpenMP Schedule: " << loop.schedule_type << "\n";
                     llvm::outs() << "    Generated Pragma: " << loop.pragma_text << "\n";
+                    if (planRegions) {
+                        RegionPlan plan = planLoop(loop, machineModel);
+                        llvm::outs() << "    Plan: " << plan.modeName() << " (" << plan.reason << ")\n";
+                    }
                     if (!loop.reduction_vars.empty()) {
                         llvm::outs() << "    Reduction variables: ";
                         for (const auto& var : loop.reduction_vars) {
@@ -181,6 +288,15 @@ void HybridParallelizerConsumer::printEnhancedAnalysisResults(const HybridParall
         }
     }
     
+    llvm::outs() << "\nRecursive functions:\n";
+    for (const auto& pair : functionAnalyzer.functionInfo) {
+        const FunctionInfo& info = pair.second;
+        if (info.is_recursive) {
+            llvm::outs() << "  " << info.name << ": " << info.recursive_calls.size()
+                        << " recursive call(s) - " << info.task_notes << "\n";
+        }
+    }
+
     llvm::outs() << "\nFunction Calls in main():\n";
     for (int i = 0; i < mainExtractor.functionCalls.size(); ++i) {
         const auto& call = mainExtractor.functionCalls[i];
@@ -425,12 +541,13 @@ void HybridParallelizerConsumer::generateGraphvizDependencyGraph(const HybridPar
     // Generate dependency edges with labels
     for (size_t i = 0; i < dependencyGraph.size(); ++i) {
         const auto& node = dependencyGraph[i];
-        for (int dep : node.dependencies) {
+        for (size_t k = 0; k < node.dependencies.size(); ++k) {
+            int dep = node.dependencies[k];
             dotFile << "    func" << dep << " -> func" << i;
             
             // Add edge label with dependency reason
-            if (!node.dependencyReason.empty()) {
-                std::string reason = node.dependencyReason;
+            if (k < node.edgeReasons.size()) {
+                std::string reason = node.edgeReasons[k];
                 // Simplify long reasons
                 if (reason.length() > 30) {
                     size_t colonPos = reason.find(':');
@@ -472,6 +589,221 @@ void HybridParallelizerConsumer::generateGraphvizDependencyGraph(const HybridPar
     llvm::outs() << "To generate SVG: dot -Tsvg dependency_graph.dot -o dependency_graph.svg\n";
 }
 
+// Names and strings as a JSON array
+template <typename Container>
+static void jsonStrings(llvm::json::OStream& J, llvm::StringRef key, const Container& values) {
+    J.attributeArray(key, [&] {
+        for (const auto& value : values) J.value(value);
+    });
+}
+
+// Analysis notes are sentences ("Contains I/O operations. "), one reason each
+static std::vector<std::string> decisionReasons(const std::string& notes) {
+    std::vector<std::string> reasons;
+    size_t start = 0;
+    while (start < notes.size()) {
+        size_t end = notes.find(". ", start);
+        std::string reason = notes.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        while (!reason.empty() && (reason.back() == ' ' || reason.back() == '.')) reason.pop_back();
+        size_t first = reason.find_first_not_of(' ');
+        if (first != std::string::npos) reasons.push_back(reason.substr(first));
+        if (end == std::string::npos) break;
+        start = end + 2;
+    }
+    return reasons;
+}
+
+static void writeLoopReport(llvm::json::OStream& J, const LoopInfo& loop) {
+    J.object([&] {
+        J.attribute("type", loop.type);
+        J.attribute("start_line", loop.start_line);
+        J.attribute("end_line", loop.end_line);
+        J.attribute("parallelizable", loop.parallelizable);
+        J.attribute("mpi_parallelizable", loop.is_mpi_parallelizable);
+        J.attribute("canonical", loop.is_canonical);
+        J.attribute("nested", loop.is_nested);
+        J.attributeObject("bounds", [&] {
+            J.attribute("variable", loop.loop_variable);
+            J.attribute("variable_type", loop.loop_variable_type);
+            J.attribute("start", loop.start_expr);
+            J.attribute("end", loop.end_expr);
+            J.attribute("step", loop.step_expr);
+        });
+        J.attributeObject("reduction", [&] {
+            J.attribute("op", loop.reduction_op);
+            jsonStrings(J, "vars", loop.reduction_vars);
+            J.attributeArray("arrays", [&] {
+                for (const auto& reduction : loop.array_reductions) {
+                    J.object([&] {
+                        J.attribute("name", reduction.name);
+                        J.attribute("op", reduction.op);
+                        J.attribute("atomic", reduction.use_atomic);
+                    });
+                }
+            });
+            if (loop.is_scan_loop) {
+                J.attributeObject("scan", [&] {
+                    J.attribute("var", loop.scan.var);
+                    J.attribute("op", loop.scan.op);
+                    J.attribute("exclusive", loop.scan.exclusive);
+                });
+            }
+        });
+        J.attributeObject("dependences", [&] {
+            J.attribute("loop_carried", loop.has_dependencies);
+            jsonStrings(J, "carried_scalars", loop.carried_scalars);
+            jsonStrings(J, "conflicting_arrays", loop.conflicting_arrays);
+            jsonStrings(J, "unsafe_functions", loop.unsafe_functions);
+            J.attribute("early_exit", loop.has_break_continue || loop.has_early_return);
+            J.attribute("io", loop.has_io_operations);
+        });
+        J.attributeObject("data_sharing", [&] {
+            jsonStrings(J, "read", loop.read_vars);
+            jsonStrings(J, "written", loop.write_vars);
+            jsonStrings(J, "private", loop.private_vars);
+            jsonStrings(J, "firstprivate", loop.firstprivate_vars);
+            jsonStrings(J, "lastprivate", loop.lastprivate_vars);
+        });
+        jsonStrings(J, "reasons", decisionReasons(loop.analysis_notes));
+        J.attribute("schedule", loop.schedule_type);
+        J.attribute("pragma", loop.pragma_text);
+        if (planRegions && loop.parallelizable) {
+            RegionPlan plan = planLoop(loop, machineModel);
+            J.attributeObject("plan", [&] {
+                J.attribute("mode", plan.modeName());
+                J.attribute("iteration_ns", plan.iterationNs);
+                if (plan.trips >= 0) J.attribute("trips", (int64_t)plan.trips);
+                J.attribute("runtime_guard", plan.runtimeGuard);
+                J.attribute("pragma", plan.pragma);
+                J.attribute("reason", plan.reason);
+            });
+        }
+    });
+}
+
+// --report=json: the whole analysis for downstream tooling. Written through a
+// streaming JSON writer, one function at a time, so no document is built in memory.
+void HybridParallelizerConsumer::generateJsonReport(const HybridParallelizer& parallelizer) {
+    std::string reportFileName = generateReportFileName();
+    std::error_code error;
+    llvm::raw_fd_ostream reportFile(reportFileName, error);
+    if (error) {
+        llvm::errs() << "Error: Could not create JSON report " << reportFileName << ": " << error.message() << "\n";
+        return;
+    }
+    
+    const auto& functionCalls = mainExtractor.functionCalls;
+    const auto& dependencyGraph = parallelizer.getDependencyGraph();
+    auto parallelGroups = parallelizer.getParallelizableGroups();
+    int totalLoops = 0, parallelizableLoops = 0, mpiLoops = 0;
+    
+    llvm::json::OStream J(reportFile, 2);
+    J.objectBegin();
+    J.attribute("input", inputFileName);
+    J.attribute("output", generateOutputFileName());
+    J.attributeObject("options", [&] {
+        J.attribute("loops", enableLoopParallelization);
+        J.attribute("soa", enableSoATransform);
+        J.attribute("numa", numaProcBind);
+        J.attribute("emit_timers", emitTimers);
+        J.attribute("plan", planRegions ? machineModel.describe() : "");
+    });
+    jsonStrings(J, "globals", globalCollector.globalVariables);
+    
+    J.attributeBegin("functions");
+    J.arrayBegin();
+    for (const auto& pair : functionAnalyzer.functionInfo) {
+        const FunctionInfo& info = pair.second;
+        J.object([&] {
+            J.attribute("name", info.name);
+            J.attribute("return_type", info.return_type);
+            if (!info.defined_in.empty()) {
+                J.attribute("defined_in", info.defined_in);
+            }
+            J.attribute("start_line", info.start_line);
+            J.attribute("end_line", info.end_line);
+            if (functionAnalyzer.functionAnalysis.count(pair.first)) {
+                const FunctionAnalysis& analysis = functionAnalyzer.functionAnalysis.at(pair.first);
+                jsonStrings(J, "global_reads", analysis.readSet);
+                jsonStrings(J, "global_writes", analysis.writeSet);
+            }
+            J.attributeObject("recursion", [&] {
+                J.attribute("recursive", info.is_recursive);
+                J.attribute("tasks", info.has_task_parallelism);
+                J.attribute("notes", info.task_notes);
+            });
+            J.attributeArray("loops", [&] {
+                for (const auto& loop : info.loops) {
+                    totalLoops++;
+                    if (loop.parallelizable) parallelizableLoops++;
+                    if (loop.parallelizable && loop.is_mpi_parallelizable) mpiLoops++;
+                    writeLoopReport(J, loop);
+                }
+            });
+        });
+        reportFile.flush();
+    }
+    J.arrayEnd();
+    J.attributeEnd();
+    
+    J.attributeArray("calls", [&] {
+        for (size_t i = 0; i < functionCalls.size(); ++i) {
+            J.object([&] {
+                J.attribute("index", (int64_t)i);
+                J.attribute("function", functionCalls[i].functionName);
+                J.attribute("line", functionCalls[i].lineNumber);
+                J.attribute("result", functionCalls[i].returnVariable);
+            });
+        }
+    });
+    
+    J.attributeArray("dependencies", [&] {
+        for (const auto& node : dependencyGraph) {
+            for (size_t k = 0; k < node.dependencies.size(); ++k) {
+                J.object([&] {
+                    J.attribute("from", node.dependencies[k]);
+                    J.attribute("to", node.callIndex);
+                    J.attribute("reason", k < node.edgeReasons.size() ? node.edgeReasons[k] : "");
+                });
+            }
+        }
+    });
+    
+    size_t widestGroup = 0;
+    J.attributeArray("groups", [&] {
+        for (const auto& group : parallelGroups) {
+            widestGroup = std::max(widestGroup, group.size());
+            J.object([&] {
+                J.attributeArray("calls", [&] {
+                    for (int idx : group) J.value(idx);
+                });
+                J.attributeArray("functions", [&] {
+                    for (int idx : group) J.value(functionCalls[idx].functionName);
+                });
+            });
+        }
+    });
+    
+    // Coverage for dashboards. With enough ranks each group takes as long as one
+    // call, so calls per group bounds the speedup from call-level parallelism.
+    J.attributeObject("summary", [&] {
+        J.attribute("loops", totalLoops);
+        J.attribute("parallelizable_loops", parallelizableLoops);
+        J.attribute("mpi_loops", mpiLoops);
+        J.attribute("loop_coverage", totalLoops > 0 ? (double)parallelizableLoops / totalLoops : 0.0);
+        J.attribute("calls", (int64_t)functionCalls.size());
+        J.attribute("groups", (int64_t)parallelGroups.size());
+        J.attribute("widest_group", (int64_t)widestGroup);
+        J.attribute("call_speedup_bound",
+                    parallelGroups.empty() ? 1.0 : (double)functionCalls.size() / parallelGroups.size());
+    });
+    J.objectEnd();
+    J.flush();
+    reportFile << "\n";
+    
+    llvm::outs() << "JSON analysis report generated: " << reportFileName << "\n";
+}
+
 std::string HybridParallelizerConsumer::extractOriginalIncludes(ASTContext &Context) {
     SourceManager &SM = Context.getSourceManager();
     const FileEntry *MainFileEntry = SM.getFileEntryForID(SM.getMainFileID());
@@ -562,7 +894,51 @@ bool TypedefCollector::VisitTypeAliasDecl(TypeAliasDecl *TAD) {
     return true;
 }
 
+bool TypedefCollector::VisitCXXRecordDecl(CXXRecordDecl *RD) {
+    // Named definitions at file scope in the main file; templates and local classes stay out
+    if (!SM || SM->isInSystemHeader(RD->getLocation()) || !SM->isInMainFile(RD->getLocation()) ||
+        !RD->isThisDeclarationADefinition() || !RD->getDeclContext()->isFileContext() ||
+        RD->getName().empty() || RD->getDescribedClassTemplate() || isa<ClassTemplateSpecializationDecl>(RD)) {
+        return true;
+    }
+    
+    RecordInfo record;
+    record.name = RD->getNameAsString();
+    record.definition = getSourceText(RD->getSourceRange());
+    record.line = SM->getSpellingLineNumber(RD->getLocation());
+    
+    // A flat, trivially copyable layout can be described field by field with offsetof
+    record.transferable = RD->isTriviallyCopyable() && RD->getNumBases() == 0 && !RD->isPolymorphic() &&
+                          !RD->field_empty();
+    for (const FieldDecl *FD : RD->fields()) {
+        RecordField field;
+        field.name = FD->getNameAsString();
+        QualType type = FD->getType().getCanonicalType();
+        if (const ConstantArrayType *CAT = RD->getASTContext().getAsConstantArrayType(type)) {
+            field.count = CAT->getSize().getZExtValue();
+            type = CAT->getElementType().getCanonicalType();
+        }
+        field.type = type.getUnqualifiedType().getAsString();
+        if (FD->isBitField() || field.name.empty() || !type->isArithmeticType()) {
+            record.transferable = false;
+        }
+        record.fields.push_back(field);
+    }
+    
+    sourceContext.records.push_back(record);
+    return true;
+}
+
 std::string HybridParallelizerConsumer::generateOutputFileName() const {
+    // Return the new filename with _parallelized suffix
+    return inputBaseName() + "_parallelized.cpp";
+}
+
+std::string HybridParallelizerConsumer::generateReportFileName() const {
+    return inputBaseName() + "_report.json";
+}
+
+std::string HybridParallelizerConsumer::inputBaseName() const {
     // Extract base filename without extension
     std::string basename = inputFileName;
     
@@ -578,11 +954,38 @@ std::string HybridParallelizerConsumer::generateOutputFileName() const {
         basename = basename.substr(0, lastDot);
     }
     
-    // Return the new filename with _parallelized suffix
-    return basename + "_parallelized.cpp";
+    return basename;
 }
 
 std::unique_ptr<ASTConsumer> HybridParallelizerAction::CreateASTConsumer(CompilerInstance &CI,
                                                                         llvm::StringRef file) {
     return std::make_unique<HybridParallelizerConsumer>(CI, file.str());
+}
+
+ProgramSummaryConsumer::ProgramSummaryConsumer(CompilerInstance &CI, const std::string &inputFile)
+    : CI(CI), inputFileName(inputFile), functionAnalyzer(globalCollector.globalVariables),
+      loopAnalyzer(&CI.getSourceManager(), globalCollector.globalVariables) {}
+
+// Same function and loop passes as the main consumer, without main extraction or codegen
+void ProgramSummaryConsumer::HandleTranslationUnit(ASTContext &Context) {
+    TranslationUnitDecl *TU = Context.getTranslationUnitDecl();
+    
+    globalCollector.TraverseDecl(TU);
+    functionAnalyzer.globalVars = globalCollector.globalVariables;
+    functionAnalyzer.setSourceManager(&CI.getSourceManager());
+    functionAnalyzer.TraverseDecl(TU);
+    
+    loopAnalyzer.setFunctionAnalysis(&functionAnalyzer.functionAnalysis);
+    loopAnalyzer.TraverseDecl(TU);
+    functionAnalyzer.setFunctionLoops(loopAnalyzer.takeAllFunctionLoops());
+    
+    size_t functions = functionAnalyzer.functionInfo.size();
+    programIndex().addTranslationUnit(inputFileName, std::move(functionAnalyzer.functionInfo),
+                                      functionAnalyzer.functionAnalysis);
+    llvm::outs() << "Summarized " << inputFileName << ": " << functions << " functions\n";
+}
+
+std::unique_ptr<ASTConsumer> ProgramSummaryAction::CreateASTConsumer(CompilerInstance &CI,
+                                                                    llvm::StringRef file) {
+    return std::make_unique<ProgramSummaryConsumer>(CI, file.str());
 }
\ No newline at end of file
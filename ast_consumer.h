@@ -6,6 +6,8 @@
 #include "loop_analyzer.h"
 #include "main_extractor.h"
 #include "hybrid_parallelizer.h"
+#include "phase_profiler.h"
+#include "program_index.h"
 
 #include "clang/AST/ASTConsumer.h"
 #include "clang/Frontend/FrontendActions.h"
@@ -22,6 +24,7 @@ public:
     
     bool VisitTypedefDecl(clang::TypedefDecl *TD);
     bool VisitTypeAliasDecl(clang::TypeAliasDecl *TAD);  // For 'using' aliases
+    bool VisitCXXRecordDecl(clang::CXXRecordDecl *RD);   // Struct definitions and their layout
     
 private:
     std::string getSourceText(clang::SourceRange range);
@@ -36,6 +39,7 @@ private:
     MainFunctionExtractor mainExtractor;
     ComprehensiveLoopAnalyzer loopAnalyzer;
     TypedefCollector typedefCollector;  // NEW: Typedef collector
+    PhaseProfiler phases;               // --time-phases / --time-trace
     
 public:
     HybridParallelizerConsumer(clang::CompilerInstance &CI, const std::string &inputFile);
@@ -46,8 +50,11 @@ private:
     void printEnhancedAnalysisResults(const HybridParallelizer& parallelizer);
     void generateDependencyGraphVisualization(const HybridParallelizer& parallelizer);
     void generateGraphvizDependencyGraph(const HybridParallelizer& parallelizer);
+    void generateJsonReport(const HybridParallelizer& parallelizer);  // --report=json
     std::string extractOriginalIncludes(clang::ASTContext &Context);
     std::string generateOutputFileName() const;  // Generate output filename from input
+    std::string generateReportFileName() const;  // <input>_report.json
+    std::string inputBaseName() const;           // Input filename without directory and extension
 };
 
 class HybridParallelizerAction : public clang::ASTFrontendAction {
@@ -56,4 +63,26 @@ public:
                                                          llvm::StringRef file) override;
 };
 
+// --whole-program first pass: function and loop summaries of one translation unit
+// go to the program index, nothing is generated
+class ProgramSummaryConsumer : public clang::ASTConsumer {
+private:
+    clang::CompilerInstance &CI;
+    std::string inputFileName;
+    GlobalVariableCollector globalCollector;
+    ComprehensiveFunctionAnalyzer functionAnalyzer;
+    ComprehensiveLoopAnalyzer loopAnalyzer;
+    
+public:
+    ProgramSummaryConsumer(clang::CompilerInstance &CI, const std::string &inputFile);
+    
+    void HandleTranslationUnit(clang::ASTContext &Context) override;
+};
+
+class ProgramSummaryAction : public clang::ASTFrontendAction {
+public:
+    std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(clang::CompilerInstance &CI,
+                                                         llvm::StringRef file) override;
+};
+
 #endif // AST_CONSUMER_H
\ No newline at end of file
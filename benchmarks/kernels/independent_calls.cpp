@@ -0,0 +1,50 @@
+#include <cmath>
+#include <cstdio>
+
+double integrate_sin(int n) {
+    double h = 3.141592653589793 / n;
+    double area = 0.0;
+    for (int i = 0; i < n; i++) {
+        area += sin((i + 0.5) * h) * h;
+    }
+    return area;
+}
+
+double harmonic(int n) {
+    double sum = 0.0;
+    for (int i = 1; i <= n; i++) {
+        sum += 1.0 / i;
+    }
+    return sum;
+}
+
+long long count_primes(int limit) {
+    long long count = 0;
+    for (int i = 2; i < limit; i++) {
+        int prime = 1;
+        for (int d = 2; d * d <= i; d++) {
+            if (i % d == 0) {
+                prime = 0;
+                break;
+            }
+        }
+        count += prime;
+    }
+    return count;
+}
+
+double combine(double a, double b) {
+    return a * 1000.0 + b;
+}
+
+int main() {
+    double area = integrate_sin(30000000);
+    double h = harmonic(60000000);
+    long long primes = count_primes(3000000);
+    double combined = combine(area, h);
+    printf("%.6e\n", area);
+    printf("%.6e\n", h);
+    printf("%lld\n", primes);
+    printf("%.6e\n", combined);
+    return 0;
+}
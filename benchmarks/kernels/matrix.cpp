@@ -0,0 +1,55 @@
+#include <cstdio>
+#include <vector>
+
+double matmul_trace(int n) {
+    std::vector<double> a(n * n), b(n * n), c(n * n);
+    for (int i = 0; i < n * n; i++) {
+        a[i] = (i % 17) * 0.5;
+        b[i] = (i % 13) * 0.25;
+    }
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < n; k++) {
+            double aik = a[i * n + k];
+            for (int j = 0; j < n; j++) {
+                c[i * n + j] += aik * b[k * n + j];
+            }
+        }
+    }
+    double trace = 0.0;
+    for (int i = 0; i < n; i++) {
+        trace += c[i * n + i];
+    }
+    return trace;
+}
+
+double matvec_norm(int n, int reps) {
+    std::vector<double> m(n * n), x(n), y(n);
+    for (int i = 0; i < n * n; i++) {
+        m[i] = ((i * 7) % 11) * 0.1;
+    }
+    for (int i = 0; i < n; i++) {
+        x[i] = 1.0 / (i + 1);
+    }
+    double norm = 0.0;
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < n; i++) {
+            double s = 0.0;
+            for (int j = 0; j < n; j++) {
+                s += m[i * n + j] * x[j];
+            }
+            y[i] = s;
+        }
+        for (int i = 0; i < n; i++) {
+            norm += y[i] * y[i];
+        }
+    }
+    return norm;
+}
+
+int main() {
+    double trace = matmul_trace(700);
+    double norm = matvec_norm(3000, 20);
+    printf("%.6e\n", trace);
+    printf("%.6e\n", norm);
+    return 0;
+}
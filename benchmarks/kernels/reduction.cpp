@@ -0,0 +1,26 @@
+#include <cmath>
+#include <cstdio>
+
+double series_sum(int n) {
+    double sum = 0.0;
+    for (int i = 1; i <= n; i++) {
+        sum += sqrt((double)i) * sin(i * 0.001) + log((double)i);
+    }
+    return sum;
+}
+
+long long count_multiples(int n) {
+    long long count = 0;
+    for (int i = 1; i <= n; i++) {
+        count += (i % 3 == 0 || i % 7 == 0) ? 1 : 0;
+    }
+    return count;
+}
+
+int main() {
+    double sum = series_sum(40000000);
+    long long count = count_multiples(80000000);
+    printf("%.6e\n", sum);
+    printf("%lld\n", count);
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include <cstdio>
+#include <vector>
+
+double jacobi(int n, int steps) {
+    std::vector<double> a(n), b(n);
+    for (int i = 0; i < n; i++) {
+        a[i] = (i % 100) * 0.01;
+    }
+    for (int t = 0; t < steps; t++) {
+        for (int i = 1; i < n - 1; i++) {
+            b[i] = (a[i - 1] + a[i] + a[i + 1]) / 3.0;
+        }
+        for (int i = 1; i < n - 1; i++) {
+            a[i] = b[i];
+        }
+    }
+    double checksum = 0.0;
+    for (int i = 0; i < n; i++) {
+        checksum += a[i];
+    }
+    return checksum;
+}
+
+int main() {
+    double checksum = jacobi(4000000, 40);
+    printf("%.6e\n", checksum);
+    return 0;
+}
@@ -0,0 +1,345 @@
+// Speedup benchmarks for the generated hybrid code. Every kernel in the corpus is
+// run through mpi-parallelizer, the original and the generated program are both
+// compiled, and the generated one is timed over a matrix of MPI rank and OpenMP
+// thread counts with mpirun on localhost. Each run must reproduce the sequential
+// output; speedup and efficiency are reported per configuration, and compared
+// against a saved baseline to catch regressions in the generated code.
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct BenchmarkOptions {
+    std::string parallelizer = "./mpi-parallelizer";
+    std::string kernels = "benchmarks/kernels";
+    std::string workDir = "benchmark_work";
+    std::string cxx = "g++";
+    std::string mpicxx = "mpicxx";
+    std::string mpirun = "mpirun --oversubscribe";
+    std::string flags = "-O2 -std=c++17";
+    std::vector<int> ranks = {1, 2, 4};
+    std::vector<int> threads = {1, 2, 4};
+    int repeat = 3;
+    double tolerance = 1e-6;       // Relative difference allowed between numeric outputs
+    std::string csv;               // Write results here
+    std::string baseline;          // Compare speedups against this earlier CSV
+    double maxRegression = 0.15;   // Allowed relative speedup loss against the baseline
+};
+
+struct RunResult {
+    bool ok = false;
+    double seconds = 0.0;
+    std::string output;
+};
+
+struct Measurement {
+    std::string kernel;
+    int ranks = 0;
+    int threads = 0;
+    double seconds = 0.0;
+    double speedup = 0.0;
+    double efficiency = 0.0;
+    std::string status;            // "ok" or why the configuration failed
+};
+
+static std::vector<int> parseCounts(const std::string& list) {
+    std::vector<int> counts;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int value = std::atoi(item.c_str());
+        if (value > 0) counts.push_back(value);
+    }
+    return counts;
+}
+
+static std::string shellQuote(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        if (c == '\'') quoted += "'\\''";
+        else quoted += c;
+    }
+    return quoted + "'";
+}
+
+// Run a shell command, capturing stdout; stderr goes to the given log file
+static RunResult runCommand(const std::string& command, const std::string& logFile) {
+    RunResult result;
+    std::string full = command + " 2>>" + shellQuote(logFile);
+    auto start = std::chrono::steady_clock::now();
+    FILE* pipe = popen(full.c_str(), "r");
+    if (!pipe) return result;
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+        result.output.append(buffer, n);
+    }
+    int status = pclose(pipe);
+    auto end = std::chrono::steady_clock::now();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.ok = status == 0;
+    return result;
+}
+
+// Median wall time of several runs; the output of the first run is kept
+static RunResult timeCommand(const std::string& command, const std::string& logFile, int repeat) {
+    RunResult first;
+    std::vector<double> times;
+    for (int r = 0; r < repeat; r++) {
+        RunResult run = runCommand(command, logFile);
+        if (!run.ok) return run;
+        if (r == 0) first = run;
+        times.push_back(run.seconds);
+    }
+    std::sort(times.begin(), times.end());
+    first.seconds = times[times.size() / 2];
+    return first;
+}
+
+static std::vector<std::string> splitLines(const std::string& text) {
+    std::vector<std::string> lines;
+    std::stringstream stream(text);
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static bool parseNumber(const std::string& token, double& value) {
+    const char* begin = token.c_str();
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtod(begin, &end);
+    return end != begin && *end == '\0' && errno == 0;
+}
+
+// Tokens agree exactly, or as numbers within the relative tolerance (reductions
+// are summed in a different order once they run in parallel)
+static bool sameLine(const std::string& expected, const std::string& actual, double tolerance) {
+    std::stringstream a(expected), b(actual);
+    std::string x, y;
+    while (true) {
+        bool moreA = static_cast<bool>(a >> x);
+        bool moreB = static_cast<bool>(b >> y);
+        if (!moreA || !moreB) return moreA == moreB;
+        if (x == y) continue;
+        double u, v;
+        if (!parseNumber(x, u) || !parseNumber(y, v)) return false;
+        double scale = std::max(std::fabs(u), std::fabs(v));
+        if (std::fabs(u - v) > tolerance * std::max(scale, 1.0)) return false;
+    }
+}
+
+// Every line the sequential program prints must appear, in order, in the
+// generated program's output; lines the generated code adds are skipped
+static bool outputsMatch(const std::string& expected, const std::string& actual, double tolerance) {
+    std::vector<std::string> want = splitLines(expected);
+    std::vector<std::string> got = splitLines(actual);
+    size_t next = 0;
+    for (const auto& line : want) {
+        while (next < got.size() && !sameLine(line, got[next], tolerance)) next++;
+        if (next == got.size()) return false;
+        next++;
+    }
+    return true;
+}
+
+static std::map<std::tuple<std::string, int, int>, double> readBaseline(const std::string& path) {
+    std::map<std::tuple<std::string, int, int>, double> speedups;
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);  // Header
+    while (std::getline(file, line)) {
+        std::stringstream stream(line);
+        std::string kernel, ranks, threads, seconds, speedup;
+        if (std::getline(stream, kernel, ',') && std::getline(stream, ranks, ',') &&
+            std::getline(stream, threads, ',') && std::getline(stream, seconds, ',') &&
+            std::getline(stream, speedup, ',')) {
+            speedups[{kernel, std::atoi(ranks.c_str()), std::atoi(threads.c_str())}] = std::atof(speedup.c_str());
+        }
+    }
+    return speedups;
+}
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --parallelizer PATH   mpi-parallelizer executable (default ./mpi-parallelizer)\n"
+              << "  --kernels DIR         Kernel corpus (default benchmarks/kernels)\n"
+              << "  --work DIR            Build and output directory (default benchmark_work)\n"
+              << "  --ranks LIST          MPI rank counts, comma separated (default 1,2,4)\n"
+              << "  --threads LIST        OpenMP thread counts, comma separated (default 1,2,4)\n"
+              << "  --repeat N            Runs per configuration, the median is reported (default 3)\n"
+              << "  --tolerance X         Relative tolerance for numeric output (default 1e-6)\n"
+              << "  --mpirun CMD          Launcher (default \"mpirun --oversubscribe\")\n"
+              << "  --cxx CMD, --mpicxx CMD, --flags FLAGS\n"
+              << "  --csv FILE            Write the results as CSV\n"
+              << "  --baseline FILE       Fail when a speedup drops below an earlier CSV\n"
+              << "  --max-regression X    Allowed relative speedup loss (default 0.15)\n";
+}
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << "\n";
+            printUsage(argv[0]);
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--parallelizer") options.parallelizer = value;
+        else if (arg == "--kernels") options.kernels = value;
+        else if (arg == "--work") options.workDir = value;
+        else if (arg == "--ranks") options.ranks = parseCounts(value);
+        else if (arg == "--threads") options.threads = parseCounts(value);
+        else if (arg == "--repeat") options.repeat = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--tolerance") options.tolerance = std::atof(value.c_str());
+        else if (arg == "--mpirun") options.mpirun = value;
+        else if (arg == "--cxx") options.cxx = value;
+        else if (arg == "--mpicxx") options.mpicxx = value;
+        else if (arg == "--flags") options.flags = value;
+        else if (arg == "--csv") options.csv = value;
+        else if (arg == "--baseline") options.baseline = value;
+        else if (arg == "--max-regression") options.maxRegression = std::atof(value.c_str());
+        else {
+            std::cerr << "Unknown option " << arg << "\n";
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<fs::path> kernels;
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(options.kernels, error)) {
+        if (entry.path().extension() == ".cpp") kernels.push_back(fs::absolute(entry.path()));
+    }
+    std::sort(kernels.begin(), kernels.end());
+    if (kernels.empty()) {
+        std::cerr << "No kernels found in " << options.kernels << "\n";
+        return 2;
+    }
+
+    std::string parallelizer = fs::absolute(options.parallelizer).string();
+    std::vector<Measurement> measurements;
+    bool failed = false;
+
+    for (const auto& kernel : kernels) {
+        std::string name = kernel.stem().string();
+        fs::path dir = fs::absolute(fs::path(options.workDir) / name);
+        fs::create_directories(dir);
+        std::string log = (dir / "benchmark.log").string();
+        std::ofstream(log, std::ios::trunc).close();
+        std::string cd = "cd " + shellQuote(dir.string()) + " && ";
+        std::cout << "== " << name << std::endl;
+
+        auto fail = [&](const std::string& status) {
+            measurements.push_back({name, 0, 0, 0.0, 0.0, 0.0, status});
+            std::cout << "   " << status << " (see " << log << ")" << std::endl;
+            failed = true;
+        };
+
+        // The parallelizer writes <stem>_parallelized.cpp into its working directory;
+        // a file left over from an earlier run must not hide a failure
+        fs::path hybridSource = dir / (name + "_parallelized.cpp");
+        fs::remove(hybridSource);
+        RunResult generated = runCommand(cd + shellQuote(parallelizer) + " " + shellQuote(kernel.string()) + " >/dev/null", log);
+        if (!generated.ok || !fs::exists(hybridSource)) {
+            fail("parallelizer failed");
+            continue;
+        }
+
+        RunResult buildSeq = runCommand(cd + options.cxx + " " + options.flags + " " + shellQuote(kernel.string()) +
+                                        " -o sequential -lm", log);
+        RunResult buildHybrid = runCommand(cd + options.mpicxx + " " + options.flags + " -fopenmp " +
+                                           shellQuote(hybridSource.string()) + " -o hybrid -lm", log);
+        if (!buildSeq.ok || !buildHybrid.ok) {
+            fail(buildSeq.ok ? "generated code does not compile" : "kernel does not compile");
+            continue;
+        }
+
+        RunResult sequential = timeCommand(cd + "./sequential", log, options.repeat);
+        if (!sequential.ok) {
+            fail("sequential run failed");
+            continue;
+        }
+        measurements.push_back({name, 0, 0, sequential.seconds, 1.0, 1.0, "ok"});
+
+        for (int ranks : options.ranks) {
+            for (int threads : options.threads) {
+                std::string command = cd + "OMP_NUM_THREADS=" + std::to_string(threads) + " " + options.mpirun +
+                                      " -np " + std::to_string(ranks) + " ./hybrid";
+                RunResult run = timeCommand(command, log, options.repeat);
+                Measurement m{name, ranks, threads, run.seconds, 0.0, 0.0, "ok"};
+                if (!run.ok) {
+                    m.status = "run failed";
+                } else if (!outputsMatch(sequential.output, run.output, options.tolerance)) {
+                    m.status = "output differs";
+                    std::ofstream(dir / ("output_np" + std::to_string(ranks) + "_t" + std::to_string(threads) + ".txt"))
+                        << run.output;
+                } else {
+                    m.speedup = sequential.seconds / run.seconds;
+                    m.efficiency = m.speedup / (ranks * threads);
+                }
+                if (m.status != "ok") failed = true;
+                measurements.push_back(m);
+            }
+        }
+    }
+
+    // Speedup against the baseline run, where one exists for the configuration
+    std::map<std::tuple<std::string, int, int>, double> baseline;
+    if (!options.baseline.empty()) baseline = readBaseline(options.baseline);
+
+    std::cout << "\n" << std::left << std::setw(20) << "kernel" << std::right << std::setw(6) << "ranks"
+              << std::setw(8) << "threads" << std::setw(11) << "time [s]" << std::setw(9) << "speedup"
+              << std::setw(12) << "efficiency" << "  status" << std::endl;
+    std::cout << std::string(76, '-') << std::endl;
+    for (auto& m : measurements) {
+        if (m.status == "ok" && m.ranks > 0) {
+            auto previous = baseline.find({m.kernel, m.ranks, m.threads});
+            if (previous != baseline.end() && m.speedup < previous->second * (1.0 - options.maxRegression)) {
+                std::ostringstream status;
+                status << std::fixed << std::setprecision(2) << "regressed from " << previous->second << "x";
+                m.status = status.str();
+                failed = true;
+            }
+        }
+        std::cout << std::left << std::setw(20) << m.kernel << std::right;
+        if (m.ranks == 0) std::cout << std::setw(6) << "seq" << std::setw(8) << "-";
+        else std::cout << std::setw(6) << m.ranks << std::setw(8) << m.threads;
+        std::cout << std::fixed << std::setprecision(3) << std::setw(11) << m.seconds
+                  << std::setprecision(2) << std::setw(9) << m.speedup << std::setw(12) << m.efficiency
+                  << "  " << m.status << std::endl;
+    }
+
+    if (!options.csv.empty()) {
+        std::ofstream csv(options.csv);
+        csv << "kernel,ranks,threads,seconds,speedup,efficiency,status\n";
+        for (const auto& m : measurements) {
+            csv << m.kernel << "," << m.ranks << "," << m.threads << "," << m.seconds << ","
+                << m.speedup << "," << m.efficiency << "," << m.status << "\n";
+        }
+    }
+
+    return failed ? 1 : 0;
+}
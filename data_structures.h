@@ -5,21 +5,73 @@
 #include <vector>
 #include <set>
 #include <map>
+#include "symbol_table.h"
+
+// Histogram-style update A[idx] op= v through a computed subscript
+struct ArrayReduction {
+    std::string name;                    // Array or std::vector variable
+    std::string op;                      // Reduction operator ("+", "*", "&", "|", "^")
+    std::string element_type;            // Canonical element type
+    std::string length_expr;             // Element count, empty when unknown (pointer parameters)
+    bool is_container = false;           // std::vector - data() gives the buffer
+    bool use_atomic = false;             // Too large or unsized for a private copy per thread
+};
+
+// Prefix sum carried by an inscan reduction. Running sums (sum += e; out[i] = sum;)
+// scan an existing variable; recurrences (a[i] = a[i-1] + e) get a fresh accumulator.
+struct PrefixScan {
+    std::string var;                     // Accumulator of reduction(inscan, ...)
+    std::string type;                    // Accumulator type
+    std::string op = "+";                // Combining operator
+    bool exclusive = false;              // Reads see the value from before this iteration's update
+    unsigned split_offset = 0;           // Running sum: body offset where "#pragma omp scan" goes
+    std::string array;                   // Recurrence: array rebuilt from the accumulator
+    std::string target;                  // Recurrence: element written each iteration ("a[i]")
+    std::string update_expr;             // Contribution of one iteration
+    bool update_pure = false;            // Contribution can be evaluated twice, outside the body (MPI block sums)
+};
+
+// Array of structs read field by field at the loop index (v[i].x). With --soa the
+// touched fields are gathered into one contiguous array each before the enclosing
+// repeat loop (a time-step loop) and scattered back after it.
+struct SoAField {
+    std::string name;                    // Field name
+    std::string type;                    // Field type
+    bool written = false;                // Scattered back into the structs after the loop
+};
+
+struct SoACandidate {
+    std::string container;               // Array or std::vector of structs
+    std::string length_expr;             // Element count ("N" or "v.size()")
+    std::vector<SoAField> fields;        // Fields the loop touches, in declaration order
+    unsigned total_fields = 0;           // Fields of the struct
+    std::vector<std::pair<unsigned, unsigned>> access_ranges; // [offset, length) of each v[i].f in the loop body
+    std::vector<std::string> access_fields;                   // Field named by each access range
+};
+
+// Side-effect-free expression with the same value in every iteration (sqrt(n), v.size())
+struct LoopInvariant {
+    std::string expr;                    // Source text
+    std::vector<std::pair<unsigned, unsigned>> ranges; // [offset, length) of each occurrence, from the body start
+};
 
 // Structure to hold loop information for OpenMP parallelization
 struct LoopInfo {
     std::string type;                    // "for", "while", "do-while"
     std::string source_code;             // Original loop source
+    size_t function_offset = std::string::npos;  // Loop start within its function body ('{' at 0)
     std::string loop_variable;           // Loop iterator variable
     std::string loop_variable_type;      // NEW: Type of loop variable (e.g., "int")
-    std::vector<std::string> read_vars;  // Variables read in loop
-    std::vector<std::string> write_vars; // Variables written in loop
+    SymbolSet read_vars;                 // Variables read in loop
+    SymbolSet write_vars;                // Variables written in loop
     std::vector<std::string> reduction_vars; // Reduction variables
+    std::map<std::string, std::string> reduction_var_types; // Canonical type of each reduction variable
     std::string reduction_op;            // Reduction operation (+, *, etc.)
     bool has_dependencies;               // Loop-carried dependencies
     bool has_function_calls;             // Contains function calls
     bool has_io_operations;              // Contains I/O operations
-    bool has_break_continue;             // Contains break/continue statements
+    bool has_break_continue;             // Contains a break that leaves the loop (continue is harmless)
+    bool has_early_return = false;       // Contains return/goto that leaves the loop
     bool has_complex_condition;          // Complex loop condition (&&, ||)
     bool is_nested;                      // Is a nested loop
     bool has_thread_unsafe_calls;        // Contains thread-unsafe function calls
@@ -35,10 +87,64 @@ struct LoopInfo {
     
     // NEW: Fields for MPI loop parallelization
     std::string start_expr;              // Loop start expression (e.g., "0")
-    std::string end_expr;                // Loop end expression (e.g., "N")
+    std::string end_expr;                // Loop end expression, exclusive (e.g., "N", "(N) + 1" for i <= N)
     std::string step_expr;               // Loop step expression (e.g., "1")
     bool is_mpi_parallelizable;          // Can be parallelized with MPI
     bool is_canonical;                   // Is in canonical form (for(i=start; i<end; i+=step))
+    
+    bool declares_loop_variable = false; // Induction variable is declared in the for-init
+    
+    // Iteration-space inference for while/do-while loops (end_expr is exclusive)
+    std::string body_source;             // Loop body (while loops: with the induction update removed)
+    bool is_search_loop = false;         // Early-exit search run speculatively with omp cancel
+    std::vector<std::pair<unsigned, unsigned>> exit_ranges; // [offset, length) of the loop's own break/return in body_source
+    std::vector<std::string> exit_vars;  // Variables written only right before a break
+    
+    // Privatization: def-before-use per iteration for variables declared outside the loop
+    std::vector<std::string> private_vars;       // Written before read in every iteration, dead after the loop
+    std::vector<std::string> firstprivate_vars;  // Partly overwritten arrays, the rest keeps its value from before the loop
+    std::vector<std::string> lastprivate_vars;   // Temporaries whose final value is used after the loop
+    std::vector<std::string> carried_scalars;    // Read before written - value flows between iterations
+    
+    // Indirect updates through computed subscripts (histograms, scatter-add)
+    unsigned body_offset = 0;                    // Offset of the loop body within source_code
+    std::vector<ArrayReduction> array_reductions;
+    std::vector<unsigned> atomic_offsets;        // Body offsets of updates guarded by omp atomic
+    std::vector<std::string> conflicting_arrays; // Indirectly updated and also accessed otherwise
+    
+    // Prefix sums run as omp scan (MPI_Exscan across ranks)
+    bool is_scan_loop = false;
+    PrefixScan scan;
+    
+    // Array-of-structs accesses that a structure-of-arrays copy would make unit-stride
+    std::vector<SoACandidate> soa_candidates;
+    size_t soa_copy_offset = std::string::npos;  // Enclosing repeat loop the copies go around (function body offset)
+    size_t soa_copy_length = 0;                  // Its length, including a do-while's ';'
+    
+    // Body only stores array elements at the loop index (a[i] = expr) - the loop that
+    // first touches the pages, parallelized in main under NUMA mode
+    bool is_array_init = false;
+    
+    // Invariant expressions the MPI split evaluates once in its preamble
+    std::vector<LoopInvariant> invariants;
+    
+    // rand() calls, drawn from a counter-based generator keyed by the iteration
+    std::vector<std::pair<unsigned, unsigned>> rand_ranges; // [offset, length) within the body
+};
+
+// Recursive self-call inside a function body, used for task parallelism.
+// All offsets are byte offsets relative to the opening '{' of the body.
+struct RecursiveCallSite {
+    unsigned call_start_offset;          // Start of the call expression
+    unsigned call_end_offset;            // Offset of the call's closing ')'
+    unsigned callee_offset;              // Start of the callee name token
+    unsigned stmt_start_offset;          // Start of the enclosing statement
+    unsigned num_args;                   // Number of call arguments
+    std::string form;                    // "expr", "assign", "decl", "return" or "inline"
+    std::string result_variable;         // Variable receiving the result (assign/decl)
+    std::string result_type;             // Type of the call result
+    int task_group;                      // Task group index, -1 if the call stays inline
+    bool unbraced_branch = false;        // "return" form: the whole branch of an if/else or loop, not in a block
 };
 
 // Structure to hold function information with loops
@@ -52,11 +158,20 @@ struct FunctionInfo {
     std::string complete_function_source;   // NEW: Complete function source code including signature
     std::string function_signature;         // NEW: Just the function signature
     std::vector<LoopInfo> loops;
-    std::set<std::string> global_reads;
-    std::set<std::string> global_writes;
-    std::set<std::string> local_vars;
+    SymbolSet global_reads;
+    SymbolSet global_writes;
+    SymbolSet local_vars;
     bool has_parallelizable_loops;
     unsigned start_line, end_line;
+    std::string defined_in;                  // Other translation unit defining it (--whole-program), empty if local
+    bool external_linkage = true;            // Not static or in an anonymous namespace
+    
+    // Recursion analysis for OpenMP task parallelism
+    bool is_recursive = false;               // Function calls itself directly
+    bool has_task_parallelism = false;       // Independent recursive calls can become tasks
+    int num_task_groups = 0;                 // Number of call groups joined by a taskwait
+    std::vector<RecursiveCallSite> recursive_calls; // All self-calls, ordered by offset
+    std::string task_notes;                  // Why tasks were (not) generated
 };
 
 // Structure to hold function call information
@@ -67,8 +182,9 @@ struct FunctionCall {
     bool hasReturnValue;
     std::string returnVariable;
     std::string returnType;
+    std::string canonicalReturnType;  // Typedefs resolved (size_t -> unsigned long), picks the MPI datatype
     std::vector<std::string> parameterVariables;
-    std::set<std::string> usedLocalVariables;
+    SymbolSet usedLocalVariables;
     
     // NEW: Source location information for precise text replacement
     unsigned startColumn;           // Column where statement starts (1-based)
@@ -85,12 +201,14 @@ struct GlobalVariable {
     std::string defaultValue;
     bool isArray;
     std::string arraySize;
+    bool isExtern = false;  // Only declared here (extern), defined in another unit
 };
 
 // Structure to hold local variable information
 struct LocalVariable {
     std::string name;
     std::string type;
+    std::string canonicalType;        // Typedefs resolved, picks the MPI datatype
     std::string initializationValue;  // Store the original initialization expression
     std::string completeDeclaration;  // NEW: Complete variable declaration from source
     bool hasComplexInitialization;    // NEW: Flag for complex C++11 initializations
@@ -102,11 +220,12 @@ struct LocalVariable {
 
 // Structure to hold function analysis results
 struct FunctionAnalysis {
-    std::set<std::string> readSet;
-    std::set<std::string> writeSet;
-    std::set<std::string> localReads;
-    std::set<std::string> localWrites;
+    SymbolSet readSet;
+    SymbolSet writeSet;
+    SymbolSet localReads;
+    SymbolSet localWrites;
     bool isParallelizable = true;
+    bool isPure = false;            // Result depends only on the arguments, no side effects
     std::string returnType;
     std::vector<std::string> parameterTypes;
 };
@@ -115,9 +234,10 @@ struct FunctionAnalysis {
 struct DependencyNode {
     std::string functionName;
     int callIndex;
-    std::set<int> dependencies;
-    std::set<int> dependents;
+    std::vector<int> dependencies;           // Earlier calls this one waits for, ascending
+    std::vector<int> dependents;             // Later calls waiting for this one, ascending
     std::string dependencyReason;
+    std::vector<std::string> edgeReasons;    // Reason of each incoming edge, parallel to dependencies
 };
 
 // NEW: Structure to hold typedef information
@@ -128,10 +248,27 @@ struct TypedefInfo {
     unsigned line;              // Line number in source
 };
 
+// Field of a struct as MPI_Type_create_struct sees it
+struct RecordField {
+    std::string name;
+    std::string type;           // Canonical type, the element type for array fields
+    unsigned count = 1;         // Elements of an array field
+};
+
+// Struct or class defined at file scope in the main file
+struct RecordInfo {
+    std::string name;
+    std::string definition;     // Complete definition without the trailing ';'
+    unsigned line;              // Line number in source
+    bool transferable = false;  // Trivially copyable with scalar fields - sent with an MPI struct type
+    std::vector<RecordField> fields;
+};
+
 // NEW: Structure to hold complete source code context
 struct SourceCodeContext {
     std::vector<std::string> includes;          // All #include statements
     std::vector<TypedefInfo> typedefs;          // All typedef statements
+    std::vector<RecordInfo> records;            // Struct and class definitions
     std::vector<std::string> globalDeclarations; // Global variable declarations
     std::string namespaceDeclarations;          // using namespace statements
     std::vector<std::string> forwardDeclarations; // Forward declarations
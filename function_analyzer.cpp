@@ -2,6 +2,7 @@
 #include "clang/Lex/Lexer.h"
 #include <set>
 #include <algorithm>
+#include <cctype>
 
 using namespace clang;
 
@@ -22,6 +23,7 @@ bool GlobalVariableCollector::VisitVarDecl(VarDecl *VD) {
             
             // Check for arrays
             gv.isArray = VD->getType()->isArrayType();
+            gv.isExtern = VD->hasExternalStorage() && VD->hasDefinition() == VarDecl::DeclarationOnly;
             if (gv.isArray) {
                 if (auto CAT = dyn_cast<ConstantArrayType>(VD->getType().getTypePtr())) {
                     gv.arraySize = std::to_string(CAT->getSize().getZExtValue());
@@ -52,29 +54,29 @@ void ComprehensiveFunctionAnalyzer::setSourceManager(SourceManager *sourceManage
     SM = sourceManager;
 }
 
-void ComprehensiveFunctionAnalyzer::setFunctionLoops(const std::map<std::string, std::vector<LoopInfo>>& functionLoops) {
+void ComprehensiveFunctionAnalyzer::setFunctionLoops(std::map<std::string, std::vector<LoopInfo>>&& functionLoops) {
     // Add loop information to function info, removing duplicates
-    for (const auto& pair : functionLoops) {
+    for (auto& pair : functionLoops) {
         const std::string& funcName = pair.first;
-        const std::vector<LoopInfo>& loops = pair.second;
+        std::vector<LoopInfo>& loops = pair.second;
         
         if (functionInfo.count(funcName)) {
             // Remove duplicates based on start line and column
             std::vector<LoopInfo> uniqueLoops;
             std::set<std::string> processedLoops;
             
-            for (const auto& loop : loops) {
+            for (auto& loop : loops) {
                 std::string loopKey = std::to_string(loop.start_line) + "_" + std::to_string(loop.start_col) + "_" + loop.type;
                 if (processedLoops.find(loopKey) == processedLoops.end()) {
-                    uniqueLoops.push_back(loop);
                     processedLoops.insert(loopKey);
+                    uniqueLoops.push_back(std::move(loop));
                 }
             }
             
-            functionInfo[funcName].loops = uniqueLoops;
+            functionInfo[funcName].loops = std::move(uniqueLoops);
             functionInfo[funcName].has_parallelizable_loops = false;
             
-            for (const auto& loop : uniqueLoops) {
+            for (const auto& loop : functionInfo[funcName].loops) {
                 if (loop.parallelizable) {
                     functionInfo[funcName].has_parallelizable_loops = true;
                     break;
@@ -111,6 +113,7 @@ bool ComprehensiveFunctionAnalyzer::VisitFunctionDecl(FunctionDecl *FD) {
         // Create function info
         FunctionInfo info;
         info.name = currentFunction;
+        info.external_linkage = FD->hasExternalFormalLinkage();
         
         QualType returnQType = FD->getReturnType();
         std::string returnTypeStr = returnQType.getAsString();
@@ -178,6 +181,10 @@ bool ComprehensiveFunctionAnalyzer::VisitFunctionDecl(FunctionDecl *FD) {
         functionInfo[currentFunction] = info;
         
         TraverseStmt(FD->getBody());
+        
+        // Detect divide-and-conquer recursion once global reads/writes are known
+        analyzeRecursion(FD);
+        analyzePurity(FD);
     }
     return true;
 }
@@ -244,40 +251,6 @@ std::string ComprehensiveFunctionAnalyzer::generateParallelizedFunction(const st
     
     std::string parallelizedBody = info.original_body;
     
-    // First, replace thread-unsafe function calls with thread-safe alternatives
-    for (const auto& loop : info.loops) {
-        if (loop.has_thread_unsafe_calls) {
-            for (const auto& unsafeFunc : loop.unsafe_functions) {
-                if (unsafeFunc == "rand") {
-                    // Replace rand() with rand_r(&__thread_seed)
-                    size_t pos = 0;
-                    while ((pos = parallelizedBody.find("rand()", pos)) != std::string::npos) {
-                        parallelizedBody.replace(pos, 6, "rand_r(&__thread_seed)");
-                        pos += 20; // Length of "rand_r(&__thread_seed)"
-                    }
-                }
-            }
-        }
-    }
-    
-    // Add thread-local variable declarations at the beginning of function
-    bool needsThreadSeed = false;
-    for (const auto& loop : info.loops) {
-        if (loop.thread_local_vars.count("__thread_seed")) {
-            needsThreadSeed = true;
-            break;
-        }
-    }
-    
-    if (needsThreadSeed) {
-        // Insert thread-local seed declaration after opening brace
-        size_t bracePos = parallelizedBody.find('{');
-        if (bracePos != std::string::npos) {
-            std::string seedDecl = "\n    unsigned int __thread_seed = (unsigned int)time(NULL) ^ omp_get_thread_num();";
-            parallelizedBody.insert(bracePos + 1, seedDecl);
-        }
-    }
-    
     // Insert OpenMP pragmas before parallelizable loops
     for (const auto& loop : info.loops) {
         if (loop.parallelizable && !loop.pragma_text.empty()) {
@@ -305,6 +278,510 @@ std::string ComprehensiveFunctionAnalyzer::generateParallelizedFunction(const st
     return parallelizedBody;
 }
 
+// Check whether an expression is a direct call to the given (canonical) function
+static CallExpr *asSelfCall(Expr *E, const FunctionDecl *self) {
+    if (!E) return nullptr;
+    if (CallExpr *CE = dyn_cast<CallExpr>(E->IgnoreImplicit())) {
+        if (FunctionDecl *callee = CE->getDirectCallee()) {
+            if (callee->getCanonicalDecl() == self) {
+                return CE;
+            }
+        }
+    }
+    return nullptr;
+}
+
+// Collect the names of all variables referenced inside a statement
+static void collectReferencedVariables(const Stmt *S, std::set<std::string> &vars) {
+    if (!S) return;
+    if (const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(S)) {
+        if (const VarDecl *VD = dyn_cast<VarDecl>(DRE->getDecl())) {
+            vars.insert(VD->getNameAsString());
+        }
+    }
+    for (const Stmt *child : S->children()) {
+        collectReferencedVariables(child, vars);
+    }
+}
+
+// Collect self-calls of a return expression that are evaluated unconditionally.
+// Calls under ?:, && or || are skipped because hoisting them would change semantics.
+static void collectUnconditionalSelfCalls(Stmt *S, const FunctionDecl *self, std::vector<CallExpr*> &calls) {
+    if (!S) return;
+    if (isa<AbstractConditionalOperator>(S)) return;
+    if (BinaryOperator *BO = dyn_cast<BinaryOperator>(S)) {
+        if (BO->isLogicalOp()) return;
+    }
+    if (Expr *E = dyn_cast<Expr>(S)) {
+        if (CallExpr *CE = asSelfCall(E, self)) {
+            calls.push_back(CE);
+            return; // Nested self-calls in the arguments stay inline
+        }
+    }
+    for (Stmt *child : S->children()) {
+        collectUnconditionalSelfCalls(child, self, calls);
+    }
+}
+
+// Parameter the expression names directly, if it is one of the given ones
+static const ParmVarDecl *namedParam(Expr *E, const std::set<const ParmVarDecl*> &params) {
+    DeclRefExpr *DRE = E ? dyn_cast<DeclRefExpr>(E->IgnoreParenImpCasts()) : nullptr;
+    const ParmVarDecl *PVD = DRE ? dyn_cast<ParmVarDecl>(DRE->getDecl()) : nullptr;
+    return (PVD && params.count(PVD)) ? PVD : nullptr;
+}
+
+static bool mentionsDecl(const Stmt *S, const Decl *D) {
+    if (!S) return false;
+    if (const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(S)) {
+        if (DRE->getDecl() == D) return true;
+    }
+    for (const Stmt *child : S->children()) {
+        if (mentionsDecl(child, D)) return true;
+    }
+    return false;
+}
+
+static bool writableThrough(QualType type) {
+    return (type->isPointerType() || type->isReferenceType()) && !type->getPointeeType().isConstQualified();
+}
+
+// Writes through the non-const pointer and reference parameters that recursive
+// calls share. Element writes (a[i] = x, v[i] = x, or a callee given the array
+// with two of the index parameters) stay in the caller's index range; anything
+// else (*p = x, p->f = x, v.push_back(x), local aliases) writes shared state.
+struct SharedParamWrites {
+    const FunctionDecl *self;
+    std::set<const ParmVarDecl*> shared;
+    std::set<const ParmVarDecl*> indices;
+    std::set<const ParmVarDecl*> elementWrites;
+    std::set<const ParmVarDecl*> sharedWrites;
+    
+    void noteTarget(Expr *E) {
+        E = E->IgnoreParenImpCasts();
+        std::string access;  // Operation applied directly to the parameter
+        while (true) {
+            if (ArraySubscriptExpr *ASE = dyn_cast<ArraySubscriptExpr>(E)) {
+                access = "[]";
+                E = ASE->getBase()->IgnoreParenImpCasts();
+            } else if (CXXOperatorCallExpr *OCE = dyn_cast<CXXOperatorCallExpr>(E)) {
+                if (OCE->getOperator() != OO_Subscript) break;
+                access = "[]";
+                E = OCE->getArg(0)->IgnoreParenImpCasts();
+            } else if (MemberExpr *ME = dyn_cast<MemberExpr>(E)) {
+                access = ME->isArrow() ? "->" : ".";
+                E = ME->getBase()->IgnoreParenImpCasts();
+            } else if (UnaryOperator *UO = dyn_cast<UnaryOperator>(E)) {
+                if (UO->getOpcode() != UO_Deref) break;
+                access = "*";
+                E = UO->getSubExpr()->IgnoreParenImpCasts();
+            } else {
+                break;
+            }
+        }
+        const ParmVarDecl *param = namedParam(E, shared);
+        if (!param) return;
+        if (access == "[]") {
+            elementWrites.insert(param);
+        } else if (!access.empty() || param->getType()->isReferenceType()) {
+            sharedWrites.insert(param);   // Assigning a pointer parameter only changes the copy
+        }
+    }
+    
+    void noteCall(CallExpr *CE) {
+        const FunctionDecl *callee = CE->getDirectCallee();
+        if (callee && callee->getCanonicalDecl() == self) return;   // Checked per task group
+        if (ComprehensiveFunctionAnalyzer::isPureLibraryFunction(callee)) return;
+        unsigned rangeArgs = 0;
+        for (Expr *arg : CE->arguments()) {
+            if (namedParam(arg, indices)) rangeArgs++;
+        }
+        for (unsigned i = 0; i < CE->getNumArgs(); ++i) {
+            Expr *arg = CE->getArg(i);
+            // Arguments past a variadic callee's parameters are passed by value
+            bool declared = callee && i < callee->getNumParams();
+            QualType type = declared ? callee->getParamDecl(i)->getType() : QualType();
+            bool writable = declared ? writableThrough(type) : (!callee || arg->getType()->isPointerType());
+            if (!writable) continue;
+            bool byReference = declared ? type->isReferenceType() : !callee;
+            if (byReference && !namedParam(arg, shared)) noteTarget(arg);   // swap(a[i], a[j])
+            for (const ParmVarDecl *param : shared) {
+                if (!mentionsDecl(arg, param)) continue;
+                if (!namedParam(arg, {param}) && !arg->getType()->isPointerType()) continue;
+                if (rangeArgs >= 2) elementWrites.insert(param);
+                else sharedWrites.insert(param);
+            }
+        }
+    }
+    
+    void scan(Stmt *S) {
+        if (!S || isa<LambdaExpr>(S)) return;
+        if (BinaryOperator *BO = dyn_cast<BinaryOperator>(S)) {
+            if (BO->isAssignmentOp()) noteTarget(BO->getLHS());
+        } else if (UnaryOperator *UO = dyn_cast<UnaryOperator>(S)) {
+            if (UO->isIncrementDecrementOp()) noteTarget(UO->getSubExpr());
+        } else if (CXXOperatorCallExpr *OCE = dyn_cast<CXXOperatorCallExpr>(S)) {
+            if (OCE->isAssignmentOp() && OCE->getNumArgs() > 0) noteTarget(OCE->getArg(0));
+        } else if (CXXMemberCallExpr *MCE = dyn_cast<CXXMemberCallExpr>(S)) {
+            const ParmVarDecl *param = namedParam(MCE->getImplicitObjectArgument(), shared);
+            CXXMethodDecl *method = MCE->getMethodDecl();
+            if (param && (!method || !method->isConst())) sharedWrites.insert(param);
+            noteCall(MCE);
+        } else if (CallExpr *CE = dyn_cast<CallExpr>(S)) {
+            noteCall(CE);
+        } else if (DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+            for (Decl *D : DS->decls()) {
+                VarDecl *VD = dyn_cast<VarDecl>(D);
+                if (!VD || !VD->hasInit() || !writableThrough(VD->getType())) continue;
+                for (const ParmVarDecl *param : shared) {
+                    if (mentionsDecl(VD->getInit(), param)) sharedWrites.insert(param);
+                }
+            }
+        }
+        for (Stmt *child : S->children()) {
+            scan(child);
+        }
+    }
+};
+
+bool ComprehensiveFunctionAnalyzer::isPureLibraryFunction(const FunctionDecl *FD) {
+    static const std::set<std::string> pure = {
+        "sqrt", "cbrt", "exp", "exp2", "expm1", "log", "log2", "log10", "log1p", "pow",
+        "sin", "cos", "tan", "asin", "acos", "atan", "atan2", "sinh", "cosh", "tanh",
+        "fabs", "abs", "labs", "floor", "ceil", "trunc", "round", "fmod", "hypot",
+        "fmin", "fmax", "erf", "erfc", "tgamma", "lgamma", "min", "max"};
+    if (!FD || !FD->getIdentifier() || isa<CXXMethodDecl>(FD)) return false;
+    const SourceManager &SM = FD->getASTContext().getSourceManager();
+    return SM.isInSystemHeader(FD->getLocation()) && pure.count(FD->getName().str()) > 0;
+}
+
+// A function is pure when it touches no globals, takes its arguments by value or
+// const reference, and calls nothing but pure functions. Calls to it can then be
+// evaluated once for loops that pass the same arguments every iteration.
+void ComprehensiveFunctionAnalyzer::analyzePurity(FunctionDecl *FD) {
+    FunctionAnalysis &analysis = functionAnalysis[currentFunction];
+    analysis.isPure = false;
+    if (!FD->getBody() || isa<CXXMethodDecl>(FD) || FD->isVariadic() || FD->getReturnType()->isVoidType() ||
+        FD->getReturnType()->isReferenceType() || FD->getReturnType()->isPointerType() ||
+        !analysis.readSet.empty() || !analysis.writeSet.empty()) {
+        return;
+    }
+    for (const ParmVarDecl *param : FD->parameters()) {
+        QualType type = param->getType();
+        if (type->isPointerType() || (type->isReferenceType() && !type->getPointeeType().isConstQualified())) return;
+    }
+    
+    class EffectFinder {
+    public:
+        const std::map<std::string, FunctionAnalysis> *analysis;
+        const FunctionDecl *self;
+        bool effects = false;
+        
+        void scan(Stmt *S) {
+            if (!S || effects) return;
+            if (isa<CXXMemberCallExpr>(S) || isa<CXXOperatorCallExpr>(S) || isa<CXXNewExpr>(S) ||
+                isa<CXXDeleteExpr>(S) || isa<CXXThrowExpr>(S) || isa<AsmStmt>(S)) {
+                effects = true;
+                return;
+            }
+            if (CallExpr *CE = dyn_cast<CallExpr>(S)) {
+                const FunctionDecl *callee = CE->getDirectCallee();
+                auto known = callee ? analysis->find(callee->getNameAsString()) : analysis->end();
+                bool pure = isPureLibraryFunction(callee) ||
+                            (callee && callee->getCanonicalDecl() == self) ||
+                            (known != analysis->end() && known->second.isPure);
+                if (!pure) {
+                    effects = true;
+                    return;
+                }
+            }
+            if (DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+                for (Decl *D : DS->decls()) {
+                    VarDecl *VD = dyn_cast<VarDecl>(D);
+                    if (VD && VD->isStaticLocal()) effects = true;
+                }
+            }
+            if (UnaryOperator *UO = dyn_cast<UnaryOperator>(S)) {
+                if (UO->getOpcode() == UO_Deref && UO->getSubExpr()->getType()->isPointerType()) effects = true;
+            }
+            for (Stmt *child : S->children()) {
+                scan(child);
+            }
+        }
+    };
+    
+    EffectFinder finder;
+    finder.analysis = &functionAnalysis;
+    finder.self = FD->getCanonicalDecl();
+    finder.scan(FD->getBody());
+    analysis.isPure = !finder.effects;
+}
+
+void ComprehensiveFunctionAnalyzer::analyzeRecursion(FunctionDecl *FD) {
+    CompoundStmt *body = dyn_cast<CompoundStmt>(FD->getBody());
+    if (!body || !SM) return;
+    
+    FunctionInfo &info = functionInfo[currentFunction];
+    const FunctionDecl *self = FD->getCanonicalDecl();
+    
+    // Find every direct self-call in the body (lambdas are left alone)
+    class SelfCallCollector : public RecursiveASTVisitor<SelfCallCollector> {
+    public:
+        const FunctionDecl *self;
+        std::vector<CallExpr*> calls;
+        std::vector<CompoundStmt*> compounds;
+        std::vector<ReturnStmt*> returns;
+        
+        SelfCallCollector(const FunctionDecl *fd) : self(fd) {}
+        
+        bool TraverseLambdaExpr(LambdaExpr *LE) { return true; }
+        
+        bool VisitCallExpr(CallExpr *CE) {
+            if (asSelfCall(CE, self)) calls.push_back(CE);
+            return true;
+        }
+        
+        bool VisitCompoundStmt(CompoundStmt *CS) {
+            compounds.push_back(CS);
+            return true;
+        }
+        
+        bool VisitReturnStmt(ReturnStmt *RS) {
+            returns.push_back(RS);
+            return true;
+        }
+    };
+    
+    SelfCallCollector collector(self);
+    collector.TraverseStmt(body);
+    if (collector.calls.empty()) {
+        return;
+    }
+    info.is_recursive = true;
+    
+    // Reasons that rule out outlining the function into a task helper
+    std::string reason;
+    if (isa<CXXMethodDecl>(FD)) {
+        reason = "member functions are not outlined into task helpers";
+    } else if (FD->isVariadic()) {
+        reason = "variadic functions cannot forward their arguments";
+    } else if (FD->getReturnType()->isReferenceType() || FD->getReturnType().isConstQualified()) {
+        reason = "return type cannot hold a task result";
+    } else if (!functionAnalysis[currentFunction].writeSet.empty()) {
+        reason = "writes global variables, recursive calls would race";
+    }
+    for (unsigned i = 0; i < FD->getNumParams() && reason.empty(); ++i) {
+        ParmVarDecl *param = FD->getParamDecl(i);
+        QualType type = param->getType();
+        if (param->getNameAsString().empty() || type->isFunctionPointerType()) {
+            reason = "parameter " + std::to_string(i) + " cannot be forwarded by name";
+        } else if (type->isLValueReferenceType() &&
+                   !type->getPointeeType().isConstQualified() &&
+                   type->getPointeeType()->isArithmeticType()) {
+            reason = "scalar reference parameter '" + param->getNameAsString() + "' is shared between calls";
+        }
+    }
+    for (CallExpr *CE : collector.calls) {
+        if (CE->getBeginLoc().isMacroID() || CE->getRParenLoc().isMacroID()) {
+            reason = "recursive call inside a macro expansion";
+            break;
+        }
+    }
+    
+    SharedParamWrites paramWrites;
+    paramWrites.self = self;
+    for (ParmVarDecl *param : FD->parameters()) {
+        if (writableThrough(param->getType())) paramWrites.shared.insert(param);
+        if (param->getType()->isIntegerType()) paramWrites.indices.insert(param);
+    }
+    paramWrites.scan(body);
+    if (reason.empty() && !paramWrites.sharedWrites.empty()) {
+        reason = "writes through parameter '" + (*paramWrites.sharedWrites.begin())->getNameAsString() +
+                 "' outside an index range, recursive calls would race";
+    }
+    
+    unsigned bodyOffset = SM->getFileOffset(body->getLBracLoc());
+    std::map<const CallExpr*, RecursiveCallSite> sites;
+    for (CallExpr *CE : collector.calls) {
+        RecursiveCallSite site;
+        site.call_start_offset = SM->getFileOffset(CE->getBeginLoc()) - bodyOffset;
+        site.call_end_offset = SM->getFileOffset(CE->getRParenLoc()) - bodyOffset;
+        site.callee_offset = site.call_start_offset;
+        if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(CE->getCallee()->IgnoreImpCasts())) {
+            site.callee_offset = SM->getFileOffset(DRE->getLocation()) - bodyOffset;
+        }
+        site.stmt_start_offset = site.call_start_offset;
+        site.num_args = CE->getNumArgs();
+        site.form = "inline";
+        site.result_type = CE->getType().getAsString();
+        site.task_group = -1;
+        sites[CE] = site;
+    }
+    
+    // A group of calls is independent when no call consumes another call's result
+    // and no argument has side effects. Calls sharing an array whose elements the
+    // function writes must split an index range between them (divide-and-conquer).
+    struct GroupMember {
+        Stmt *stmt;
+        CallExpr *call;
+        std::string form;
+        std::string resultVar;
+        std::string resultType;
+    };
+    ASTContext &Ctx = FD->getASTContext();
+    
+    // The first call starts at the caller's lower bound, the last ends at its upper
+    // bound, and each call starts where the previous one ended - (lo, mid)(mid, hi),
+    // (lo, mid)(mid + 1, hi) or (lo, p - 1)(p + 1, hi) - passing the arrays unchanged
+    auto argText = [&](const GroupMember &m, unsigned i) {
+        std::string text;
+        for (char c : getSourceText(m.call->getArg(i)->getSourceRange())) {
+            if (!std::isspace((unsigned char)c)) text += c;
+        }
+        return text;
+    };
+    auto splitsIndexRange = [&](const std::vector<GroupMember> &members) {
+        for (const auto &m : members) {
+            if (m.call->getNumArgs() != FD->getNumParams()) return false;
+            for (const ParmVarDecl *array : paramWrites.elementWrites) {
+                if (namedParam(m.call->getArg(array->getFunctionScopeIndex()), {array}) != array) return false;
+            }
+        }
+        for (const ParmVarDecl *lo : paramWrites.indices) {
+            for (const ParmVarDecl *hi : paramWrites.indices) {
+                unsigned l = lo->getFunctionScopeIndex(), h = hi->getFunctionScopeIndex();
+                if (l == h || namedParam(members.front().call->getArg(l), {lo}) != lo ||
+                    namedParam(members.back().call->getArg(h), {hi}) != hi) {
+                    continue;
+                }
+                bool adjacent = true;
+                for (size_t k = 0; k + 1 < members.size() && adjacent; ++k) {
+                    std::string end = argText(members[k], h);
+                    std::string start = argText(members[k + 1], l);
+                    bool before = end.size() > 2 && end.compare(end.size() - 2, 2, "-1") == 0;
+                    adjacent = start == end || start == end + "+1" ||
+                               (before && start == end.substr(0, end.size() - 2) + "+1");
+                }
+                if (adjacent) return true;
+            }
+        }
+        return false;
+    };
+    
+    int numGroups = 0;
+    auto commitGroup = [&](const std::vector<GroupMember> &members) {
+        if (members.size() < 2) return;
+        if (!paramWrites.elementWrites.empty() && !splitsIndexRange(members)) return;
+        std::set<std::string> results;
+        for (const auto &m : members) {
+            if (m.resultVar.empty()) continue;
+            if (results.count(m.resultVar)) return;
+            results.insert(m.resultVar);
+        }
+        for (const auto &m : members) {
+            for (unsigned i = 0; i < m.call->getNumArgs(); ++i) {
+                if (m.call->getArg(i)->HasSideEffects(Ctx, false)) return;
+                std::set<std::string> argVars;
+                collectReferencedVariables(m.call->getArg(i), argVars);
+                for (const auto &var : argVars) {
+                    if (results.count(var)) return;
+                }
+            }
+        }
+        for (const auto &m : members) {
+            RecursiveCallSite &site = sites[m.call];
+            site.form = m.form;
+            site.result_variable = m.resultVar;
+            if (!m.resultType.empty()) site.result_type = m.resultType;
+            site.stmt_start_offset = SM->getFileOffset(m.stmt->getBeginLoc()) - bodyOffset;
+            site.task_group = numGroups;
+        }
+        numGroups++;
+    };
+    
+    // Runs of consecutive statements that are each a single recursive call
+    for (CompoundStmt *CS : collector.compounds) {
+        std::vector<GroupMember> run;
+        for (Stmt *S : CS->body()) {
+            GroupMember member{S, nullptr, "", "", ""};
+            if (DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+                if (DS->isSingleDecl()) {
+                    // The declaration is split from its initializer, so a reference
+                    // cannot be split and a const result loses its top-level const
+                    VarDecl *VD = dyn_cast<VarDecl>(DS->getSingleDecl());
+                    if (VD && !VD->getType()->isReferenceType()) {
+                        if (VD->hasInit() && (member.call = asSelfCall(VD->getInit(), self))) {
+                            member.form = "decl";
+                            member.resultVar = VD->getNameAsString();
+                            member.resultType = VD->getType().getUnqualifiedType().getAsString();
+                        }
+                    }
+                }
+            } else if (Expr *E = dyn_cast<Expr>(S)) {
+                if ((member.call = asSelfCall(E, self))) {
+                    member.form = "expr";
+                } else if (BinaryOperator *BO = dyn_cast<BinaryOperator>(E->IgnoreImplicit())) {
+                    DeclRefExpr *LHS = dyn_cast<DeclRefExpr>(BO->getLHS()->IgnoreImpCasts());
+                    if (BO->getOpcode() == BO_Assign && LHS && isa<VarDecl>(LHS->getDecl()) &&
+                        (member.call = asSelfCall(BO->getRHS(), self))) {
+                        member.form = "assign";
+                        member.resultVar = LHS->getDecl()->getNameAsString();
+                    }
+                }
+            }
+            
+            if (member.call) {
+                run.push_back(member);
+            } else {
+                commitGroup(run);
+                run.clear();
+            }
+        }
+        commitGroup(run);
+    }
+    
+    // Several unconditional recursive calls combined in one return expression. The
+    // tasks go right before the return, so a return that is a whole if/else branch
+    // gets braces around both.
+    std::set<const Stmt*> blockStatements;
+    for (CompoundStmt *CS : collector.compounds) {
+        blockStatements.insert(CS->body_begin(), CS->body_end());
+    }
+    for (ReturnStmt *RS : collector.returns) {
+        std::vector<CallExpr*> calls;
+        collectUnconditionalSelfCalls(RS->getRetValue(), self, calls);
+        std::vector<GroupMember> members;
+        for (CallExpr *CE : calls) {
+            members.push_back(GroupMember{RS, CE, "return", "", ""});
+        }
+        int groupsBefore = numGroups;
+        commitGroup(members);
+        if (numGroups > groupsBefore && !blockStatements.count(RS)) {
+            for (CallExpr *CE : calls) {
+                sites[CE].unbraced_branch = true;
+            }
+        }
+    }
+    
+    for (CallExpr *CE : collector.calls) {
+        info.recursive_calls.push_back(sites[CE]);
+    }
+    std::sort(info.recursive_calls.begin(), info.recursive_calls.end(),
+              [](const RecursiveCallSite &a, const RecursiveCallSite &b) {
+                  return a.call_start_offset < b.call_start_offset;
+              });
+    
+    if (!reason.empty()) {
+        info.task_notes = "Recursive, not task-parallelized: " + reason + ".";
+    } else if (numGroups == 0) {
+        info.task_notes = "Recursive, but no independent recursive calls found.";
+    } else {
+        info.has_task_parallelism = true;
+        info.num_task_groups = numGroups;
+        info.task_notes = "Recursive with " + std::to_string(numGroups) +
+                          " group(s) of independent calls - OpenMP tasks with depth cutoff.";
+    }
+}
+
 std::string ComprehensiveFunctionAnalyzer::getSourceText(SourceRange range) {
     if (!SM || range.isInvalid()) return "";
     return std::string(Lexer::getSourceText(
@@ -34,7 +34,7 @@ public:
     ComprehensiveFunctionAnalyzer(const std::set<std::string>& globals);
     
     void setSourceManager(clang::SourceManager *sourceManager);
-    void setFunctionLoops(const std::map<std::string, std::vector<LoopInfo>>& functionLoops);
+    void setFunctionLoops(std::map<std::string, std::vector<LoopInfo>>&& functionLoops);  // Takes over the loops
     
     bool VisitFunctionDecl(clang::FunctionDecl *FD);
     bool VisitDeclRefExpr(clang::DeclRefExpr *DRE);
@@ -44,7 +44,12 @@ public:
     // Generate parallelized function body
     std::string generateParallelizedFunction(const std::string& funcName);
     
+    // <cmath> style library functions without side effects (sqrt, pow, fabs, ...)
+    static bool isPureLibraryFunction(const clang::FunctionDecl *FD);
+    
 private:
+    void analyzeRecursion(clang::FunctionDecl *FD);
+    void analyzePurity(clang::FunctionDecl *FD);
     std::string getSourceText(clang::SourceRange range);
 };
 
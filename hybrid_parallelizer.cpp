@@ -1,6 +1,9 @@
 #include "hybrid_parallelizer.h"
 #include "type_mapping.h"
+#include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <cstdint>
+#include <cstdlib>
 #include <sstream>
 #include <fstream>
 #include <set>
@@ -11,14 +14,22 @@ HybridParallelizer::HybridParallelizer(const std::vector<FunctionCall>& calls,
                                      const std::map<std::string, FunctionInfo>& funcInfo,
                                      const std::vector<LoopInfo>& loops,
                                      const std::set<std::string>& globals,
+                                     const std::map<std::string, GlobalVariable>& globalInfo,
                                      const std::string& includes,
                                      bool enableLoops,
                                      const SourceCodeContext& context,
-                                     const std::string& mainBody)
+                                     const std::string& mainBody,
+                                     bool enableSoA,
+                                     const std::string& numaBind,
+                                     bool timers,
+                                     bool planLoops,
+                                     const MachineModel& machine)
     : functionCalls(calls), functionAnalysis(analysis), 
       localVariables(localVars), functionInfo(funcInfo),
-      mainLoops(loops), globalVariables(globals),
-      originalIncludes(includes), enableLoopParallelization(enableLoops),
+      mainLoops(loops), globalVariables(globals), globalVariableInfo(globalInfo),
+      enableLoopParallelization(enableLoops), enableSoATransform(enableSoA),
+      numaProcBind(numaBind), emitTimers(timers), planRegions(planLoops), machineModel(machine),
+      originalIncludes(includes),
       sourceContext(context), mainFunctionBody(mainBody) {  // NEW: Store main body
     buildDependencyGraph();
 }
@@ -50,67 +61,94 @@ bool HybridParallelizer::isTypePrintable(const std::string& cppType) {
     return true; // Assume unknown simple types are printable
 }
 
+// Smallest id in both sets, npos if they are disjoint - one merge pass over the sorted ids
+static SymbolId firstShared(const SymbolSet& a, const SymbolSet& b) {
+    const std::vector<SymbolId>& x = a.ids();
+    const std::vector<SymbolId>& y = b.ids();
+    size_t i = 0, j = 0;
+    while (i < x.size() && j < y.size()) {
+        if (x[i] == y[j]) return x[i];
+        if (x[i] < y[j]) i++; else j++;
+    }
+    return SymbolTable::npos;
+}
+
+// Call sets as bitsets over call indices, 64 calls per word
+typedef std::vector<uint64_t> CallBits;
+
+static void addCall(std::vector<CallBits>& bitsByVar, SymbolId var, int call, size_t words) {
+    if (bitsByVar.size() <= var) bitsByVar.resize(var + 1);
+    if (bitsByVar[var].empty()) bitsByVar[var].assign(words, 0);
+    bitsByVar[var][call / 64] |= uint64_t(1) << (call % 64);
+}
+
+// OR the calls recorded for each variable of a set into out
+static void orCalls(CallBits& out, const std::vector<CallBits>& bitsByVar, const SymbolSet& vars) {
+    for (SymbolId var : vars.ids()) {
+        if (var >= bitsByVar.size() || bitsByVar[var].empty()) continue;
+        const CallBits& calls = bitsByVar[var];
+        for (size_t w = 0; w < out.size(); ++w) out[w] |= calls[w];
+    }
+}
+
+// Calls are visited in order and each variable keeps the bitset of earlier calls that
+// produce, read or write it, so the dependencies of a call are the OR of the bitsets of
+// its variables: O(n^2/64) words per variable instead of a set comparison per pair.
 void HybridParallelizer::buildDependencyGraph() {
     dependencyGraph.clear();
     
-    for (int i = 0; i < functionCalls.size(); ++i) {
+    const int n = (int)functionCalls.size();
+    const size_t words = (n + 63) / 64;
+    for (int i = 0; i < n; ++i) {
         DependencyNode node;
         node.functionName = functionCalls[i].functionName;
         node.callIndex = i;
         dependencyGraph.push_back(node);
     }
     
-    for (int i = 0; i < functionCalls.size(); ++i) {
-        for (int j = i + 1; j < functionCalls.size(); ++j) {
-            std::string reason = "";
-            bool hasDependency = false;
-            
-            if (functionCalls[i].hasReturnValue && !functionCalls[i].returnVariable.empty()) {
-                const std::string& producedVar = functionCalls[i].returnVariable;
-                if (functionCalls[j].usedLocalVariables.count(producedVar)) {
-                    hasDependency = true;
-                    reason = "Local variable data flow: " + producedVar;
-                }
-            }
-            
-            if (!hasDependency && functionAnalysis.count(functionCalls[i].functionName) && 
-                functionAnalysis.count(functionCalls[j].functionName)) {
-                
-                const auto& analysisA = functionAnalysis.at(functionCalls[i].functionName);
-                const auto& analysisB = functionAnalysis.at(functionCalls[j].functionName);
-                
-                for (const auto& writeVar : analysisA.writeSet) {
-                    if (analysisB.readSet.count(writeVar)) {
-                        hasDependency = true;
-                        reason = "Global variable RAW: " + writeVar;
-                        break;
-                    }
-                }
+    std::vector<const FunctionAnalysis*> analysisOf(n, nullptr);
+    for (int i = 0; i < n; ++i) {
+        auto it = functionAnalysis.find(functionCalls[i].functionName);
+        if (it != functionAnalysis.end()) analysisOf[i] = &it->second;
+    }
+    
+    std::vector<CallBits> producers, readers, writers;  // Indexed by SymbolId
+    CallBits deps(words);
+    
+    for (int j = 0; j < n; ++j) {
+        std::fill(deps.begin(), deps.end(), 0);
+        orCalls(deps, producers, functionCalls[j].usedLocalVariables);
+        if (analysisOf[j]) {
+            orCalls(deps, writers, analysisOf[j]->readSet);   // RAW
+            orCalls(deps, writers, analysisOf[j]->writeSet);  // WAW
+            orCalls(deps, readers, analysisOf[j]->writeSet);  // WAR
+        }
+        
+        for (size_t w = 0; w < words; ++w) {
+            for (uint64_t bits = deps[w]; bits; bits &= bits - 1) {
+                int i = (int)(w * 64 + __builtin_ctzll(bits));
+                std::string reason;
                 
-                if (!hasDependency) {
-                    for (const auto& writeVar : analysisA.writeSet) {
-                        if (analysisB.writeSet.count(writeVar)) {
-                            hasDependency = true;
-                            reason = "Global variable WAW: " + writeVar;
-                            break;
-                        }
+                if (functionCalls[i].hasReturnValue && !functionCalls[i].returnVariable.empty() &&
+                    functionCalls[j].usedLocalVariables.count(functionCalls[i].returnVariable)) {
+                    reason = "Local variable data flow: " + functionCalls[i].returnVariable;
+                } else {
+                    const FunctionAnalysis& analysisA = *analysisOf[i];
+                    const FunctionAnalysis& analysisB = *analysisOf[j];
+                    SymbolId shared = firstShared(analysisA.writeSet, analysisB.readSet);
+                    if (shared != SymbolTable::npos) {
+                        reason = "Global variable RAW: " + symbols().name(shared);
+                    } else if ((shared = firstShared(analysisA.writeSet, analysisB.writeSet)) != SymbolTable::npos) {
+                        reason = "Global variable WAW: " + symbols().name(shared);
+                    } else {
+                        shared = firstShared(analysisA.readSet, analysisB.writeSet);
+                        reason = "Global variable WAR: " + symbols().name(shared);
                     }
                 }
                 
-                if (!hasDependency) {
-                    for (const auto& readVar : analysisA.readSet) {
-                        if (analysisB.writeSet.count(readVar)) {
-                            hasDependency = true;
-                            reason = "Global variable WAR: " + readVar;
-                            break;
-                        }
-                    }
-                }
-            }
-            
-            if (hasDependency) {
-                dependencyGraph[j].dependencies.insert(i);
-                dependencyGraph[i].dependents.insert(j);
+                dependencyGraph[j].dependencies.push_back(i);
+                dependencyGraph[i].dependents.push_back(j);
+                dependencyGraph[j].edgeReasons.push_back(reason);
                 if (dependencyGraph[j].dependencyReason.empty()) {
                     dependencyGraph[j].dependencyReason = reason;
                 } else {
@@ -118,41 +156,389 @@ void HybridParallelizer::buildDependencyGraph() {
                 }
             }
         }
+        
+        if (functionCalls[j].hasReturnValue && !functionCalls[j].returnVariable.empty()) {
+            addCall(producers, symbols().intern(functionCalls[j].returnVariable), j, words);
+        }
+        if (analysisOf[j]) {
+            for (SymbolId var : analysisOf[j]->readSet.ids()) addCall(readers, var, j, words);
+            for (SymbolId var : analysisOf[j]->writeSet.ids()) addCall(writers, var, j, words);
+        }
     }
 }
 
+// Edges always point from an earlier call to a later one, so one pass in call order
+// assigns each call the level after its latest dependency: O(V+E)
 std::vector<std::vector<int>> HybridParallelizer::getParallelizableGroups() const {
     std::vector<std::vector<int>> groups;
-    std::vector<bool> processed(functionCalls.size(), false);
-    std::vector<int> inDegree(functionCalls.size());
+    std::vector<int> level(dependencyGraph.size(), 0);
     
-    for (int i = 0; i < dependencyGraph.size(); ++i) {
-        inDegree[i] = dependencyGraph[i].dependencies.size();
+    for (size_t j = 0; j < dependencyGraph.size(); ++j) {
+        for (int dep : dependencyGraph[j].dependencies) {
+            level[j] = std::max(level[j], level[dep] + 1);
+        }
+        if (level[j] >= (int)groups.size()) groups.resize(level[j] + 1);
+        groups[level[j]].push_back((int)j);
     }
     
-    while (true) {
-        std::vector<int> readyNodes;
-        for (int i = 0; i < functionCalls.size(); ++i) {
-            if (!processed[i] && inDegree[i] == 0) {
-                readyNodes.push_back(i);
+    return groups;
+}
+
+// Some parallelized loop draws from rand()
+bool HybridParallelizer::usesCounterRand() const {
+    for (const auto& entry : functionInfo) {
+        if (!entry.second.defined_in.empty()) continue;
+        for (const auto& loop : entry.second.loops) {
+            if (loop.parallelizable && !loop.pragma_text.empty() && loop.type == "for" && !loop.rand_ranges.empty()) {
+                return true;
             }
         }
-        
-        if (readyNodes.empty()) {
-            break;
+    }
+    return false;
+}
+
+// Whether a group contains functions with MPI-parallelized loops; those run one
+// after another on all ranks instead of being spread over ranks
+bool HybridParallelizer::groupHasMpiLoops(const std::vector<int>& group) const {
+    if (!enableLoopParallelization) return false;
+    for (int callIdx : group) {
+        auto it = functionInfo.find(functionCalls[callIdx].functionName);
+        if (it == functionInfo.end() || !it->second.defined_in.empty()) continue;  // Other units are linked as they are
+        for (const auto& loop : it->second.loops) {
+            if (splitsAcrossRanks(loop)) return true;
         }
-        
-        groups.push_back(readyNodes);
-        
-        for (int nodeIdx : readyNodes) {
-            processed[nodeIdx] = true;
-            for (int dependent : dependencyGraph[nodeIdx].dependents) {
-                inDegree[dependent]--;
+    }
+    return false;
+}
+
+// MPI-splittable loops stay split unless --plan found them too small for the collectives
+bool HybridParallelizer::splitsAcrossRanks(const LoopInfo& loop) const {
+    if (!loop.is_mpi_parallelizable) return false;
+    return !planRegions || planLoop(loop, machineModel).mode == RegionPlan::MPI;
+}
+
+// Some function loop is distributed over MPI ranks
+bool HybridParallelizer::usesRankSplit() const {
+    if (!enableLoopParallelization) return false;
+    for (const auto& entry : functionInfo) {
+        if (entry.first == "main" || !entry.second.defined_in.empty()) continue;
+        for (const auto& loop : entry.second.loops) {
+            if (loop.parallelizable && !loop.pragma_text.empty() && splitsAcrossRanks(loop)) return true;
+        }
+    }
+    return false;
+}
+
+// Some split loop checks its trip count against the rank count before splitting
+bool HybridParallelizer::usesRuntimeSplit() const {
+    if (!planRegions) return false;
+    for (const auto& entry : functionInfo) {
+        if (entry.first == "main" || !entry.second.defined_in.empty()) continue;
+        for (const auto& loop : entry.second.loops) {
+            if (loop.parallelizable && !loop.pragma_text.empty() && !loop.is_search_loop && !loop.is_scan_loop &&
+                splitsAcrossRanks(loop)) {
+                return true;
             }
         }
     }
+    return false;
+}
+
+// Whether splitting a loop over the ranks pays off: the work the other ranks take
+// over against a tree of log2(ranks) collective steps. All ranks see the same
+// arguments, so they agree without communicating.
+std::string HybridParallelizer::generatePlanSplitHelper() const {
+    std::stringstream code;
+    code << "// --plan machine model: " << machineModel.describe() << "\n";
+    code << "static inline bool _plan_split(double _trips, double _ns_per_trip, double _reduce_bytes, int _ranks) {\n";
+    code << "    if (_ranks < 2) return false;\n";
+    code << "    int _steps = 0;\n";
+    code << "    for (int _r = 1; _r < _ranks; _r *= 2) _steps++;\n";
+    code << "    double _saved = _trips * _ns_per_trip / " << machineModel.cores << ".0 * (1.0 - 1.0 / _ranks);\n";
+    code << "    return _saved > 2.0 * _steps * (" << machineModel.latencyUs * 1000.0 << " + _reduce_bytes / "
+         << machineModel.networkGBs << ");\n";
+    code << "}\n";
+    return code.str();
+}
+
+// Type that decides the MPI datatype: the canonical one when the analyzers recorded
+// it, so that size_t, int64_t or a typedef'd real_t move with their real width
+static const std::string& transferType(const std::string& spelled, const std::string& canonical) {
+    return canonical.empty() ? spelled : canonical;
+}
+
+static const std::string& transferType(const FunctionCall& call) {
+    return transferType(call.returnType, call.canonicalReturnType);
+}
+
+// Weight of the data edges leaving a call: its result travels to rank 0 and from
+// there to every later call that reads it. Calls without a transferable result weigh 0.
+int HybridParallelizer::dataEdgeWeight(int callIdx) const {
+    const FunctionCall& call = functionCalls[callIdx];
+    if (!call.hasReturnValue) return 0;
+    if (transferDatatype(transferType(call)).empty() &&
+        mpiElementType(TypeMapper::getTransferShape(transferType(call)).elementType).empty()) return 0;
+    return 1 + (int)dependencyGraph[callIdx].dependents.size();
+}
+
+// Struct from the main file that travels with an MPI struct datatype
+const RecordInfo* HybridParallelizer::findTransferableRecord(const std::string& cppType) const {
+    std::string name = TypeMapper::stripQualifiers(cppType);
+    for (const auto& record : sourceContext.records) {
+        if (record.name == name && record.transferable) return &record;
+    }
+    return nullptr;
+}
+
+// MPI datatype of one element: built-in types through TypeMapper, structs through
+// the helpers from generateRecordDatatypes. Pointers, nested containers and
+// multi-dimensional arrays have none.
+std::string HybridParallelizer::mpiElementType(const std::string& cppType) const {
+    if (const RecordInfo* record = findTransferableRecord(cppType)) {
+        return "_mpi_type_" + record->name + "()";
+    }
+    std::string type = TypeMapper::stripQualifiers(cppType);
+    if (type.empty() || type.find_first_of("*[<") != std::string::npos) return "";
+    return TypeMapper::getMPIDatatype(type);
+}
+
+// Datatype for sending one value of the type as a single element
+std::string HybridParallelizer::transferDatatype(const std::string& cppType) const {
+    TypeMapper::TransferShape shape = TypeMapper::getTransferShape(cppType);
+    if (shape.isContainer || shape.count != "1") return "";
+    return mpiElementType(shape.elementType);
+}
+
+// Broadcast of var from rank 0. Containers sized at run time send their length
+// first, so the other ranks can resize before the data arrives.
+std::string HybridParallelizer::generateBroadcast(const std::string& var, const std::string& cppType,
+                                                  const std::string& indentation) const {
+    TypeMapper::TransferShape shape = TypeMapper::getTransferShape(cppType);
+    std::string mpiType = mpiElementType(shape.elementType);
+    // std::vector<bool> has no data()
+    if (mpiType.empty() || (shape.isContainer && shape.elementType == "bool")) return "";
     
-    return groups;
+    std::string buffer = shape.isContainer ? var + ".data()" : (shape.count == "1" ? "&" + var : var);
+    if (!shape.isDynamic()) {
+        return indentation + "MPI_Bcast(" + buffer + ", " + shape.count + ", " + mpiType + ", 0, MPI_COMM_WORLD);";
+    }
+    std::string count = "_count_" + var;
+    return indentation + "{\n" +
+           indentation + "    long " + count + " = (long)" + var + ".size();\n" +
+           indentation + "    MPI_Bcast(&" + count + ", 1, MPI_LONG, 0, MPI_COMM_WORLD);\n" +
+           indentation + "    " + var + ".resize(" + count + ");\n" +
+           indentation + "    MPI_Bcast(" + buffer + ", (int)" + count + ", " + mpiType + ", 0, MPI_COMM_WORLD);\n" +
+           indentation + "}";
+}
+
+// Outermost loop of main that contains a statement at offset, null when it runs once
+static const LoopInfo* enclosingMainLoop(const std::map<std::string, FunctionInfo>& functionInfo, unsigned offset) {
+    if (!functionInfo.count("main")) return nullptr;
+    const LoopInfo* outermost = nullptr;
+    for (const auto& loop : functionInfo.at("main").loops) {
+        if (loop.function_offset == std::string::npos || loop.function_offset >= offset ||
+            offset >= loop.function_offset + loop.source_code.length()) {
+            continue;
+        }
+        if (!outermost || loop.function_offset < outermost->function_offset) outermost = &loop;
+    }
+    return outermost;
+}
+
+// Fixed-size results of at least this many elements go through an RMA window
+static const long kRmaMinElements = 1024;
+
+// Transfer of a rank-0 result computed on every iteration of a loop in main.
+// The staging buffer and the communication are set up once in front of the loop:
+// a persistent MPI_Bcast_init broadcast for small results (a plain MPI_Bcast
+// before MPI 4), an MPI_Win_create window for large arrays that the other ranks
+// MPI_Get from rank 0. Both keep the root's work independent of the rank count.
+// The loop variable binds to the buffer, so the data is not copied again.
+// Results sized at run time keep their per-iteration broadcast.
+bool HybridParallelizer::generateRepeatedTransfer(int callIdx, const std::string& loopIndentation,
+                                                  const std::string& indentation, std::string& setup,
+                                                  std::string& transfer, std::string& teardown) const {
+    const FunctionCall& call = functionCalls[callIdx];
+    std::string type = TypeMapper::normalizeType(call.returnType);
+    TypeMapper::TransferShape shape = TypeMapper::getTransferShape(transferType(call));
+    std::string mpiType = mpiElementType(shape.elementType);
+    if (!call.hasReturnValue || call.returnVariable.empty() || type.find("auto") != std::string::npos ||
+        shape.isDynamic() || mpiType.empty()) {
+        return false;
+    }
+    
+    std::string tag = std::to_string(callIdx);
+    std::string buffer = "_persist_" + tag;
+    std::string data = shape.isContainer ? buffer + ".data()" : (shape.count == "1" ? "&" + buffer : buffer);
+    char* end = nullptr;
+    long elements = std::strtol(shape.count.c_str(), &end, 10);
+    bool useWindow = end && *end == '\0' && elements >= kRmaMinElements;
+    
+    std::stringstream pre, per, post;
+    const std::string& in = loopIndentation;
+    pre << in << "// " << call.functionName << "'s result travels the same way on every iteration\n";
+    // "const T x = f();" - the buffer itself is written on every iteration
+    pre << in << TypeMapper::stripQualifiers(type) << " " << buffer << ";\n";
+    if (useWindow) {
+        std::string win = "_persist_win_" + tag;
+        pre << in << "MPI_Win " << win << ";\n";
+        pre << in << "MPI_Win_create(&" << buffer << ", sizeof(" << buffer << "), 1, MPI_INFO_NULL, MPI_COMM_WORLD, &"
+            << win << ");\n";
+        per << indentation << "MPI_Win_fence(0, " << win << ");\n";
+        per << indentation << "if (rank != 0) {\n";
+        per << indentation << "    MPI_Get(" << data << ", " << shape.count << ", " << mpiType << ", 0, 0, "
+            << shape.count << ", " << mpiType << ", " << win << ");\n";
+        per << indentation << "}\n";
+        per << indentation << "MPI_Win_fence(0, " << win << ");";
+        post << in << "MPI_Win_free(&" << win << ");";
+    } else {
+        std::string request = "_persist_req_" + tag;
+        pre << "#if MPI_VERSION >= 4\n";
+        pre << in << "MPI_Request " << request << ";\n";
+        pre << in << "MPI_Bcast_init(" << data << ", " << shape.count << ", " << mpiType << ", 0, MPI_COMM_WORLD, "
+            << "MPI_INFO_NULL, &" << request << ");\n";
+        pre << "#endif\n";
+        per << "#if MPI_VERSION >= 4\n";
+        per << indentation << "MPI_Start(&" << request << ");\n";
+        per << indentation << "MPI_Wait(&" << request << ", MPI_STATUS_IGNORE);\n";
+        per << "#else\n";
+        per << indentation << "MPI_Bcast(" << data << ", " << shape.count << ", " << mpiType << ", 0, MPI_COMM_WORLD);\n";
+        per << "#endif";
+        post << "#if MPI_VERSION >= 4\n";
+        post << in << "MPI_Request_free(&" << request << ");\n";
+        post << "#endif";
+    }
+    
+    setup = pre.str();
+    transfer = per.str();
+    teardown = post.str();
+    return true;
+}
+
+// One committed MPI datatype per transferable struct, created on first use. The
+// type is resized to sizeof(T) so that arrays of the struct stride over padding.
+std::string HybridParallelizer::generateRecordDatatypes() const {
+    std::stringstream code;
+    for (const auto& record : sourceContext.records) {
+        if (!record.transferable) continue;
+        
+        std::vector<std::string> types;
+        for (const auto& field : record.fields) {
+            types.push_back(mpiElementType(field.type));
+        }
+        if (std::find(types.begin(), types.end(), "") != types.end()) continue;
+        
+        size_t n = record.fields.size();
+        if (code.tellp() > 0) code << "\n";
+        code << "inline MPI_Datatype _mpi_type_" << record.name << "() {\n";
+        code << "    static MPI_Datatype type = MPI_DATATYPE_NULL;\n";
+        code << "    if (type == MPI_DATATYPE_NULL) {\n";
+        code << "        int lengths[" << n << "] = {";
+        for (size_t i = 0; i < n; i++) code << (i ? ", " : "") << record.fields[i].count;
+        code << "};\n";
+        code << "        MPI_Aint displacements[" << n << "] = {";
+        for (size_t i = 0; i < n; i++) code << (i ? ", " : "") << "offsetof(" << record.name << ", " << record.fields[i].name << ")";
+        code << "};\n";
+        code << "        MPI_Datatype types[" << n << "] = {";
+        for (size_t i = 0; i < n; i++) code << (i ? ", " : "") << types[i];
+        code << "};\n";
+        code << "        MPI_Datatype packed;\n";
+        code << "        MPI_Type_create_struct(" << n << ", lengths, displacements, types, &packed);\n";
+        code << "        MPI_Type_create_resized(packed, 0, sizeof(" << record.name << "), &type);\n";
+        code << "        MPI_Type_free(&packed);\n";
+        code << "        MPI_Type_commit(&type);\n";
+        code << "    }\n";
+        code << "    return type;\n";
+        code << "}\n";
+    }
+    return code.str();
+}
+
+// --emit-timers: regions get ids in generation order; the generated program sums
+// their wall time per rank
+int HybridParallelizer::addTimerRegion(const std::string& name) {
+    timerRegions.push_back(name);
+    return (int)timerRegions.size() - 1;
+}
+
+static std::string timerStart(int id, const std::string& indentation) {
+    return indentation + "double _timer_start_" + std::to_string(id) + " = MPI_Wtime();\n";
+}
+
+static std::string timerStop(int id, const std::string& indentation) {
+    return indentation + "_timer_add(" + std::to_string(id) + ", _timer_start_" + std::to_string(id) + ");\n";
+}
+
+// Timer just inside the braces of a generated "{ ... }" block
+static std::string timeBlock(const std::string& block, int id, const std::string& indentation) {
+    size_t open = block.find('\n');
+    size_t close = block.rfind('\n');
+    if (open == std::string::npos || close <= open) return block;
+    return block.substr(0, open + 1) + timerStart(id, indentation + "    ") + block.substr(open + 1, close - open) +
+           timerStop(id, indentation + "    ") + block.substr(close + 1);
+}
+
+// Closes the whole-program region and prints the report; emitted before every MPI_Finalize
+std::string HybridParallelizer::timerReport(const std::string& indentation) const {
+    if (!emitTimers) return "";
+    return timerStop(mainTimerRegion, indentation) + indentation + "_timer_report();\n";
+}
+
+// Declared ahead of the functions that call them; defined after main, where the
+// number of regions is known
+std::string HybridParallelizer::generateTimerDeclarations() const {
+    if (!emitTimers) return "";
+    return "// --emit-timers: wall time per region and rank, reported at MPI_Finalize\n"
+           "static inline void _timer_add(int id, double start);\n"
+           "static void _timer_report();\n\n";
+}
+
+// Per-rank totals and call counts, gathered to rank 0 in one collective right
+// before MPI_Finalize. The report goes to stderr so program output is unchanged.
+std::string HybridParallelizer::generateTimerSupport() const {
+    if (!emitTimers) return "";
+    std::stringstream code;
+    size_t n = timerRegions.size();
+    code << "\n// --emit-timers region table\n";
+    code << "static const int _timer_count = " << n << ";\n";
+    code << "static const char* const _timer_names[" << n << "] = {\n";
+    for (size_t i = 0; i < n; i++) {
+        code << "    \"" << timerRegions[i] << "\"" << (i + 1 < n ? "," : "") << "\n";
+    }
+    code << "};\n";
+    code << "static double _timer_totals[2 * " << n << "];  // Seconds, then calls\n";
+    code << "\n";
+    code << "static inline void _timer_add(int id, double start) {\n";
+    code << "    _timer_totals[id] += MPI_Wtime() - start;\n";
+    code << "    _timer_totals[_timer_count + id] += 1;\n";
+    code << "}\n";
+    code << "\n";
+    code << "static void _timer_report() {\n";
+    code << "    int rank, size;\n";
+    code << "    MPI_Comm_rank(MPI_COMM_WORLD, &rank);\n";
+    code << "    MPI_Comm_size(MPI_COMM_WORLD, &size);\n";
+    code << "    std::vector<double> all(rank == 0 ? (size_t)size * 2 * _timer_count : 0);\n";
+    code << "    MPI_Gather(_timer_totals, 2 * _timer_count, MPI_DOUBLE, all.data(), 2 * _timer_count, MPI_DOUBLE, 0, MPI_COMM_WORLD);\n";
+    code << "    if (rank != 0) return;\n";
+    code << "    fprintf(stderr, \"\\n=== Timers: %d ranks, %d threads per rank ===\\n\", size, omp_get_max_threads());\n";
+    code << "    fprintf(stderr, \"%-40s %7s %10s %10s %10s %8s  %s\\n\", \"region\", \"calls\", \"min [s]\", \"avg [s]\", \"max [s]\", \"max/avg\", \"slowest\");\n";
+    code << "    for (int t = 0; t < _timer_count; t++) {\n";
+    code << "        double low = all[t], high = all[t], sum = 0.0, calls = 0.0;\n";
+    code << "        int slowest = 0;\n";
+    code << "        for (int r = 0; r < size; r++) {\n";
+    code << "            const double* totals = &all[(size_t)r * 2 * _timer_count];\n";
+    code << "            sum += totals[t];\n";
+    code << "            if (totals[t] < low) low = totals[t];\n";
+    code << "            if (totals[t] > high) { high = totals[t]; slowest = r; }\n";
+    code << "            if (totals[_timer_count + t] > calls) calls = totals[_timer_count + t];\n";
+    code << "        }\n";
+    code << "        if (calls == 0.0) continue;\n";
+    code << "        double avg = sum / size;\n";
+    code << "        fprintf(stderr, \"%-40s %7.0f %10.4f %10.4f %10.4f %8.2f  rank %d\\n\", _timer_names[t], calls, low, avg, high,\n";
+    code << "                avg > 0.0 ? high / avg : 1.0, slowest);\n";
+    code << "    }\n";
+    code << "}\n";
+    return code.str();
 }
 
 const std::vector<DependencyNode>& HybridParallelizer::getDependencyGraph() const {
@@ -213,12 +599,13 @@ std::string HybridParallelizer::extractIncludesOnly(const std::string& source) {
     return result.str();
 }
 
-// Helper to find matching brace
-static size_t findMatchingBrace(const std::string& str, size_t startPos) {
+// Closing parenthesis matching the one at startPos
+static size_t findMatchingParen(const std::string& str, size_t startPos) {
+    if (startPos == std::string::npos) return std::string::npos;
     int depth = 0;
     for (size_t i = startPos; i < str.length(); ++i) {
-        if (str[i] == '{') depth++;
-        else if (str[i] == '}') {
+        if (str[i] == '(') depth++;
+        else if (str[i] == ')') {
             depth--;
             if (depth == 0) return i;
         }
@@ -239,225 +626,905 @@ static std::string getMPIOp(const std::string& op) {
     return "MPI_SUM"; // Default
 }
 
-std::string HybridParallelizer::generateParallelizedFunctionBody(const FunctionInfo& info) {
-    std::string parallelizedBody = info.original_body;
-    
-    // If loop parallelization is disabled, return original body
-    if (!enableLoopParallelization || info.loops.empty()) {
-        return parallelizedBody;
-    }
-    
-    // First, replace thread-unsafe function calls with thread-safe alternatives
-    for (const auto& loop : info.loops) {
-        if (loop.has_thread_unsafe_calls) {
-            for (const auto& unsafeFunc : loop.unsafe_functions) {
-                if (unsafeFunc == "rand") {
-                    // Replace rand() with rand_r(&__thread_seed)
-                    size_t pos = 0;
-                    while ((pos = parallelizedBody.find("rand()", pos)) != std::string::npos) {
-                        parallelizedBody.replace(pos, 6, "rand_r(&__thread_seed)");
-                        pos += 20; // Length of "rand_r(&__thread_seed)"
-                    }
-                }
-            }
+// Text edit on a function body: replace [offset, offset + length) with text
+struct BodyEdit {
+    size_t offset;
+    size_t length;
+    std::string text;
+};
+
+// Write the original text with the edits applied, in one front-to-back pass, so the
+// cost is linear in the body size and no edited copy is built. At equal offsets
+// insertions go first, so an insertion lands in front of the replaced text; an edit
+// overlapping an earlier one is dropped.
+static void writeBodyEdits(llvm::raw_ostream& out, const std::string& body, std::vector<BodyEdit> edits) {
+    std::stable_sort(edits.begin(), edits.end(), [](const BodyEdit& a, const BodyEdit& b) {
+        if (a.offset != b.offset) return a.offset < b.offset;
+        return a.length < b.length;
+    });
+    size_t cursor = 0;
+    for (const auto& edit : edits) {
+        if (edit.offset < cursor || edit.offset + edit.length > body.size()) continue;
+        out.write(body.data() + cursor, edit.offset - cursor);
+        out << edit.text;
+        cursor = edit.offset + edit.length;
+    }
+    out.write(body.data() + cursor, body.size() - cursor);
+}
+
+static std::string applyBodyEdits(const std::string& body, std::vector<BodyEdit> edits) {
+    std::string result;
+    result.reserve(body.size());
+    llvm::raw_string_ostream stream(result);
+    writeBodyEdits(stream, body, std::move(edits));
+    stream.flush();
+    return result;
+}
+
+// Leading whitespace of the line containing pos
+static std::string lineIndentation(const std::string& text, size_t pos) {
+    size_t lineStart = text.rfind('\n', pos);
+    lineStart = (lineStart == std::string::npos) ? 0 : lineStart + 1;
+    std::string indentation;
+    for (size_t i = lineStart; i < pos && (text[i] == ' ' || text[i] == '\t'); ++i) {
+        indentation += text[i];
+    }
+    return indentation;
+}
+
+// Edit putting a directive line in front of the statement at pos. A statement
+// sharing its line with an if or loop header moves to a line of its own,
+// indented under the header.
+static BodyEdit directiveEdit(const std::string& text, size_t pos, const std::string& directive) {
+    std::string indentation = lineIndentation(text, pos);
+    size_t lineStart = text.rfind('\n', pos);
+    lineStart = (lineStart == std::string::npos) ? 0 : lineStart + 1;
+    if (text.find_first_not_of(" \t", lineStart) == pos) {
+        return {lineStart, 0, indentation + directive + "\n"};
+    }
+    size_t headerEnd = pos;
+    while (headerEnd > 0 && (text[headerEnd - 1] == ' ' || text[headerEnd - 1] == '\t')) headerEnd--;
+    bool afterStatement = headerEnd > 0 && (text[headerEnd - 1] == ';' || text[headerEnd - 1] == '{' ||
+                                            text[headerEnd - 1] == '}');
+    std::string inner = indentation + (afterStatement ? "" : "    ");
+    return {headerEnd, pos - headerEnd, "\n" + inner + directive + "\n" + inner};
+}
+
+// Put a directive line in front of the statements at the given body offsets
+static std::string insertDirectives(const std::string& text, size_t bodyOffset, const std::vector<unsigned>& offsets,
+                                    const std::string& directive) {
+    std::vector<BodyEdit> edits;
+    for (unsigned offset : offsets) {
+        if (bodyOffset + offset < text.size()) {
+            edits.push_back(directiveEdit(text, bodyOffset + offset, directive));
         }
     }
+    return applyBodyEdits(text, edits);
+}
+
+// Whether the line above pos is an OpenMP pragma (already parallelized by hand)
+static bool precededByPragma(const std::string& text, size_t pos) {
+    size_t lineStart = text.rfind('\n', pos);
+    if (lineStart == std::string::npos || lineStart == 0) return false;
+    size_t prevStart = text.rfind('\n', lineStart - 1);
+    prevStart = (prevStart == std::string::npos) ? 0 : prevStart + 1;
+    size_t first = text.find_first_not_of(" \t", prevStart);
+    return first != std::string::npos && first < lineStart && text.compare(first, 11, "#pragma omp") == 0;
+}
+
+// Canonical for-form of a loop over its inferred iteration space, starting at
+// startExpr. Converted while loops keep their induction variable outside.
+static std::string buildCanonicalLoop(const LoopInfo& loop, const std::string& startExpr, bool declare) {
+    const std::string& var = loop.loop_variable;
+    bool negativeStep = !loop.step_expr.empty() && loop.step_expr[0] == '-';
+    std::string update;
+    if (loop.step_expr == "1") update = var + "++";
+    else if (loop.step_expr == "-1") update = var + "--";
+    else if (negativeStep) update = var + " -= " + loop.step_expr.substr(1);
+    else update = var + " += " + loop.step_expr;
     
-    // Add thread-local variable declarations at the beginning of function
-    bool needsThreadSeed = false;
-    for (const auto& loop : info.loops) {
-        if (loop.thread_local_vars.count("__thread_seed")) {
-            needsThreadSeed = true;
-            break;
+    return "for (" + (declare ? loop.loop_variable_type + " " : std::string()) + var + " = " + startExpr + "; " +
+           var + (negativeStep ? " > " : " < ") + loop.end_expr + "; " + update + ") " + loop.body_source;
+}
+
+// Speculative execution of an early-exit search loop: chunks of the iteration
+// space are probed in parallel and the probe is cancelled once any thread hits
+// a break or return. The loop then replays serially from the first chunk that
+// hit, so the exit point and any results match sequential execution. When
+// distributed, each rank probes its own block and MPI_MIN picks the winner.
+static std::string buildSpeculativeSearch(const LoopInfo& loop, const std::string& indentation, bool distributed) {
+    const std::string& var = loop.loop_variable;
+    const std::string& in = indentation;
+    bool negativeStep = !loop.step_expr.empty() && loop.step_expr[0] == '-';
+    
+    // Inside the probe each exit raises the hit flag and cancels the worksharing loop
+    std::vector<BodyEdit> edits;
+    for (const auto& exit : loop.exit_ranges) {
+        std::string exitIndent = lineIndentation(loop.body_source, exit.first);
+        edits.push_back({exit.first, exit.second, "{\n" +
+                         exitIndent + "    #pragma omp atomic write\n" +
+                         exitIndent + "    _search_hit = 1;\n" +
+                         exitIndent + "    #pragma omp cancel for\n" +
+                         exitIndent + "}"});
+    }
+    std::string probeBody = applyBodyEdits(loop.body_source, edits);
+    
+    std::stringstream code;
+    code << "{\n";
+    code << in << "    // Speculative search: cancellation needs OMP_CANCELLATION=true, otherwise\n";
+    code << in << "    // each chunk simply runs to completion before the serial replay\n";
+    code << in << "    long _search_start = " << loop.start_expr << ";\n";
+    code << in << "    long _search_step = " << loop.step_expr << ";\n";
+    code << in << "    long _search_total = ((" << loop.end_expr << ") - _search_start + _search_step "
+         << (negativeStep ? "+ 1" : "- 1") << ") / _search_step;\n";
+    code << in << "    if (_search_total < 0) _search_total = 0;\n";
+    if (distributed) {
+        code << in << "    int _mpi_rank, _mpi_size;\n";
+        code << in << "    MPI_Comm_rank(MPI_COMM_WORLD, &_mpi_rank);\n";
+        code << in << "    MPI_Comm_size(MPI_COMM_WORLD, &_mpi_size);\n";
+        code << in << "    long _chunk_size = _search_total / _mpi_size;\n";
+        code << in << "    long _remainder = _search_total % _mpi_size;\n";
+        code << in << "    long _search_resume = _mpi_rank * _chunk_size + (_mpi_rank < _remainder ? _mpi_rank : _remainder);\n";
+        code << in << "    long _search_stop = _search_resume + _chunk_size + (_mpi_rank < _remainder ? 1 : 0);\n";
+    } else {
+        code << in << "    long _search_resume = 0;\n";
+        code << in << "    long _search_stop = _search_total;\n";
+    }
+    code << in << "    long _search_chunk = 4096L * omp_get_max_threads();\n";
+    code << in << "    int _search_hit = 0;\n";
+    code << in << "    while (_search_resume < _search_stop) {\n";
+    code << in << "        long _search_limit = _search_resume + _search_chunk < _search_stop ? _search_resume + _search_chunk : _search_stop;\n";
+    code << in << "        #pragma omp parallel\n";
+    code << in << "        {\n";
+    code << in << "        " << loop.pragma_text << "\n";
+    code << in << "        for (long _search_iter = _search_resume; _search_iter < _search_limit; _search_iter++) {\n";
+    code << in << "            " << loop.loop_variable_type << " " << var << " = _search_start + _search_iter * _search_step;\n";
+    code << in << "            " << probeBody << "\n";
+    code << in << "            #pragma omp cancellation point for\n";
+    code << in << "        }\n";
+    code << in << "        }\n";
+    code << in << "        if (_search_hit) break;\n";
+    code << in << "        _search_resume = _search_limit;\n";
+    code << in << "    }\n";
+    if (distributed) {
+        code << in << "    // The earliest chunk that hit on any rank holds the sequential exit\n";
+        code << in << "    long _search_found = _search_hit ? _search_resume : _search_total;\n";
+        code << in << "    MPI_Allreduce(&_search_found, &_search_resume, 1, MPI_LONG, MPI_MIN, MPI_COMM_WORLD);\n";
+    }
+    code << in << "    " << buildCanonicalLoop(loop, "_search_start + _search_resume * _search_step",
+                                             loop.type == "for" && loop.declares_loop_variable) << "\n";
+    code << in << "}";
+    return code.str();
+}
+
+// Prefix sum as an inscan reduction. Running sums get "#pragma omp scan" between
+// the update and the reads; a recurrence a[i] = a[i-1] + e is rebuilt around a
+// fresh accumulator. When distributed, each rank first sums the contributions of
+// its own block, MPI_Exscan turns those sums into starting offsets, and the scan
+// then runs over the block from its offset.
+static std::string buildPrefixScan(const LoopInfo& loop, const std::string& indentation, bool distributed) {
+    const PrefixScan& scan = loop.scan;
+    const std::string& var = loop.loop_variable;
+    const std::string& in = indentation;
+    std::string directive = std::string("#pragma omp scan ") + (scan.exclusive ? "exclusive(" : "inclusive(") + scan.var + ")";
+    
+    std::string body;
+    if (scan.array.empty()) {
+        body = insertDirectives(loop.source_code.substr(loop.body_offset), 0, {scan.split_offset}, directive);
+    } else {
+        body = "{\n" +
+               in + "        " + scan.var + " += " + scan.update_expr + ";\n" +
+               in + "        " + directive + "\n" +
+               in + "        " + scan.target + " = " + scan.var + ";\n" +
+               in + "    }";
+    }
+    std::string initial = scan.array.empty() ? std::string() : scan.array + "[(" + loop.start_expr + ") - 1]";
+    
+    std::stringstream code;
+    if (!distributed) {
+        if (scan.array.empty()) {
+            return loop.pragma_text + "\n" + in + loop.source_code.substr(0, loop.body_offset) + body;
         }
+        code << "{\n";
+        code << in << "    " << scan.type << " " << scan.var << " = " << initial << ";\n";
+        code << in << "    " << loop.pragma_text << "\n";
+        code << in << "    " << loop.source_code.substr(0, loop.body_offset) << body << "\n";
+        code << in << "}";
+        return code.str();
     }
     
-    if (needsThreadSeed) {
-        // Insert thread-local seed declaration after opening brace
-        // Use static thread_local to ensure proper per-thread initialization
-        size_t bracePos = parallelizedBody.find('{');
-        if (bracePos != std::string::npos) {
-            // Use thread_local with lazy initialization inside the parallel region
-            // The seed will be initialized properly when first accessed by each thread
-            std::string seedDecl = "\n    static thread_local unsigned int __thread_seed = 0;\n"
-                                   "    static thread_local bool __seed_initialized = false;";
-            parallelizedBody.insert(bracePos + 1, seedDecl);
-            
-            // Add initialization inside each parallel loop
-            // Find all #pragma omp parallel for and add seed init after loop start
-            size_t pragmaPos = 0;
-            while ((pragmaPos = parallelizedBody.find("#pragma omp parallel for", pragmaPos)) != std::string::npos) {
-                // Find the loop body's opening brace
-                size_t forPos = parallelizedBody.find("for", pragmaPos + 24);
-                if (forPos != std::string::npos) {
-                    size_t loopBrace = parallelizedBody.find('{', forPos);
-                    if (loopBrace != std::string::npos) {
-                        std::string seedInit = "\n        if (!__seed_initialized) { __thread_seed = (unsigned int)time(NULL) ^ omp_get_thread_num(); __seed_initialized = true; }";
-                        parallelizedBody.insert(loopBrace + 1, seedInit);
-                        pragmaPos = loopBrace + seedInit.length() + 1;
-                    } else {
-                        pragmaPos += 24;
-                    }
-                } else {
-                    pragmaPos += 24;
-                }
-            }
+    std::string header = "for (" + (loop.declares_loop_variable ? loop.loop_variable_type + " " : std::string()) +
+                         var + " = _my_start; " + var + " < _my_end; " + var + " += " + loop.step_expr + ") ";
+    std::string mpiType = TypeMapper::getMPIDatatype(scan.type);
+    code << "{\n";
+    code << in << "    // Hybrid MPI+OpenMP Prefix Scan\n";
+    code << in << "    int _mpi_rank, _mpi_size;\n";
+    code << in << "    MPI_Comm_rank(MPI_COMM_WORLD, &_mpi_rank);\n";
+    code << in << "    MPI_Comm_size(MPI_COMM_WORLD, &_mpi_size);\n";
+    code << in << "    long _loop_start = " << loop.start_expr << ";\n";
+    code << in << "    long _loop_end = " << loop.end_expr << ";\n";
+    code << in << "    long _loop_step = " << loop.step_expr << ";\n";
+    code << in << "    long _total_iters = (_loop_end - _loop_start + _loop_step - 1) / _loop_step;\n";
+    code << in << "    if (_total_iters < 0) _total_iters = 0;\n";
+    code << in << "    long _chunk_size = _total_iters / _mpi_size;\n";
+    code << in << "    long _remainder = _total_iters % _mpi_size;\n";
+    code << in << "    long _my_start_iter = _mpi_rank * _chunk_size + (_mpi_rank < _remainder ? _mpi_rank : _remainder);\n";
+    code << in << "    long _my_count = _chunk_size + (_mpi_rank < _remainder ? 1 : 0);\n";
+    code << in << "    long _my_start = _loop_start + _my_start_iter * _loop_step;\n";
+    code << in << "    long _my_end = _my_start + _my_count * _loop_step;\n";
+    code << in << "    // Phase 1: this rank's share of the total\n";
+    code << in << "    " << scan.type << " _scan_local = 0;\n";
+    code << in << "    #pragma omp parallel for reduction(" << scan.op << ":_scan_local) schedule(static)\n";
+    code << in << "    " << header << "_scan_local += " << scan.update_expr << ";\n";
+    code << in << "    // Phase 2: ranks before this one give the starting offset\n";
+    code << in << "    " << scan.type << " _scan_offset = 0;\n";
+    code << in << "    MPI_Exscan(&_scan_local, &_scan_offset, 1, " << mpiType << ", MPI_SUM, MPI_COMM_WORLD);\n";
+    code << in << "    if (_mpi_rank == 0) _scan_offset = 0;\n";
+    if (scan.array.empty()) {
+        code << in << "    " << scan.type << " _scan_base = " << scan.var << ";\n";
+        code << in << "    " << scan.var << " = _scan_base + _scan_offset;\n";
+    } else {
+        code << in << "    " << scan.type << " " << scan.var << " = " << initial << " + _scan_offset;\n";
+    }
+    code << in << "    " << loop.pragma_text << "\n";
+    code << in << "    " << header << body << "\n";
+    if (!loop.declares_loop_variable) {
+        code << in << "    " << var << " = _loop_start + _total_iters * _loop_step;\n";
+    }
+    if (scan.array.empty()) {
+        code << in << "    " << scan.type << " _scan_total = 0;\n";
+        code << in << "    MPI_Allreduce(&_scan_local, &_scan_total, 1, " << mpiType << ", MPI_SUM, MPI_COMM_WORLD);\n";
+        code << in << "    " << scan.var << " = _scan_base + _scan_total;\n";
+    }
+    code << in << "}";
+    return code.str();
+}
+
+// NUMA mode: loops keep the static schedule of the loop that first touched their
+// pages, so each thread works on memory local to its socket, and proc_bind keeps
+// the threads from migrating away from it
+static std::string numaPragma(const std::string& pragma, const std::string& procBind) {
+    if (procBind.empty() || pragma.compare(0, 20, "#pragma omp parallel") != 0) return pragma;
+    std::string result = pragma;
+    size_t schedule = result.find(" schedule(");
+    if (schedule != std::string::npos) {
+        size_t end = result.find(')', schedule);
+        result.replace(schedule, end + 1 - schedule, " schedule(static)");
+    }
+    return result + " proc_bind(" + procBind + ")";
+}
+
+// NUMA mode with loops split across ranks: each rank's compute loops work on the
+// block [_my_start, _my_end), so the initialization touches that block with the
+// same static thread split first and the rest of the range after it
+static std::string buildRankBlockFirstTouch(const LoopInfo& loop, const std::string& pragma,
+                                            const std::string& indentation) {
+    const std::string& in = indentation;
+    const std::string& var = loop.loop_variable;
+    std::string body = loop.source_code.substr(loop.body_offset);
+    for (size_t nl = body.find('\n'); nl != std::string::npos; nl = body.find('\n', nl + 5)) {
+        body.insert(nl + 1, "    ");
+    }
+    auto header = [&](const std::string& from, const std::string& to) {
+        return "for (" + loop.loop_variable_type + " " + var + " = " + from + "; " + var + " < " + to + "; " +
+               var + " += _loop_step) ";
+    };
+    std::stringstream code;
+    code << "{\n";
+    code << in << "    int _mpi_rank, _mpi_size;\n";
+    code << in << "    MPI_Comm_rank(MPI_COMM_WORLD, &_mpi_rank);\n";
+    code << in << "    MPI_Comm_size(MPI_COMM_WORLD, &_mpi_size);\n";
+    code << in << "    long _loop_start = " << loop.start_expr << ";\n";
+    code << in << "    long _loop_end = " << loop.end_expr << ";\n";
+    code << in << "    long _loop_step = " << loop.step_expr << ";\n";
+    code << in << "    long _total_iters = (_loop_end - _loop_start + _loop_step - 1) / _loop_step;\n";
+    code << in << "    if (_total_iters < 0) _total_iters = 0;\n";
+    code << in << "    long _chunk_size = _total_iters / _mpi_size;\n";
+    code << in << "    long _remainder = _total_iters % _mpi_size;\n";
+    code << in << "    long _my_start_iter = _mpi_rank * _chunk_size + (_mpi_rank < _remainder ? _mpi_rank : _remainder);\n";
+    code << in << "    long _my_count = _chunk_size + (_mpi_rank < _remainder ? 1 : 0);\n";
+    code << in << "    long _my_start = _loop_start + _my_start_iter * _loop_step;\n";
+    code << in << "    long _my_end = _my_start + _my_count * _loop_step;\n";
+    code << in << "    // This rank's block, split over the threads like the compute loops\n";
+    code << in << "    " << pragma << "\n";
+    code << in << "    " << header("_my_start", "_my_end") << body << "\n";
+    code << in << "    // Elements the other ranks compute on\n";
+    code << in << "    " << pragma << "\n";
+    code << in << "    " << header("_loop_start", "_my_start") << body << "\n";
+    code << in << "    " << pragma << "\n";
+    code << in << "    " << header("_my_end", "_loop_end") << body << "\n";
+    code << in << "}";
+    return code.str();
+}
+
+// Contiguous copy of one struct field, indexed like the container
+static std::string soaBuffer(const SoACandidate& candidate, const std::string& field) {
+    return "_soa_" + candidate.container + "_" + field;
+}
+
+// Structure-of-arrays copies for --soa: every field the loop touches gets its own
+// contiguous buffer, gathered from the structs before the enclosing repeat loop
+// and, for written fields, scattered back after it
+static void buildSoACopies(const LoopInfo& loop, const std::string& indentation,
+                           std::string& gather, std::string& scatter) {
+    const std::string& in = indentation;
+    std::stringstream before, after;
+    for (const auto& candidate : loop.soa_candidates) {
+        std::string header = "for (long _soa_k = 0; _soa_k < (long)(" + candidate.length_expr + "); _soa_k++) {\n";
+        
+        bool anyWritten = false;
+        for (const auto& field : candidate.fields) {
+            before << in << "    std::vector<" << field.type << "> " << soaBuffer(candidate, field.name)
+                   << "((size_t)(" << candidate.length_expr << "));\n";
+            anyWritten = anyWritten || field.written;
+        }
+        before << in << "    #pragma omp parallel for simd schedule(static)\n";
+        before << in << "    " << header;
+        for (const auto& field : candidate.fields) {
+            before << in << "        " << soaBuffer(candidate, field.name) << "[_soa_k] = "
+                   << candidate.container << "[_soa_k]." << field.name << ";\n";
         }
+        before << in << "    }\n";
+        
+        if (!anyWritten) continue;
+        after << in << "    #pragma omp parallel for simd schedule(static)\n";
+        after << in << "    " << header;
+        for (const auto& field : candidate.fields) {
+            if (!field.written) continue;
+            after << in << "        " << candidate.container << "[_soa_k]." << field.name << " = "
+                  << soaBuffer(candidate, field.name) << "[_soa_k];\n";
+        }
+        after << in << "    }\n";
     }
+    gather = before.str();
+    scatter = after.str();
+}
+
+// Counter-based random numbers (Philox4x32-10) replacing rand() in parallel loops.
+// A draw is a pure function of the function's call number, the call site and the
+// iteration, so results do not depend on how iterations are split across threads
+// and ranks, and there is no per-thread state to seed. The call number is the
+// sequence number main gives the call on every rank (high half) and the calls
+// made during it in turn (low half), so it does not depend on the rank that runs
+// the call either.
+static const char* COUNTER_RAND_HELPER =
+    "static unsigned long long _rng_main_call = 0;\n"
+    "static unsigned long long _rng_calls_of = 0, _rng_nested_calls = 0;\n"
+    "static inline unsigned long long _rng_next_call() {\n"
+    "    unsigned long long call;\n"
+    "    #pragma omp critical(_rng_next_call)\n"
+    "    {\n"
+    "        if (_rng_calls_of != _rng_main_call) {\n"
+    "            _rng_calls_of = _rng_main_call;\n"
+    "            _rng_nested_calls = 0;\n"
+    "        }\n"
+    "        call = (_rng_main_call << 32) | _rng_nested_calls++;\n"
+    "    }\n"
+    "    return call;\n"
+    "}\n"
+    "static inline int _counter_rand(unsigned int _fn, unsigned long long _call, unsigned int _site,\n"
+    "                                unsigned long long _iter, unsigned int _draw) {\n"
+    "    unsigned int c0 = (unsigned int)_iter, c1 = (unsigned int)(_iter >> 32) ^ (unsigned int)(_call >> 32);\n"
+    "    unsigned int c2 = _draw, c3 = _site;\n"
+    "    unsigned int k0 = _fn, k1 = (unsigned int)_call;\n"
+    "    for (int round = 0; round < 10; round++) {\n"
+    "        unsigned long long p0 = 0xD2511F53ull * c0;\n"
+    "        unsigned long long p1 = 0xCD9E8D57ull * c2;\n"
+    "        c0 = (unsigned int)(p1 >> 32) ^ c1 ^ k0;\n"
+    "        c2 = (unsigned int)(p0 >> 32) ^ c3 ^ k1;\n"
+    "        c1 = (unsigned int)p1;\n"
+    "        c3 = (unsigned int)p0;\n"
+    "        k0 += 0x9E3779B9u;\n"
+    "        k1 += 0xBB67AE85u;\n"
+    "    }\n"
+    "    return (int)(c0 % ((unsigned int)RAND_MAX + 1u));\n"
+    "}\n";
+
+// Key of the generated function's random stream (FNV-1a of its name)
+static unsigned int counterRandFunctionId(const std::string& name) {
+    unsigned int hash = 2166136261u;
+    for (unsigned char c : name) {
+        hash = (hash ^ c) * 16777619u;
+    }
+    return hash;
+}
+
+// rand() calls of a for loop become counter-based draws indexed by the loop
+// variable, with one site number per call. A braced body also counts each site's
+// draws within the iteration, for calls that run more than once per iteration.
+static void counterRandEdits(const LoopInfo& loop, unsigned loopIndex, unsigned int functionId,
+                             std::vector<BodyEdit>& edits) {
+    const std::string& text = loop.source_code;
+    size_t sites = loop.rand_ranges.size();
+    if (loop.body_offset >= text.size()) return;
+    std::string counters = "unsigned int _rng_draw[" + std::to_string(sites) + "] = {};";
+    if (text[loop.body_offset] == '{') {
+        size_t first = text.find_first_not_of(" \t\n", loop.body_offset + 1);
+        if (first == std::string::npos) return;
+        bool ownLine = text.find('\n', loop.body_offset) < first;
+        edits.push_back({loop.body_offset + 1, 0, ownLine ? "\n" + lineIndentation(text, first) + counters
+                                                          : " " + counters});
+    } else {
+        // An unbraced body (an inner loop drawing many numbers) gets a block for its
+        // counters; the statement's own ';' follows the loop text as an empty statement
+        edits.push_back({loop.body_offset, 0, "{ " + counters + " "});
+        edits.push_back({text.size(), 0, "; }"});
+    }
+    for (size_t k = 0; k < sites; k++) {
+        std::string draw = "_rng_draw[" + std::to_string(k) + "]++";
+        edits.push_back({loop.body_offset + loop.rand_ranges[k].first, loop.rand_ranges[k].second,
+                         "_counter_rand(" + std::to_string(functionId) + "u, _rng_call, " +
+                         std::to_string((loopIndex << 16) | k) + "u, (unsigned long long)(" + loop.loop_variable +
+                         "), " + draw + ")"});
+    }
+}
+
+void HybridParallelizer::writeParallelizedFunctionBody(llvm::raw_ostream& out, const FunctionInfo& info) {
+    const std::string& body = info.original_body;
     
-    // Process loops from last to first to avoid position shifts when inserting
-    std::vector<LoopInfo> sortedLoops = info.loops;
-    std::sort(sortedLoops.begin(), sortedLoops.end(), 
-              [](const LoopInfo& a, const LoopInfo& b) {
-                  if (a.start_line != b.start_line) return a.start_line > b.start_line;
-                  return a.start_col > b.start_col;
-              });
+    // If loop parallelization is disabled, write the original body
+    if (!enableLoopParallelization || info.loops.empty()) {
+        out << body;
+        return;
+    }
     
-    // Remove duplicates based on source code content
-    std::set<std::string> processedSourceCode;
+    // Every loop is rewritten in place at the offset the loop analyzer recorded,
+    // and all edits are applied to the original body in one pass
+    std::vector<BodyEdit> edits;
+    std::set<size_t> processedOffsets;
+    std::set<size_t> soaRepeatLoops;
+    bool usesCounterRand = false;
     
-    for (const auto& loop : sortedLoops) {
+    for (size_t loopIndex = 0; loopIndex < info.loops.size(); loopIndex++) {
+        const LoopInfo& loop = info.loops[loopIndex];
         if (!loop.parallelizable || loop.pragma_text.empty()) {
             continue;
         }
         
-        // Skip if we've already processed this exact loop
-        if (processedSourceCode.count(loop.source_code)) {
+        // The recorded position must still hold the loop's source text
+        size_t loopPos = loop.function_offset;
+        if (loopPos == std::string::npos || body.compare(loopPos, loop.source_code.length(), loop.source_code) != 0) {
             continue;
         }
-        processedSourceCode.insert(loop.source_code);
         
-        // Find the loop in the body - be more flexible since thread-safe replacements may have modified the exact source
-        // Try exact match first, then fall back to pattern matching
-        size_t loopPos = parallelizedBody.find(loop.source_code);
-        if (loopPos == std::string::npos && !loop.loop_variable.empty()) {
-            // Try to find by loop variable pattern: "for (type var = ..."
-            std::string loopPattern = "for (" + loop.loop_variable;
-            loopPos = parallelizedBody.find(loopPattern);
-            if (loopPos == std::string::npos) {
-                // Try more general pattern: "for (int " + loop_variable
-                loopPattern = "for (int " + loop.loop_variable;
-                loopPos = parallelizedBody.find(loopPattern);
-            }
-        }
-        if (loopPos == std::string::npos) {
+        // The analyzer reports loops visited twice; keep the first
+        if (!processedOffsets.insert(loopPos).second) {
             continue;
         }
         
-        // Check if there's already a pragma right before this loop
-        size_t lineStart = parallelizedBody.rfind('\n', loopPos);
-        if (lineStart == std::string::npos) lineStart = 0;
-        else lineStart++;
+        std::string indentation = lineIndentation(body, loopPos);
+        std::string loopText = loop.source_code;
+        std::string loopBody = loop.source_code.substr(std::min<size_t>(loop.body_offset, loop.source_code.length()));
+        
+        std::string timerName = info.name + ":" + std::to_string(loop.start_line);
+        
+        // Early-exit searches are replaced by a speculative probe plus serial replay
+        if (loop.is_search_loop) {
+            std::string search = buildSpeculativeSearch(loop, indentation, loop.is_mpi_parallelizable);
+            if (emitTimers && loop.is_mpi_parallelizable) {
+                search = timeBlock(search, addTimerRegion(timerName + " search"), indentation);
+            }
+            edits.push_back({loopPos, loop.source_code.length(), search});
+            continue;
+        }
+        
+        // Prefix sums get their scan directive (and block offsets across ranks)
+        if (loop.is_scan_loop) {
+            std::string scan = buildPrefixScan(loop, indentation, loop.is_mpi_parallelizable);
+            if (emitTimers && loop.is_mpi_parallelizable) {
+                scan = timeBlock(scan, addTimerRegion(timerName + " scan"), indentation);
+            }
+            edits.push_back({loopPos, loop.source_code.length(), scan});
+            continue;
+        }
+        
+        // --plan: loops too small for threads stay serial or run as SIMD, and
+        // MPI-splittable loops too small for the collectives run on threads only
+        RegionPlan plan = planRegions ? planLoop(loop, machineModel) : RegionPlan();
+        if (planRegions && plan.mode == RegionPlan::Serial) {
+            continue;
+        }
+        bool splitLoop = loop.is_mpi_parallelizable && (!planRegions || plan.mode == RegionPlan::MPI);
+        
+        // while/do-while loops with an inferred iteration space
+        std::vector<BodyEdit> sourceEdits;
+        if (loop.type != "for") {
+            LoopInfo converted = loop;
+            converted.body_source = insertDirectives(loop.body_source, 0, loop.atomic_offsets, "#pragma omp atomic");
+            loopText = buildCanonicalLoop(converted, loop.start_expr, false);
+            loopBody = converted.body_source;
+        } else if (!loop.atomic_offsets.empty()) {
+            // Indirect updates of large or unsized arrays stay shared, one element at a time
+            for (unsigned offset : loop.atomic_offsets) {
+                if (loop.body_offset + offset < loop.source_code.size()) {
+                    sourceEdits.push_back(directiveEdit(loop.source_code, loop.body_offset + offset, "#pragma omp atomic"));
+                }
+            }
+        }
+        
+        // rand() draws from the counter-based generator, the same for any thread or rank count
+        if (loop.type == "for" && !loop.rand_ranges.empty()) {
+            counterRandEdits(loop, (unsigned)loopIndex, counterRandFunctionId(info.name), sourceEdits);
+            usesCounterRand = true;
+        }
+        
+        // Invariant expressions of an MPI-split loop (sqrt(n), v.size()) are read
+        // from constants its preamble computes once
+        bool hoistInvariants = splitLoop && loop.type == "for" && loop.atomic_offsets.empty() &&
+                               !loop.invariants.empty();
+        if (hoistInvariants) {
+            for (size_t k = 0; k < loop.invariants.size(); k++) {
+                for (const auto& range : loop.invariants[k].ranges) {
+                    sourceEdits.push_back({loop.body_offset + range.first, range.second, "_inv_" + std::to_string(k)});
+                }
+            }
+        }
+        
+        // --soa: struct fields accessed at the loop index are read from contiguous
+        // copies, so the loop can run as omp simd with unit-stride loads. The copies
+        // are made once around the enclosing repeat loop, one set per repeat loop.
+        std::string pragmaText = numaPragma(planRegions ? plan.pragma : loop.pragma_text, numaProcBind);
+        bool useSoA = enableSoATransform && !splitLoop && loop.type == "for" && loop.atomic_offsets.empty() &&
+                      !loop.soa_candidates.empty() && !precededByPragma(body, loopPos) &&
+                      loop.soa_copy_offset != std::string::npos &&
+                      loop.soa_copy_offset + loop.soa_copy_length <= body.size() &&
+                      soaRepeatLoops.insert(loop.soa_copy_offset).second;
+        if (useSoA) {
+            for (const auto& candidate : loop.soa_candidates) {
+                for (size_t k = 0; k < candidate.access_ranges.size(); k++) {
+                    sourceEdits.push_back({loop.body_offset + candidate.access_ranges[k].first,
+                                           candidate.access_ranges[k].second,
+                                           soaBuffer(candidate, candidate.access_fields[k]) + "[" +
+                                           loop.loop_variable + "]"});
+                }
+            }
+            const std::string parallelFor = "#pragma omp parallel for";
+            if (pragmaText.compare(0, parallelFor.length(), parallelFor) == 0) {
+                pragmaText.insert(parallelFor.length(), " simd");
+            }
+        }
+        if (!sourceEdits.empty()) {
+            loopText = applyBodyEdits(loop.source_code, sourceEdits);
+            loopBody = loopText.substr(loop.body_offset);
+        }
         
         // NEW: MPI Loop Parallelization
-        if (loop.is_mpi_parallelizable) {
-             size_t bodyStart = parallelizedBody.find('{', loopPos);
-             if (bodyStart != std::string::npos) {
-                 size_t loopEnd = findMatchingBrace(parallelizedBody, bodyStart);
-                 if (loopEnd != std::string::npos) {
-                     std::string existingBody = parallelizedBody.substr(bodyStart, loopEnd - bodyStart + 1);
-                     
-                     std::stringstream mpiCode;
-                     mpiCode << "{\n";
-                     mpiCode << "    // Hybrid MPI+OpenMP Parallel Loop\n";
-                     mpiCode << "    int _mpi_rank, _mpi_size;\n";
-                     mpiCode << "    MPI_Comm_rank(MPI_COMM_WORLD, &_mpi_rank);\n";
-                     mpiCode << "    MPI_Comm_size(MPI_COMM_WORLD, &_mpi_size);\n";
-                     
-                     mpiCode << "    long _loop_start = " << loop.start_expr << ";\n";
-                     mpiCode << "    long _loop_end = " << loop.end_expr << ";\n";
-                     mpiCode << "    long _loop_step = " << loop.step_expr << ";\n";
-                     // Handle both positive and negative step loops
-                     mpiCode << "    bool _is_negative_step = (_loop_step < 0);\n";
-                     mpiCode << "    long _abs_step = _is_negative_step ? -_loop_step : _loop_step;\n";
-                     mpiCode << "    long _total_iters = _is_negative_step ? (_loop_start - _loop_end) / _abs_step : (_loop_end - _loop_start) / _loop_step;\n";
-                     mpiCode << "    long _chunk_size = _total_iters / _mpi_size;\n";
-                     mpiCode << "    long _remainder = _total_iters % _mpi_size;\n";
-                     mpiCode << "    long _my_start_iter = _mpi_rank * _chunk_size + (_mpi_rank < _remainder ? _mpi_rank : _remainder);\n";
-                     mpiCode << "    long _my_count = _chunk_size + (_mpi_rank < _remainder ? 1 : 0);\n";
-                     mpiCode << "    long _my_start = _loop_start + _my_start_iter * _loop_step;\n";
-                     mpiCode << "    long _my_end = _my_start + _my_count * _loop_step;\n";
-                     
-                     // Generate two separate loops for positive/negative step (OpenMP doesn't allow ternary in loop condition)
-                     mpiCode << "    if (_is_negative_step) {\n";
-                     mpiCode << "        " << loop.pragma_text << "\n";
-                     mpiCode << "        for (";
-                     if (!loop.loop_variable_type.empty()) {
-                         mpiCode << loop.loop_variable_type << " ";
-                     }
-                     mpiCode << loop.loop_variable << " = _my_start; "
-                             << loop.loop_variable << " > _my_end; "
-                             << loop.loop_variable << " += " << loop.step_expr << ") ";
-                     mpiCode << existingBody << "\n";
-                     mpiCode << "    } else {\n";
-                     mpiCode << "        " << loop.pragma_text << "\n";
-                     mpiCode << "        for (";
-                     if (!loop.loop_variable_type.empty()) {
-                         mpiCode << loop.loop_variable_type << " ";
-                     }
-                     mpiCode << loop.loop_variable << " = _my_start; "
-                             << loop.loop_variable << " < _my_end; "
-                             << loop.loop_variable << " += " << loop.step_expr << ") ";
-                     mpiCode << existingBody << "\n";
-                     mpiCode << "    }\n";
-                     
-                     for (const auto& var : loop.reduction_vars) {
-                         std::string varType = "double"; // Default
-                         if (localVariables.count(var)) {
-                             varType = localVariables.at(var).type;
-                         }
-                         
-                         std::string mpiType = TypeMapper::getMPIDatatype(varType);
-                         if (mpiType.empty()) mpiType = "MPI_DOUBLE"; // Fallback
-                         
-                         std::string mpiOp = getMPIOp(loop.reduction_op);
-                         
-                         // Use separate local/global buffers to avoid double-counting with MPI_IN_PLACE
-                         mpiCode << "    " << varType << " _local_" << var << " = " << var << ";\n";
-                         mpiCode << "    " << varType << " _global_" << var << ";\n";
-                         mpiCode << "    MPI_Allreduce(&_local_" << var << ", &_global_" << var << ", 1, " 
-                                 << mpiType << ", " << mpiOp << ", MPI_COMM_WORLD);\n";
-                         mpiCode << "    " << var << " = _global_" << var << ";\n";
-                     }
-                     
-                     mpiCode << "    }\n";
-                     
-                     parallelizedBody.replace(loopPos, loopEnd - loopPos + 1, mpiCode.str());
-                     continue; 
-                 }
-             }
-        }
-
-        // Look for existing pragma in the 5 lines before the loop
-        size_t searchStart = lineStart > 200 ? lineStart - 200 : 0;
-        std::string beforeLoop = parallelizedBody.substr(searchStart, loopPos - searchStart);
-        if (beforeLoop.find("#pragma omp parallel for") != std::string::npos) {
-            continue; // Already has a pragma
+        if (splitLoop) {
+            // A single-statement body lost its semicolon to the statement's source range
+            if (loopBody.empty()) {
+                continue;
+            }
+            std::string existingBody = loopBody;
+            size_t replacedLength = loop.source_code.length();
+            if (existingBody[0] != '{') {
+                existingBody += ";";
+                if (body.compare(loopPos + replacedLength, 1, ";") == 0) replacedLength++;
+            }
+            
+            std::stringstream mpiCode;
+            mpiCode << "{\n";
+            mpiCode << "    // Hybrid MPI+OpenMP Parallel Loop\n";
+            mpiCode << "    int _mpi_rank, _mpi_size;\n";
+            mpiCode << "    MPI_Comm_rank(MPI_COMM_WORLD, &_mpi_rank);\n";
+            mpiCode << "    MPI_Comm_size(MPI_COMM_WORLD, &_mpi_size);\n";
+            
+            mpiCode << "    long _loop_start = " << loop.start_expr << ";\n";
+            mpiCode << "    long _loop_end = " << loop.end_expr << ";\n";
+            mpiCode << "    long _loop_step = " << loop.step_expr << ";\n";
+            // Handle both positive and negative step loops
+            mpiCode << "    bool _is_negative_step = (_loop_step < 0);\n";
+            mpiCode << "    long _abs_step = _is_negative_step ? -_loop_step : _loop_step;\n";
+            mpiCode << "    long _total_iters = _is_negative_step ? (_loop_start - _loop_end + _abs_step - 1) / _abs_step : (_loop_end - _loop_start + _loop_step - 1) / _loop_step;\n";
+            mpiCode << "    if (_total_iters < 0) _total_iters = 0;\n";
+            mpiCode << "    long _chunk_size = _total_iters / _mpi_size;\n";
+            mpiCode << "    long _remainder = _total_iters % _mpi_size;\n";
+            mpiCode << "    long _my_start_iter = _mpi_rank * _chunk_size + (_mpi_rank < _remainder ? _mpi_rank : _remainder);\n";
+            mpiCode << "    long _my_count = _chunk_size + (_mpi_rank < _remainder ? 1 : 0);\n";
+            mpiCode << "    long _my_start = _loop_start + _my_start_iter * _loop_step;\n";
+            mpiCode << "    long _my_end = _my_start + _my_count * _loop_step;\n";
+            // --plan: below the break-even trip count every rank runs the whole loop
+            // on its threads and the collectives are skipped
+            bool runtimeSplit = planRegions && plan.runtimeGuard;
+            if (runtimeSplit) {
+                std::string reduceBytes = "0.0";
+                for (const auto& var : loop.reduction_vars) reduceBytes += " + sizeof(" + var + ")";
+                for (const auto& var : loop.lastprivate_vars) reduceBytes += " + sizeof(" + var + ")";
+                for (const auto& array : loop.array_reductions) {
+                    reduceBytes += " + (double)(" + array.length_expr + ") * sizeof(" + array.name + "[0])";
+                }
+                mpiCode << "    bool _split = _plan_split((double)_total_iters, " << plan.iterationNs << ", "
+                        << reduceBytes << ", _mpi_size);\n";
+                mpiCode << "    if (!_split) {\n";
+                mpiCode << "        _my_start = _loop_start;\n";
+                mpiCode << "        _my_end = _loop_start + _total_iters * _loop_step;\n";
+                mpiCode << "    }\n";
+            }
+            std::string ranksSplit = runtimeSplit ? "_split && " : "";
+            if (hoistInvariants) {
+                mpiCode << "    // Loop-invariant expressions, evaluated once instead of in every iteration\n";
+                for (size_t k = 0; k < loop.invariants.size(); k++) {
+                    mpiCode << "    const auto _inv_" << k << " = " << loop.invariants[k].expr << ";\n";
+                }
+            }
+            
+            // --emit-timers: this rank's share of the loop, then the collectives
+            int loopTimer = emitTimers ? addTimerRegion(timerName + " loop") : -1;
+            if (emitTimers) mpiCode << timerStart(loopTimer, "    ");
+            
+            // Every rank updates the whole array; only rank 0 keeps the prior
+            // contents so the final sum counts them once
+            for (const auto& array : loop.array_reductions) {
+                mpiCode << "    if (" << ranksSplit << "_mpi_rank != 0) {\n";
+                mpiCode << "        for (long _k = 0; _k < (long)(" << array.length_expr << "); _k++) "
+                        << array.name << "[_k] = 0;\n";
+                mpiCode << "    }\n";
+            }
+            
+            // Generate two separate loops for positive/negative step (OpenMP doesn't allow ternary in loop condition)
+            mpiCode << "    if (_is_negative_step) {\n";
+            mpiCode << "        " << pragmaText << "\n";
+            mpiCode << "        for (";
+            if (!loop.loop_variable_type.empty() && loop.type == "for") {
+                mpiCode << loop.loop_variable_type << " ";
+            }
+            mpiCode << loop.loop_variable << " = _my_start; "
+                    << loop.loop_variable << " > _my_end; "
+                    << loop.loop_variable << " += " << loop.step_expr << ") ";
+            mpiCode << existingBody << "\n";
+            mpiCode << "    } else {\n";
+            mpiCode << "        " << pragmaText << "\n";
+            mpiCode << "        for (";
+            if (!loop.loop_variable_type.empty() && loop.type == "for") {
+                mpiCode << loop.loop_variable_type << " ";
+            }
+            mpiCode << loop.loop_variable << " = _my_start; "
+                    << loop.loop_variable << " < _my_end; "
+                    << loop.loop_variable << " += " << loop.step_expr << ") ";
+            mpiCode << existingBody << "\n";
+            mpiCode << "    }\n";
+            if (emitTimers) mpiCode << timerStop(loopTimer, "    ");
+            
+            // A converted while loop's induction variable outlives the loop
+            if (loop.type != "for") {
+                mpiCode << "    " << loop.loop_variable << " = _loop_start + _total_iters * _loop_step;\n";
+            }
+            
+            bool hasCollectives = !loop.lastprivate_vars.empty() || !loop.array_reductions.empty() ||
+                                  !loop.reduction_vars.empty();
+            int collectiveTimer = emitTimers && hasCollectives ? addTimerRegion(timerName + " allreduce") : -1;
+            if (collectiveTimer >= 0) mpiCode << timerStart(collectiveTimer, "    ");
+            
+            // Lastprivate temporaries come from the rank that ran the final iteration
+            if (!loop.lastprivate_vars.empty()) {
+                mpiCode << "    if (" << ranksSplit << "_total_iters > 0) {\n";
+                mpiCode << "        int _last_owner = _total_iters >= _mpi_size ? _mpi_size - 1 : (int)_total_iters - 1;\n";
+                for (const auto& var : loop.lastprivate_vars) {
+                    mpiCode << "        MPI_Bcast(&" << var << ", sizeof(" << var << "), MPI_BYTE, _last_owner, MPI_COMM_WORLD);\n";
+                }
+                mpiCode << "    }\n";
+            }
+            
+            std::string in = runtimeSplit ? "        " : "    ";
+            bool hasReductions = !loop.array_reductions.empty() || !loop.reduction_vars.empty();
+            if (runtimeSplit && hasReductions) mpiCode << "    if (_split) {\n";
+            
+            // One collective per array instead of one per element
+            for (const auto& array : loop.array_reductions) {
+                std::string buffer = array.is_container ? array.name + ".data()" : array.name;
+                mpiCode << in << "MPI_Allreduce(MPI_IN_PLACE, " << buffer << ", (int)(" << array.length_expr << "), "
+                        << TypeMapper::getMPIDatatype(array.element_type) << ", MPI_SUM, MPI_COMM_WORLD);\n";
+            }
+            
+            for (const auto& var : loop.reduction_vars) {
+                // The analyzer's canonical type is valid C++ for the copies as well
+                std::string varType = "double"; // Default
+                if (loop.reduction_var_types.count(var)) {
+                    varType = TypeMapper::normalizeType(loop.reduction_var_types.at(var));
+                } else if (localVariables.count(var)) {
+                    varType = transferType(localVariables.at(var).type, localVariables.at(var).canonicalType);
+                }
+                
+                std::string mpiType = TypeMapper::getMPIDatatype(varType);
+                if (mpiType.empty()) mpiType = "MPI_DOUBLE"; // Fallback
+                
+                std::string mpiOp = getMPIOp(loop.reduction_op);
+                
+                // Use separate local/global buffers to avoid double-counting with MPI_IN_PLACE
+                mpiCode << in << varType << " _local_" << var << " = " << var << ";\n";
+                mpiCode << in << varType << " _global_" << var << ";\n";
+                mpiCode << in << "MPI_Allreduce(&_local_" << var << ", &_global_" << var << ", 1, " 
+                        << mpiType << ", " << mpiOp << ", MPI_COMM_WORLD);\n";
+                mpiCode << in << var << " = _global_" << var << ";\n";
+            }
+            if (runtimeSplit && hasReductions) mpiCode << "    }\n";
+            if (collectiveTimer >= 0) mpiCode << timerStop(collectiveTimer, "    ");
+            
+            mpiCode << "    }\n";
+            
+            edits.push_back({loopPos, replacedLength, mpiCode.str()});
+            continue;
+        }
+        
+        // The repeat loop runs inside a block holding the copies
+        if (useSoA) {
+            std::string repeatIndentation = lineIndentation(body, loop.soa_copy_offset);
+            std::string soaGather, soaScatter;
+            buildSoACopies(loop, repeatIndentation, soaGather, soaScatter);
+            edits.push_back({loop.soa_copy_offset, 0, "{\n" + soaGather + repeatIndentation});
+            edits.push_back({loop.soa_copy_offset + loop.soa_copy_length, 0,
+                             "\n" + soaScatter + repeatIndentation + "}"});
+        }
+        
+        if (loopText != loop.source_code) {
+            edits.push_back({loopPos, loop.source_code.length(), loopText});
         }
         
-        // Find the actual "for" keyword position to get correct indentation
-        size_t forPos = parallelizedBody.find("for", loopPos);
-        if (forPos == std::string::npos || forPos > loopPos + loop.source_code.length()) {
+        // Source that already carries a pragma for this loop keeps it
+        if (precededByPragma(body, loopPos)) {
             continue;
         }
         
-        // Find the line start for the "for" statement
-        size_t forLineStart = parallelizedBody.rfind('\n', forPos);
-        if (forLineStart == std::string::npos) forLineStart = 0;
-        else forLineStart++;
+        // Pragma on its own line, with the same indentation as the loop
+        edits.push_back(directiveEdit(body, loopPos, pragmaText));
+    }
+    
+    // Each call of the function draws from its own random stream
+    if (usesCounterRand) {
+        size_t bracePos = body.find('{');
+        if (bracePos != std::string::npos) {
+            edits.push_back({bracePos + 1, 0, "\n    unsigned long long _rng_call = _rng_next_call();"});
+        }
+    }
+    
+    writeBodyEdits(out, body, std::move(edits));
+}
+
+// Recursion depth below which recursive calls are spawned as deferred tasks
+static const int TASK_DEPTH_CUTOFF = 8;
+
+std::string HybridParallelizer::generateTaskParallelFunction(const FunctionInfo& info) {
+    const std::string& body = info.original_body;
+    const std::string taskName = info.name + "_task";
+    const std::string cutoff = std::to_string(TASK_DEPTH_CUTOFF);
+    const std::string taskClauses = "if(_task_depth < " + cutoff + ") final(_task_depth >= " + cutoff + ")";
+    
+    // Locate the function name in the signature (followed by its parameter list)
+    std::string signature = info.function_signature;
+    size_t namePos = std::string::npos;
+    for (size_t pos = signature.find(info.name); pos != std::string::npos; pos = signature.find(info.name, pos + 1)) {
+        size_t next = signature.find_first_not_of(" \t\n", pos + info.name.length());
+        bool startsWord = pos == 0 || !(std::isalnum(signature[pos - 1]) || signature[pos - 1] == '_');
+        if (startsWord && next != std::string::npos && signature[next] == '(') {
+            namePos = pos;
+            break;
+        }
+    }
+    size_t paramsOpen = namePos == std::string::npos ? std::string::npos : signature.find('(', namePos);
+    size_t paramsClose = signature.rfind(')');
+    if (paramsOpen == std::string::npos || paramsClose == std::string::npos || paramsClose < paramsOpen) {
+        return "";
+    }
+    
+    // Helper signature: renamed, with the recursion depth as trailing parameter
+    std::string helperSignature = signature.substr(0, paramsClose);
+    if (info.parameter_names.empty()) {
+        helperSignature = signature.substr(0, paramsOpen + 1) + "int _task_depth";
+    } else {
+        helperSignature += ", int _task_depth";
+    }
+    helperSignature += signature.substr(paramsClose);
+    helperSignature.insert(namePos + info.name.length(), "_task");
+    
+    // Recursive call routed to the helper with the depth threaded through
+    auto rewriteCall = [&](const RecursiveCallSite& site) {
+        size_t nameEnd = site.callee_offset + info.name.length();
+        std::string call = taskName + body.substr(nameEnd, site.call_end_offset - nameEnd);
+        call += site.num_args > 0 ? ", _task_depth + 1)" : "_task_depth + 1)";
+        return call;
+    };
+    
+    std::vector<BodyEdit> edits;
+    std::map<int, std::vector<const RecursiveCallSite*>> groups;
+    for (const auto& site : info.recursive_calls) {
+        if (site.task_group >= 0) {
+            groups[site.task_group].push_back(&site);
+        } else {
+            edits.push_back({site.call_start_offset, site.call_end_offset - site.call_start_offset + 1, rewriteCall(site)});
+        }
+    }
+    
+    for (const auto& group : groups) {
+        const std::vector<const RecursiveCallSite*>& members = group.second;
+        const RecursiveCallSite& first = *members.front();
+        std::string indentation = lineIndentation(body, first.stmt_start_offset);
         
-        // Get indentation from the "for" line (not the loop body)
-        std::string indentation = "";
-        for (size_t i = forLineStart; i < forPos && (parallelizedBody[i] == ' ' || parallelizedBody[i] == '\t'); i++) {
-            indentation += parallelizedBody[i];
+        if (first.form == "return") {
+            // Hoist the calls into task-computed temporaries ahead of the return,
+            // inside a new block when the return is the whole branch of an if/else
+            size_t stmtEnd = body.find(';', members.back()->call_end_offset);
+            bool braced = first.unbraced_branch && stmtEnd != std::string::npos;
+            std::stringstream prelude;
+            if (braced) {
+                prelude << "{\n";
+                indentation += "    ";
+                prelude << indentation;
+            }
+            std::vector<std::string> temps;
+            for (size_t k = 0; k < members.size(); ++k) {
+                temps.push_back("_task_r" + std::to_string(group.first) + "_" + std::to_string(k));
+                prelude << members[k]->result_type << " " << temps[k] << ";\n" << indentation;
+            }
+            for (size_t k = 0; k < members.size(); ++k) {
+                prelude << "#pragma omp task shared(" << temps[k] << ") " << taskClauses << "\n" << indentation;
+                prelude << temps[k] << " = " << rewriteCall(*members[k]) << ";\n" << indentation;
+            }
+            prelude << "#pragma omp taskwait\n" << indentation;
+            edits.push_back({first.stmt_start_offset, 0, prelude.str()});
+            for (size_t k = 0; k < members.size(); ++k) {
+                edits.push_back({members[k]->call_start_offset,
+                                 members[k]->call_end_offset - members[k]->call_start_offset + 1, temps[k]});
+            }
+            if (braced) {
+                edits.push_back({stmtEnd + 1, 0, "\n" + indentation.substr(4) + "}"});
+            }
+            continue;
+        }
+        
+        for (const RecursiveCallSite* site : members) {
+            std::string pragma = "#pragma omp task";
+            if (!site->result_variable.empty()) {
+                pragma += " shared(" + site->result_variable + ")";
+            }
+            pragma += " " + taskClauses;
+            
+            if (site->form == "decl") {
+                // Split "T x = f(...)" so the task assigns a variable of the enclosing scope
+                edits.push_back({site->stmt_start_offset, site->call_start_offset - site->stmt_start_offset,
+                                 site->result_type + " " + site->result_variable + ";\n" +
+                                 indentation + pragma + "\n" + indentation + site->result_variable + " = "});
+            } else {
+                edits.push_back({site->stmt_start_offset, 0, pragma + "\n" + indentation});
+            }
+            edits.push_back({site->call_start_offset, site->call_end_offset - site->call_start_offset + 1,
+                             rewriteCall(*site)});
         }
         
-        // Insert the pragma with the same indentation as the for loop
-        std::string pragmaLine = indentation + loop.pragma_text + "\n";
-        parallelizedBody.insert(forLineStart, pragmaLine);
+        // Join the group before any of the results is combined
+        size_t stmtEnd = body.find(';', members.back()->call_end_offset);
+        if (stmtEnd != std::string::npos) {
+            edits.push_back({stmtEnd + 1, 0, "\n" + indentation + "#pragma omp taskwait"});
+        }
+    }
+    
+    std::string args;
+    for (size_t i = 0; i < info.parameter_names.size(); ++i) {
+        if (i > 0) args += ", ";
+        args += info.parameter_names[i];
+    }
+    std::string helperCall = taskName + "(" + args + (args.empty() ? "" : ", ") + "0)";
+    bool isVoid = TypeMapper::normalizeType(info.return_type) == "void";
+    std::string assignResult = isVoid ? "" : "_task_result = ";
+    
+    std::stringstream code;
+    code << helperSignature << " " << applyBodyEdits(body, edits) << "\n\n";
+    code << "// Entry point: opens a parallel region unless called from one\n";
+    code << signature << " {\n";
+    if (!isVoid) {
+        code << "    " << info.return_type << " _task_result;\n";
+    }
+    code << "    if (omp_in_parallel()) {\n";
+    code << "        " << assignResult << helperCall << ";\n";
+    code << "    } else {\n";
+    code << "        #pragma omp parallel\n";
+    code << "        #pragma omp single\n";
+    code << "        " << assignResult << helperCall << ";\n";
+    code << "    }\n";
+    if (!isVoid) {
+        code << "    return _task_result;\n";
     }
+    code << "}";
     
-    return parallelizedBody;
+    return code.str();
 }
 
 // NEW: Generate main body preserving original structure
@@ -478,12 +1545,15 @@ std::string HybridParallelizer::generatePreservedMainBody() {
         body = body.substr(firstBrace + 1, lastBrace - firstBrace - 1);
     }
     
+    // Calls are numbered for the random streams of the functions they reach
+    bool numberCalls = enableLoopParallelization && usesCounterRand();
+    
     // Build set of functions that have internal MPI parallelization (should run on ALL ranks)
     std::set<std::string> mpiParallelizedFunctions;
     for (const auto& pair : functionInfo) {
-        if (pair.first != "main") {
+        if (pair.first != "main" && pair.second.defined_in.empty()) {
             for (const auto& loop : pair.second.loops) {
-                if (loop.is_mpi_parallelizable) {
+                if (splitsAcrossRanks(loop)) {
                     mpiParallelizedFunctions.insert(pair.first);
                     break;
                 }
@@ -499,6 +1569,26 @@ std::string HybridParallelizer::generatePreservedMainBody() {
             offsetToCallIndex.push_back({functionCalls[i].statementStartOffset, i});
         }
     }
+    
+    // NUMA mode: initialization loops in main run with the same static schedule as
+    // the compute loops, so each page is first touched by the thread that later
+    // works on it. They take part in the reverse-order pass as entries -(k + 1).
+    // When compute loops are split across ranks, the initialization follows the
+    // rank's block, which needs a for loop declaring its variable and counting up.
+    std::vector<const LoopInfo*> firstTouchLoops;
+    bool rankBlocks = usesRankSplit();
+    if (!numaProcBind.empty() && enableLoopParallelization && functionInfo.count("main")) {
+        for (const auto& loop : functionInfo.at("main").loops) {
+            bool blockable = loop.type == "for" && loop.is_canonical && loop.declares_loop_variable &&
+                             !loop.loop_variable_type.empty() && !loop.step_expr.empty() && loop.step_expr[0] != '-' &&
+                             loop.body_offset < loop.source_code.size();
+            if (loop.is_array_init && loop.parallelizable && !loop.pragma_text.empty() && (!rankBlocks || blockable) &&
+                loop.function_offset != std::string::npos && loop.function_offset > 0) {
+                firstTouchLoops.push_back(&loop);
+                offsetToCallIndex.push_back({(unsigned)loop.function_offset, -(int)firstTouchLoops.size()});
+            }
+        }
+    }
     std::sort(offsetToCallIndex.begin(), offsetToCallIndex.end(),
               [](const auto& a, const auto& b) { return a.first > b.first; });
     
@@ -520,15 +1610,36 @@ std::string HybridParallelizer::generatePreservedMainBody() {
         }
     }
     
-    // Replace each function call with parallelized version (in reverse order)
+    // Replace each function call with parallelized version. Edits refer to the
+    // original text and are applied together at the end.
+    std::vector<BodyEdit> edits;
+    
+    // Set-up and clean-up of repeated transfers around each loop that has them
+    std::map<const LoopInfo*, std::pair<std::string, std::string>> loopTransfers;
+    
     for (const auto& offsetPair : offsetToCallIndex) {
         unsigned offset = offsetPair.first;
         int callIdx = offsetPair.second;
-        const FunctionCall& call = functionCalls[callIdx];
         
         // Adjust offset since we removed the opening brace
         unsigned adjustedOffset = offset - 1;
         
+        if (callIdx < 0) {
+            const LoopInfo& loop = *firstTouchLoops[-callIdx - 1];
+            if (body.compare(adjustedOffset, loop.source_code.length(), loop.source_code) == 0 &&
+                !precededByPragma(body, adjustedOffset)) {
+                std::string pragma = numaPragma(loop.pragma_text, numaProcBind);
+                if (rankBlocks) {
+                    edits.push_back({adjustedOffset, loop.source_code.length(),
+                                     buildRankBlockFirstTouch(loop, pragma, lineIndentation(body, adjustedOffset))});
+                } else {
+                    edits.push_back(directiveEdit(body, adjustedOffset, pragma));
+                }
+            }
+            continue;
+        }
+        const FunctionCall& call = functionCalls[callIdx];
+        
         // Find the end of the statement (look for semicolon)
         size_t stmtEnd = body.find(';', adjustedOffset);
         if (stmtEnd == std::string::npos) {
@@ -550,48 +1661,107 @@ std::string HybridParallelizer::generatePreservedMainBody() {
         // Check if this function has internal MPI parallelization
         bool hasMpiParallelization = mpiParallelizedFunctions.count(call.functionName) > 0;
         
+        // Calls inside a loop repeat the same transfer on every iteration
+        const LoopInfo* loop = enclosingMainLoop(functionInfo, offset);
+        if (loop && body.compare(loop->function_offset - 1, loop->source_code.length(), loop->source_code) != 0) {
+            loop = nullptr;
+        }
+        std::string setup, transfer, teardown;
+        
+        // --emit-timers: the call, then the transfer of its result
+        std::string callTimerName = "call " + call.functionName + " (line " + std::to_string(call.lineNumber) + ")";
+        int callTimer = emitTimers ? addTimerRegion(callTimerName) : -1;
+        std::string startCall = emitTimers ? timerStart(callTimer, indentation) : "";
+        std::string stopCall = emitTimers ? timerStop(callTimer, indentation) : "";
+        
         // Generate replacement code based on parallelization strategy
         std::stringstream replacement;
+        if (numberCalls) {
+            replacement << indentation << "_rng_main_call++;  // Same on every rank, whichever runs the call\n";
+        }
         
         if (hasMpiParallelization) {
             // Function has internal MPI loops - run on ALL ranks
             if (call.hasReturnValue) {
                 replacement << indentation << "// MPI-parallelized: " << call.functionName << " (all ranks)\n";
+                replacement << startCall;
                 replacement << indentation << call.fullStatementText;
             } else {
                 replacement << indentation << "// MPI-parallelized: " << call.functionName << " (all ranks)\n";
                 std::string funcCall = call.callExpression;
                 if (!funcCall.empty() && funcCall.back() != ';') funcCall += ";";
+                replacement << startCall;
                 replacement << indentation << funcCall;
             }
+            if (emitTimers) replacement << "\n" << stopCall.substr(0, stopCall.size() - 1);
+        } else if (call.hasReturnValue && loop && generateRepeatedTransfer(callIdx, lineIndentation(body, loop->function_offset - 1),
+                                                                           indentation, setup, transfer, teardown)) {
+            // Executed on rank 0 in every iteration; the variable is the transfer buffer
+            replacement << indentation << "// Parallelized: " << call.functionName << " (rank 0 only)\n";
+            replacement << indentation << TypeMapper::normalizeType(call.returnType) << "& " << call.returnVariable
+                        << " = _persist_" << callIdx << ";\n";
+            replacement << startCall;
+            replacement << indentation << "if (rank == 0) {\n";
+            replacement << indentation << "    _persist_" << callIdx << " = " << extractFunctionCall(call.callExpression) << ";\n";
+            replacement << indentation << "}\n";
+            replacement << stopCall;
+            if (emitTimers) {
+                int transferTimer = addTimerRegion("transfer " + call.returnVariable);
+                std::string stop = timerStop(transferTimer, indentation);
+                transfer = timerStart(transferTimer, indentation) + transfer + "\n" + stop.substr(0, stop.size() - 1);
+            }
+            replacement << transfer;
+            // Calls are visited back to front: set-ups accumulate in source order, clean-ups reversed
+            loopTransfers[loop].first = setup + loopTransfers[loop].first;
+            loopTransfers[loop].second += "\n" + teardown;
         } else if (call.hasReturnValue) {
             // No MPI parallelization - execute on rank 0 and broadcast
             replacement << indentation << "// Parallelized: " << call.functionName << " (rank 0 only)\n";
             replacement << indentation << call.returnType << " " << call.returnVariable << ";\n";
+            replacement << startCall;
             replacement << indentation << "if (rank == 0) {\n";
             replacement << indentation << "    " << call.returnVariable << " = " << extractFunctionCall(call.callExpression) << ";\n";
             replacement << indentation << "}\n";
+            replacement << stopCall;
             // Broadcast result to all ranks
-            std::string mpiType = TypeMapper::getMPIDatatype(call.returnType);
-            if (!mpiType.empty()) {
-                replacement << indentation << "MPI_Bcast(&" << call.returnVariable << ", 1, " << mpiType << ", 0, MPI_COMM_WORLD);";
+            std::string broadcast = generateBroadcast(call.returnVariable, transferType(call), indentation);
+            if (!broadcast.empty() && emitTimers) {
+                int bcastTimer = addTimerRegion("bcast " + call.returnVariable);
+                std::string stop = timerStop(bcastTimer, indentation);
+                replacement << timerStart(bcastTimer, indentation) << broadcast << "\n" << stop.substr(0, stop.size() - 1);
+            } else if (!broadcast.empty()) {
+                replacement << broadcast;
             } else {
                 replacement << indentation << "// Note: Cannot broadcast type " << call.returnType;
             }
         } else {
             // Void function without MPI parallelization - wrap in rank check
             replacement << indentation << "// Parallelized: " << call.functionName << " (rank 0 only)\n";
+            replacement << startCall;
             replacement << indentation << "if (rank == 0) {\n";
             std::string funcCall = call.callExpression;
             if (!funcCall.empty() && funcCall.back() == ';') funcCall.pop_back();
             replacement << indentation << "    " << funcCall << ";\n";
             replacement << indentation << "}";
+            if (emitTimers) replacement << "\n" << stopCall.substr(0, stopCall.size() - 1);
         }
         
         // Replace the original statement with the parallelized version
-        body.replace(lineStart, stmtEnd - lineStart, replacement.str());
+        edits.push_back({lineStart, stmtEnd - lineStart, replacement.str()});
     }
     
+    for (const auto& entry : loopTransfers) {
+        const LoopInfo& loop = *entry.first;
+        size_t loopStart = loop.function_offset - 1;
+        size_t loopLine = body.rfind('\n', loopStart);
+        loopLine = (loopLine == std::string::npos) ? 0 : loopLine + 1;
+        size_t loopEnd = loopStart + loop.source_code.length();
+        if (loopEnd < body.size() && body[loopEnd] == ';') loopEnd++;  // do-while
+        edits.push_back({loopLine, 0, entry.second.first});
+        edits.push_back({loopEnd, 0, entry.second.second});
+    }
+    body = applyBodyEdits(body, edits);
+    
     // Wrap output statements (cout, printf) in rank 0 checks
     // This is done with simple pattern matching
     std::string wrappedBody;
@@ -627,6 +1797,7 @@ std::string HybridParallelizer::generatePreservedMainBody() {
                 if (c == ' ' || c == '\t') indent += c;
                 else break;
             }
+            wrappedBody += timerReport(indent);
             wrappedBody += indent + "MPI_Finalize();\n";
             wrappedBody += line + "\n";
         } else if (hasOutput && !alreadyWrapped) {
@@ -656,13 +1827,43 @@ std::string HybridParallelizer::generatePreservedMainBody() {
 }
 
 std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
+    std::string code;
+    llvm::raw_string_ostream stream(code);
+    writeHybridMPIOpenMPCode(stream);
+    stream.flush();
+    return code;
+}
+
+// Generated code goes to the stream as it is produced; function bodies are written
+// from their source text and edit lists without an edited copy
+void HybridParallelizer::writeHybridMPIOpenMPCode(llvm::raw_ostream& mpiCode) {
     auto parallelGroups = getParallelizableGroups();
-    
-    std::stringstream mpiCode;
+    timerRegions.clear();
     
     // Headers - use original includes and add required MPI/OpenMP headers
     mpiCode << "#include <mpi.h>\n";
     mpiCode << "#include <omp.h>\n";
+    if (enableSoATransform || emitTimers) {
+        mpiCode << "#include <vector>\n";  // Structure-of-arrays field copies, timer gather
+    }
+    if (parallelGroups.size() < functionCalls.size()) {
+        mpiCode << "#include <cstring>\n";  // Results copied through the shared-memory window
+    }
+    for (const auto& record : sourceContext.records) {
+        if (record.transferable) {
+            mpiCode << "#include <cstddef>\n";  // offsetof for MPI struct datatypes
+            break;
+        }
+    }
+    if (!numaProcBind.empty()) {
+        mpiCode << "#include <cstdio>\n";   // Placement guidance in main
+        mpiCode << "#include <cstdlib>\n";
+    } else if (enableLoopParallelization && usesCounterRand()) {
+        mpiCode << "#include <cstdlib>\n";  // RAND_MAX for counter-based random numbers
+    }
+    if (emitTimers && numaProcBind.empty()) {
+        mpiCode << "#include <cstdio>\n";   // Timer report on stderr
+    }
     if (!originalIncludes.empty()) {
         // PHASE 2 FIX: Extract only #include statements, skip function definitions
         std::string cleanedIncludes = extractIncludesOnly(originalIncludes);
@@ -675,17 +1876,38 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
         mpiCode << "#include <stdio.h>\n";
     }
     
-    // NEW: Add typedefs from source context
-    if (!sourceContext.typedefs.empty()) {
-        mpiCode << "\n// Type definitions from original source\n";
+    // NEW: Add typedefs from source context, with struct definitions in source order
+    if (!sourceContext.typedefs.empty() || !sourceContext.records.empty()) {
+        std::vector<std::pair<unsigned, std::string>> definitions;
         for (const auto& typedefInfo : sourceContext.typedefs) {
-            std::string typedef_def = typedefInfo.definition;
+            definitions.push_back({typedefInfo.line, typedefInfo.definition});
+        }
+        for (const auto& record : sourceContext.records) {
+            // "typedef struct P {...} P;" already carries the struct
+            bool insideTypedef = false;
+            for (const auto& typedefInfo : sourceContext.typedefs) {
+                if (typedefInfo.definition.find(record.definition) != std::string::npos) insideTypedef = true;
+            }
+            if (!insideTypedef) definitions.push_back({record.line, record.definition});
+        }
+        std::stable_sort(definitions.begin(), definitions.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        
+        mpiCode << "\n// Type definitions from original source\n";
+        for (const auto& definition : definitions) {
+            std::string typedef_def = definition.second;
             // PHASE 2 FIX: Ensure typedef ends with semicolon
             if (!typedef_def.empty() && typedef_def.back() != ';') {
                 typedef_def += ";";
             }
             mpiCode << typedef_def << "\n";
         }
+        
+        std::string recordDatatypes = generateRecordDatatypes();
+        if (!recordDatatypes.empty()) {
+            mpiCode << "\n// MPI datatypes for structs sent between ranks\n";
+            mpiCode << recordDatatypes;
+        }
     }
     
     // Fallback headers if no original includes provided (continued)
@@ -711,6 +1933,20 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
     if (hasGlobalReads && !globalVariables.empty()) {
         mpiCode << "// Global variables\n";
         for (const auto& globalVar : globalVariables) {
+            // Defined in another unit: declaring it again keeps a single definition at link time
+            auto info = globalVariableInfo.find(globalVar);
+            if (info != globalVariableInfo.end() && info->second.isExtern) {
+                std::string externType = info->second.type;
+                if (info->second.isArray) {
+                    externType = externType.substr(0, externType.find('['));
+                    while (!externType.empty() && externType.back() == ' ') externType.pop_back();
+                    mpiCode << "extern " << externType << " " << globalVar << "[" << info->second.arraySize << "];\n";
+                } else {
+                    mpiCode << "extern " << externType << " " << globalVar << ";\n";
+                }
+                continue;
+            }
+            
             // Infer type from variable name (basic heuristic)
             std::string varType = "int"; // default
             std::string defaultValue = "0";
@@ -733,6 +1969,17 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
         mpiCode << "\n";
     }
     
+    if (enableLoopParallelization && usesCounterRand()) {
+        mpiCode << "// Counter-based random numbers for rand() in parallel loops\n";
+        mpiCode << COUNTER_RAND_HELPER << "\n";
+    }
+    if (enableLoopParallelization && usesRuntimeSplit()) {
+        mpiCode << generatePlanSplitHelper() << "\n";
+    }
+    
+    // The timer table follows main, once every region is known
+    mpiCode << generateTimerDeclarations();
+    
     // Output parallelized function definitions
     std::set<std::string> outputFunctions;
     
@@ -754,16 +2001,37 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
         if (functionInfo.count(funcName)) {
             const FunctionInfo& info = functionInfo.at(funcName);
             
+            // --whole-program: the defining unit is compiled and linked as it is
+            if (!info.defined_in.empty()) {
+                mpiCode << "// Defined in " << info.defined_in << "\n";
+                mpiCode << info.return_type << " " << info.name << "(";
+                for (size_t i = 0; i < info.parameter_types.size(); i++) {
+                    if (i > 0) mpiCode << ", ";
+                    mpiCode << info.parameter_types[i];
+                }
+                mpiCode << ");\n\n";
+                continue;
+            }
+            
             // PHASE 2: Use complete function source if available, otherwise build from parts
             if (!info.complete_function_source.empty()) {
-                // Enhanced version with loop parallelization if enabled
-                if (enableLoopParallelization && info.has_parallelizable_loops) {
+                std::string taskCode;
+                if (enableLoopParallelization && info.has_task_parallelism) {
+                    taskCode = generateTaskParallelFunction(info);
+                }
+                
+                // Recursive functions with independent calls become OpenMP tasks
+                if (!taskCode.empty()) {
+                    mpiCode << "// Enhanced function with OpenMP tasks: " << info.name << "\n";
+                    mpiCode << taskCode;
+                } else if (enableLoopParallelization && info.has_parallelizable_loops) {
+                    // Enhanced version with loop parallelization if enabled
                     mpiCode << "// Enhanced function with OpenMP pragmas: " << info.name << "\n";
                     
                     // Extract function signature and generate body with pragmas
                     if (!info.function_signature.empty()) {
                         mpiCode << info.function_signature << " ";
-                        mpiCode << generateParallelizedFunctionBody(info);
+                        writeParallelizedFunctionBody(mpiCode, info);
                     } else {
                         // Fallback: use complete source but mark as enhanced
                         mpiCode << "// Original function (pragma enhancement failed): " << info.name << "\n";
@@ -796,7 +2064,7 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
                 
                 // Function body with OpenMP pragmas
                 if (enableLoopParallelization && info.has_parallelizable_loops) {
-                    mpiCode << generateParallelizedFunctionBody(info);
+                    writeParallelizedFunctionBody(mpiCode, info);
                 } else {
                     mpiCode << info.original_body;
                 }
@@ -827,6 +2095,29 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
     mpiCode << "    MPI_Comm_rank(MPI_COMM_WORLD, &rank);\n";
     mpiCode << "    MPI_Comm_size(MPI_COMM_WORLD, &size);\n\n";
     
+    // NUMA mode: the right OMP_PLACES depends on how many ranks share a node
+    if (!numaProcBind.empty()) {
+        mpiCode << "    // NUMA placement: threads must stay on the cores that first touched their pages\n";
+        mpiCode << "    MPI_Comm _node_comm;\n";
+        mpiCode << "    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &_node_comm);\n";
+        mpiCode << "    int _ranks_per_node;\n";
+        mpiCode << "    MPI_Comm_size(_node_comm, &_ranks_per_node);\n";
+        mpiCode << "    MPI_Comm_free(&_node_comm);\n";
+        mpiCode << "    if (rank == 0 && getenv(\"OMP_PLACES\") == NULL) {\n";
+        mpiCode << "        fprintf(stderr, \"NUMA mode (proc_bind(" << numaProcBind << ")): OMP_PLACES is not set, threads may run away from their pages.\\n\");\n";
+        mpiCode << "        if (_ranks_per_node > 1) {\n";
+        mpiCode << "            fprintf(stderr, \"  %d ranks per node: export OMP_PLACES=cores and bind each rank to its own socket (mpirun --map-by socket --bind-to socket)\\n\", _ranks_per_node);\n";
+        mpiCode << "        } else {\n";
+        mpiCode << "            fprintf(stderr, \"  1 rank per node: export OMP_PLACES=cores and leave the rank unbound (mpirun --map-by node --bind-to none)\\n\");\n";
+        mpiCode << "        }\n";
+        mpiCode << "    }\n\n";
+    }
+    
+    if (emitTimers) {
+        mainTimerRegion = addTimerRegion("main (total)");
+        mpiCode << timerStart(mainTimerRegion, "    ") << "\n";
+    }
+    
     // Check if we can preserve the original main body structure
     if (!mainFunctionBody.empty() && !functionCalls.empty() && 
         functionCalls[0].statementStartOffset > 0) {
@@ -834,8 +2125,8 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
         mpiCode << "    // === Original main() structure preserved with MPI parallelization ===\n\n";
         mpiCode << generatePreservedMainBody();
         mpiCode << "}\n";
-        
-        return mpiCode.str();
+        mpiCode << generateTimerSupport();
+        return;
     }
     
     // Fallback: Original reconstruction approach (when offset info not available)
@@ -847,7 +2138,8 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
     
     std::set<std::string> functionsWithLoops;
     for (const auto& pair : functionInfo) {
-        if (enableLoopParallelization && pair.second.has_parallelizable_loops && pair.first != "main") {
+        if (enableLoopParallelization && pair.second.has_parallelizable_loops && pair.first != "main" &&
+            pair.second.defined_in.empty()) {
             functionsWithLoops.insert(pair.first);
         }
     }
@@ -929,34 +2221,62 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
     }
     mpiCode << "\n";
     
+    // Calls spread over ranks send their results to rank 0. Ranks on rank 0's node
+    // get the calls with the heaviest data edges and hand their results over through
+    // a shared-memory window; only ranks on other nodes use point-to-point messages.
+    std::map<int, std::string> resultSlots;
+    std::string resultBytes = "0";
+    bool spreadsCalls = false;
+    for (const auto& group : parallelGroups) {
+        if (group.size() < 2 || groupHasMpiLoops(group)) continue;
+        spreadsCalls = true;
+        for (int callIdx : group) {
+            if (!functionCalls[callIdx].hasReturnValue || transferDatatype(transferType(functionCalls[callIdx])).empty()) continue;
+            resultSlots[callIdx] = resultBytes;
+            resultBytes += " + sizeof(result_" + std::to_string(callIdx) + ")";
+        }
+    }
+    if (spreadsCalls) {
+        mpiCode << "    // Node topology: ranks that share memory with rank 0 come first in the placement\n";
+        mpiCode << "    MPI_Comm _shm_comm;\n";
+        mpiCode << "    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &_shm_comm);\n";
+        mpiCode << "    int _is_root = (rank == 0), _on_root_node = 0;\n";
+        mpiCode << "    MPI_Allreduce(&_is_root, &_on_root_node, 1, MPI_INT, MPI_MAX, _shm_comm);\n";
+        mpiCode << "    std::vector<int> _root_node_flags(size);\n";
+        mpiCode << "    MPI_Allgather(&_on_root_node, 1, MPI_INT, _root_node_flags.data(), 1, MPI_INT, MPI_COMM_WORLD);\n";
+        mpiCode << "    std::vector<int> _placement;\n";
+        mpiCode << "    for (int _r = 0; _r < size; _r++) if (_root_node_flags[_r]) _placement.push_back(_r);\n";
+        mpiCode << "    for (int _r = 0; _r < size; _r++) if (!_root_node_flags[_r]) _placement.push_back(_r);\n";
+        mpiCode << "    // Results from rank 0's node are stored straight into rank 0's segment\n";
+        mpiCode << "    char* _result_base = nullptr;\n";
+        mpiCode << "    MPI_Win _result_win;\n";
+        mpiCode << "    MPI_Aint _result_bytes = " << resultBytes << ";\n";
+        mpiCode << "    MPI_Win_allocate_shared(rank == 0 ? _result_bytes : 0, 1, MPI_INFO_NULL, _shm_comm, &_result_base, &_result_win);\n";
+        mpiCode << "    if (_on_root_node) {\n";
+        mpiCode << "        MPI_Aint _segment_bytes;\n";
+        mpiCode << "        int _disp_unit;\n";
+        mpiCode << "        MPI_Win_shared_query(_result_win, 0, &_segment_bytes, &_disp_unit, &_result_base);\n";
+        mpiCode << "    }\n";
+        mpiCode << "    MPI_Win_lock_all(MPI_MODE_NOCHECK, _result_win);\n\n";
+    }
+    
     // Generate parallel execution logic
     int groupIndex = 0;
+    bool numberCalls = enableLoopParallelization && usesCounterRand();  // Random streams follow the call, not the rank
     for (const auto& group : parallelGroups) {
         // NEW: Check for MPI loops in this group
-        bool hasMpiLoops = false;
-        if (enableLoopParallelization) {
-            for (int callIdx : group) {
-                std::string funcName = functionCalls[callIdx].functionName;
-                if (functionInfo.count(funcName)) {
-                    const auto& info = functionInfo.at(funcName);
-                    for (const auto& loop : info.loops) {
-                        if (loop.is_mpi_parallelizable) {
-                            hasMpiLoops = true;
-                            break;
-                        }
-                    }
-                }
-                if (hasMpiLoops) break;
-            }
-        }
+        bool hasMpiLoops = groupHasMpiLoops(group);
 
         if (hasMpiLoops) {
             mpiCode << "    // === Parallel group " << groupIndex << " (Contains MPI-parallelized loops) ===\n";
             mpiCode << "    // Executing functions sequentially on all ranks to allow full MPI utilization\n";
+            int groupTimer = emitTimers ? addTimerRegion("group " + std::to_string(groupIndex)) : -1;
+            if (emitTimers) mpiCode << timerStart(groupTimer, "    ");
             
             for (int callIdx : group) {
                 std::string funcName = functionCalls[callIdx].functionName;
                 mpiCode << "    // Call " << funcName << "\n";
+                if (numberCalls) mpiCode << "    _rng_main_call = " << callIdx + 1 << ";\n";
                 
                 if (functionCalls[callIdx].hasReturnValue) {
                     std::string originalCall = functionCalls[callIdx].callExpression;
@@ -979,6 +2299,7 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
                 // Add barrier to synchronize
                 mpiCode << "    MPI_Barrier(MPI_COMM_WORLD);\n";
             }
+            if (emitTimers) mpiCode << timerStop(groupTimer, "    ");
             
             groupIndex++;
             continue;
@@ -988,11 +2309,14 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
         mpiCode << "    if (rank == 0) {\n";
         mpiCode << "        std::cout << \"\\n--- Executing Group " << groupIndex << " ---\" << std::endl;\n";
         mpiCode << "    }\n";
+        int groupTimer = emitTimers ? addTimerRegion("group " + std::to_string(groupIndex)) : -1;
+        if (emitTimers) mpiCode << timerStart(groupTimer, "    ");
         
         if (group.size() == 1) {
             // Sequential execution for single function
             int callIdx = group[0];
             mpiCode << "    if (rank == 0) {\n";
+            if (numberCalls) mpiCode << "        _rng_main_call = " << callIdx + 1 << ";\n";
             
             if (functionCalls[callIdx].hasReturnValue) {
                 std::string originalCall = functionCalls[callIdx].callExpression;
@@ -1016,15 +2340,33 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
             mpiCode << "    // Dynamic process assignment to avoid deadlocks\n";
             mpiCode << "    int effective_processes = std::min(size, (int)" << group.size() << ");\n";
             
-            // Calculate all process assignments upfront
-            for (int i = 0; i < group.size(); ++i) {
-                int callIdx = group[i];
-                mpiCode << "    int assigned_rank_" << callIdx << " = " << i << " % effective_processes;\n";
+            // Results that are element runs (vectors, strings, arrays) go point to point,
+            // with the length first when it is only known at run time
+            std::map<int, TypeMapper::TransferShape> containerResults;
+            for (int callIdx : group) {
+                const FunctionCall& call = functionCalls[callIdx];
+                if (!call.hasReturnValue || !transferDatatype(transferType(call)).empty()) continue;
+                TypeMapper::TransferShape shape = TypeMapper::getTransferShape(transferType(call));
+                if (!mpiElementType(shape.elementType).empty() && !(shape.isContainer && shape.elementType == "bool")) {
+                    containerResults[callIdx] = shape;
+                }
+            }
+            
+            // Calculate all process assignments upfront: heaviest data edges first,
+            // so they land on rank 0's node
+            std::vector<int> placementOrder(group.begin(), group.end());
+            std::stable_sort(placementOrder.begin(), placementOrder.end(), [this](int a, int b) {
+                return dataEdgeWeight(a) > dataEdgeWeight(b);
+            });
+            for (int i = 0; i < placementOrder.size(); ++i) {
+                int callIdx = placementOrder[i];
+                mpiCode << "    int assigned_rank_" << callIdx << " = _placement[" << i << " % effective_processes];\n";
             }
             
             for (int i = 0; i < group.size(); ++i) {
                 int callIdx = group[i];
                 mpiCode << "    if (rank == assigned_rank_" << callIdx << ") {\n";
+                if (numberCalls) mpiCode << "        _rng_main_call = " << callIdx + 1 << ";\n";
                 
                 if (functionCalls[callIdx].hasReturnValue) {
                     std::string originalCall = functionCalls[callIdx].callExpression;
@@ -1034,12 +2376,19 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
                     
                     // Send result to rank 0 if this process is not rank 0 (non-blocking to avoid deadlock)
                     mpiCode << "        if (assigned_rank_" << callIdx << " != 0) {\n";
-                    std::string mpiType = TypeMapper::getMPIDatatype(functionCalls[callIdx].returnType);
+                    std::string mpiType = transferDatatype(transferType(functionCalls[callIdx]));
                     if (!mpiType.empty()) {
-                        mpiCode << "            MPI_Request _send_req_" << callIdx << ";\n";
-                        mpiCode << "            MPI_Isend(&result_" << callIdx 
+                        mpiCode << "            if (_on_root_node) {\n";
+                        mpiCode << "                memcpy(_result_base + " << resultSlots[callIdx] << ", &result_" << callIdx
+                                << ", sizeof(result_" << callIdx << "));\n";
+                        mpiCode << "            } else {\n";
+                        mpiCode << "                MPI_Request _send_req_" << callIdx << ";\n";
+                        mpiCode << "                MPI_Isend(&result_" << callIdx 
                                << ", 1, " << mpiType << ", 0, " << callIdx << ", MPI_COMM_WORLD, &_send_req_" << callIdx << ");\n";
-                        mpiCode << "            MPI_Wait(&_send_req_" << callIdx << ", MPI_STATUS_IGNORE);\n";
+                        mpiCode << "                MPI_Wait(&_send_req_" << callIdx << ", MPI_STATUS_IGNORE);\n";
+                        mpiCode << "            }\n";
+                    } else if (containerResults.count(callIdx)) {
+                        mpiCode << "            // Sent after the node barrier: " << functionCalls[callIdx].returnType << "\n";
                     } else {
                         mpiCode << "            // Skipping MPI_Send for unsupported type: " << functionCalls[callIdx].returnType << "\n";
                     }
@@ -1055,17 +2404,42 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
                 mpiCode << "    }\n";
             }
             
+            // Stores into the shared window become visible to rank 0 after the node barrier
+            mpiCode << "    MPI_Win_sync(_result_win);\n";
+            mpiCode << "    MPI_Barrier(_shm_comm);\n";
+            mpiCode << "    MPI_Win_sync(_result_win);\n";
+            
+            // Blocking sends come after the barrier, which rank 0 must pass to receive them
+            for (const auto& entry : containerResults) {
+                int callIdx = entry.first;
+                const TypeMapper::TransferShape& shape = entry.second;
+                std::string result = "result_" + std::to_string(callIdx);
+                std::string buffer = shape.isContainer ? result + ".data()" : result;
+                std::string mpiType = mpiElementType(shape.elementType);
+                mpiCode << "    if (rank == assigned_rank_" << callIdx << " && assigned_rank_" << callIdx << " != 0) {\n";
+                if (shape.isDynamic()) {
+                    mpiCode << "        long _count_" << callIdx << " = (long)" << result << ".size();\n";
+                    mpiCode << "        MPI_Send(&_count_" << callIdx << ", 1, MPI_LONG, 0, " << callIdx << ", MPI_COMM_WORLD);\n";
+                    mpiCode << "        MPI_Send(" << buffer << ", (int)_count_" << callIdx << ", " << mpiType << ", 0, "
+                            << callIdx << ", MPI_COMM_WORLD);\n";
+                } else {
+                    mpiCode << "        MPI_Send(" << buffer << ", " << shape.count << ", " << mpiType << ", 0, "
+                            << callIdx << ", MPI_COMM_WORLD);\n";
+                }
+                mpiCode << "    }\n";
+            }
+            
             // Collect results in rank 0 using dynamic assignment
             mpiCode << "    if (rank == 0) {\n";
             // Use non-blocking receives to avoid deadlock
             mpiCode << "        std::vector<MPI_Request> _recv_requests;\n";
             for (int i = 0; i < group.size(); ++i) {
                 int callIdx = group[i];
-                if (functionCalls[callIdx].hasReturnValue) {
-                    std::string mpiType = TypeMapper::getMPIDatatype(functionCalls[callIdx].returnType);
+                if (functionCalls[callIdx].hasReturnValue && !containerResults.count(callIdx)) {
+                    std::string mpiType = transferDatatype(transferType(functionCalls[callIdx]));
                     if (!mpiType.empty()) {
-                        // Only receive if function is assigned to a different rank
-                        mpiCode << "        if (assigned_rank_" << callIdx << " != 0) {\n";
+                        // Only receive if function is assigned to a rank on another node
+                        mpiCode << "        if (assigned_rank_" << callIdx << " != 0 && !_root_node_flags[assigned_rank_" << callIdx << "]) {\n";
                         mpiCode << "            MPI_Request _recv_req_" << callIdx << ";\n";
                         mpiCode << "            MPI_Irecv(&result_" << callIdx 
                                << ", 1, " << mpiType << ", assigned_rank_" << callIdx << ", " << callIdx 
@@ -1077,10 +2451,41 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
                     }
                 }
             }
+            // Element runs arrive in group order while the single values are in flight
+            for (const auto& entry : containerResults) {
+                int callIdx = entry.first;
+                const TypeMapper::TransferShape& shape = entry.second;
+                std::string result = "result_" + std::to_string(callIdx);
+                std::string buffer = shape.isContainer ? result + ".data()" : result;
+                std::string mpiType = mpiElementType(shape.elementType);
+                std::string source = "assigned_rank_" + std::to_string(callIdx);
+                mpiCode << "        if (" << source << " != 0) {\n";
+                if (shape.isDynamic()) {
+                    mpiCode << "            long _count_" << callIdx << ";\n";
+                    mpiCode << "            MPI_Recv(&_count_" << callIdx << ", 1, MPI_LONG, " << source << ", " << callIdx
+                            << ", MPI_COMM_WORLD, MPI_STATUS_IGNORE);\n";
+                    mpiCode << "            " << result << ".resize(_count_" << callIdx << ");\n";
+                    mpiCode << "            MPI_Recv(" << buffer << ", (int)_count_" << callIdx << ", " << mpiType << ", "
+                            << source << ", " << callIdx << ", MPI_COMM_WORLD, MPI_STATUS_IGNORE);\n";
+                } else {
+                    mpiCode << "            MPI_Recv(" << buffer << ", " << shape.count << ", " << mpiType << ", "
+                            << source << ", " << callIdx << ", MPI_COMM_WORLD, MPI_STATUS_IGNORE);\n";
+                }
+                mpiCode << "        }\n";
+            }
+            
             // Wait for all receives to complete
             mpiCode << "        if (!_recv_requests.empty()) {\n";
             mpiCode << "            MPI_Waitall(_recv_requests.size(), _recv_requests.data(), MPI_STATUSES_IGNORE);\n";
             mpiCode << "        }\n";
+            for (int callIdx : group) {
+                if (resultSlots.count(callIdx)) {
+                    mpiCode << "        if (assigned_rank_" << callIdx << " != 0 && _root_node_flags[assigned_rank_" << callIdx << "]) {\n";
+                    mpiCode << "            memcpy(&result_" << callIdx << ", _result_base + " << resultSlots[callIdx]
+                            << ", sizeof(result_" << callIdx << "));\n";
+                    mpiCode << "        }\n";
+                }
+            }
             
             for (int i = 0; i < group.size(); ++i) {
                 int callIdx = group[i];
@@ -1092,6 +2497,12 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
             mpiCode << "    }\n";
         }
         
+        if (emitTimers) {
+            mpiCode << timerStop(groupTimer, "    ");
+            groupTimer = addTimerRegion("group " + std::to_string(groupIndex) + " bcast");
+            mpiCode << timerStart(groupTimer, "    ");
+        }
+        
         // Broadcast updated variables
         mpiCode << "    // Broadcast updated variables to all processes\n";
         std::set<std::string> variablesToBroadcast;
@@ -1114,16 +2525,19 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
             }
             
             if (localVariables.count(originalVarName)) {
-                std::string mpiType = TypeMapper::getMPIDatatype(localVariables.at(originalVarName).type);
-                if (!mpiType.empty()) {
-                    mpiCode << "    MPI_Bcast(&" << varName << ", 1, " << mpiType << ", 0, MPI_COMM_WORLD);\n";
+                const LocalVariable& local = localVariables.at(originalVarName);
+                std::string broadcast = generateBroadcast(varName, transferType(local.type, local.canonicalType), "    ");
+                if (!broadcast.empty()) {
+                    mpiCode << broadcast << "\n";
                 } else {
                     mpiCode << "    // Skipping MPI_Bcast for unsupported type: " << localVariables.at(originalVarName).type << "\n";
                 }
             }
         }
         
-        mpiCode << "    MPI_Barrier(MPI_COMM_WORLD);\n\n";
+        mpiCode << "    MPI_Barrier(MPI_COMM_WORLD);\n";
+        if (emitTimers) mpiCode << timerStop(groupTimer, "    ");
+        mpiCode << "\n";
         groupIndex++;
     }
     
@@ -1141,7 +2555,7 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
     std::map<std::string, std::vector<LoopInfo>> uniqueFunctionLoops;
     for (const auto& pair : functionInfo) {
         const FunctionInfo& info = pair.second;
-        if (!info.loops.empty()) {
+        if (!info.loops.empty() && info.defined_in.empty()) {
             std::vector<LoopInfo> uniqueLoops;
             std::set<std::string> processedLoops;
             
@@ -1180,12 +2594,18 @@ std::string HybridParallelizer::generateHybridMPIOpenMPCode() {
     
     mpiCode << "        std::cout << \"\\n=== Enhanced Hybrid MPI/OpenMP Execution Complete ===\" << std::endl;\n";
     mpiCode << "    }\n\n";
-
+    
+    if (spreadsCalls) {
+        mpiCode << "    MPI_Win_unlock_all(_result_win);\n";
+        mpiCode << "    MPI_Win_free(&_result_win);\n";
+        mpiCode << "    MPI_Comm_free(&_shm_comm);\n";
+    }
+    mpiCode << timerReport("    ");
     mpiCode << "    MPI_Finalize();\n";
     mpiCode << "    return 0;\n";
     mpiCode << "}\n";
     
-    return mpiCode.str();
+    mpiCode << generateTimerSupport();
 }
 
 std::string HybridParallelizer::resolveVariableNameConflict(const std::string& originalName) const {
@@ -3,20 +3,35 @@
 
 #include "data_structures.h"
 #include "type_mapping.h"
+#include "region_planner.h"
 #include <map>
 #include <string>
 #include <vector>
 
+namespace llvm {
+class raw_ostream;
+}
+
+// Reads the analyzers' results in place: the calls, analyses, variables,
+// globals and loops passed to the constructor must outlive the parallelizer.
 class HybridParallelizer {
 private:
-    std::vector<FunctionCall> functionCalls;
-    std::map<std::string, FunctionAnalysis> functionAnalysis;
+    const std::vector<FunctionCall>& functionCalls;
+    const std::map<std::string, FunctionAnalysis>& functionAnalysis;
     std::vector<DependencyNode> dependencyGraph;
-    std::map<std::string, LocalVariable> localVariables;
-    std::map<std::string, FunctionInfo> functionInfo;
-    std::vector<LoopInfo> mainLoops;
-    std::set<std::string> globalVariables;
+    const std::map<std::string, LocalVariable>& localVariables;
+    const std::map<std::string, FunctionInfo>& functionInfo;
+    const std::vector<LoopInfo>& mainLoops;
+    const std::set<std::string>& globalVariables;
+    const std::map<std::string, GlobalVariable>& globalVariableInfo;
     bool enableLoopParallelization;
+    bool enableSoATransform;          // Structure-of-arrays copies for loops over arrays of structs (--soa)
+    std::string numaProcBind;         // NUMA mode proc_bind policy (--numa), empty when off
+    bool emitTimers;                  // MPI_Wtime timers around parallel regions (--emit-timers)
+    std::vector<std::string> timerRegions;  // Names of the timed regions, indexed by timer id
+    int mainTimerRegion = -1;         // Whole-program region, closed by the report
+    bool planRegions;                 // Machine-model choice of MPI, OpenMP, SIMD or serial per loop (--plan)
+    MachineModel machineModel;
     std::string originalIncludes;
     SourceCodeContext sourceContext;  // NEW: Complete source context including typedefs
     std::string mainFunctionBody;     // NEW: Original main() body for preservation
@@ -24,7 +39,28 @@ private:
     // Type mapping functions moved to TypeMapper utility class
     bool isTypePrintable(const std::string& cppType);
     std::string extractFunctionCall(const std::string& originalCall);
-    std::string generateParallelizedFunctionBody(const FunctionInfo& info);
+    void writeParallelizedFunctionBody(llvm::raw_ostream& out, const FunctionInfo& info);
+    std::string generateTaskParallelFunction(const FunctionInfo& info);  // Recursive calls as OpenMP tasks
+    bool groupHasMpiLoops(const std::vector<int>& group) const;          // Calls that run on all ranks
+    bool splitsAcrossRanks(const LoopInfo& loop) const;                   // Loop distributed over MPI ranks
+    bool usesRankSplit() const;                                           // Some function loop is split across ranks
+    bool usesRuntimeSplit() const;                                        // Some split is decided at run time (--plan)
+    std::string generatePlanSplitHelper() const;                          // _plan_split for the machine model
+    bool usesCounterRand() const;                                         // rand() rewritten in a parallel loop
+    const RecordInfo* findTransferableRecord(const std::string& cppType) const;
+    std::string mpiElementType(const std::string& cppType) const;         // Datatype of one element, empty if none
+    std::string transferDatatype(const std::string& cppType) const;       // Datatype of a single value, empty if none
+    std::string generateBroadcast(const std::string& var, const std::string& cppType,
+                                  const std::string& indentation) const;  // Bcast from rank 0, empty if unsupported
+    std::string generateRecordDatatypes() const;                          // MPI_Type_create_struct helpers
+    bool generateRepeatedTransfer(int callIdx, const std::string& loopIndentation, const std::string& indentation,
+                                  std::string& setup, std::string& transfer,
+                                  std::string& teardown) const;           // Persistent requests or RMA for calls in loops
+    int dataEdgeWeight(int callIdx) const;                                // Result traffic of a call
+    int addTimerRegion(const std::string& name);                          // Id of a new timed region
+    std::string generateTimerDeclarations() const;                        // Timer functions, ahead of their callers
+    std::string generateTimerSupport() const;                             // Timer table and rank report, after main
+    std::string timerReport(const std::string& indentation) const;        // Stop main timer and report
     std::string resolveVariableNameConflict(const std::string& originalName) const;
     std::string substituteVariableNames(const std::string& originalCall, const std::map<std::string, std::string>& variableNameMap) const;
     std::string extractIncludesOnly(const std::string& source);  // PHASE 2: Extract only include statements
@@ -37,16 +73,23 @@ public:
                       const std::map<std::string, FunctionInfo>& funcInfo,
                       const std::vector<LoopInfo>& loops,
                       const std::set<std::string>& globals,
+                      const std::map<std::string, GlobalVariable>& globalInfo,
                       const std::string& includes = "",
                       bool enableLoops = true,
                       const SourceCodeContext& context = SourceCodeContext(),
-                      const std::string& mainBody = "");  // NEW: Add main body parameter
+                      const std::string& mainBody = "",  // NEW: Add main body parameter
+                      bool enableSoA = false,
+                      const std::string& numaBind = "",
+                      bool timers = false,
+                      bool planLoops = false,
+                      const MachineModel& machine = MachineModel());
     
     void buildDependencyGraph();
     std::vector<std::vector<int>> getParallelizableGroups() const;
     const std::vector<DependencyNode>& getDependencyGraph() const;
     const std::map<std::string, LocalVariable>& getLocalVariables() const;
     std::string generateHybridMPIOpenMPCode();
+    void writeHybridMPIOpenMPCode(llvm::raw_ostream& out);  // Streams the code instead of building it in memory
 };
 
 #endif // HYBRID_PARALLELIZER_H
\ No newline at end of file
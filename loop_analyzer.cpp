@@ -1,8 +1,9 @@
 #include "loop_analyzer.h"
+#include "type_mapping.h"
+#include "function_analyzer.h"
 #include "clang/Lex/Lexer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
-#include <regex>
 #include <sstream>
 #include <cctype>
 
@@ -11,6 +12,10 @@ using namespace clang;
 ComprehensiveLoopAnalyzer::ComprehensiveLoopAnalyzer(SourceManager *sourceManager, const std::set<std::string>& globals) 
     : SM(sourceManager), globalVariables(globals) {}
 
+void ComprehensiveLoopAnalyzer::setFunctionAnalysis(const std::map<std::string, FunctionAnalysis> *analysis) {
+    functionAnalysis = analysis;
+}
+
 bool ComprehensiveLoopAnalyzer::VisitFunctionDecl(FunctionDecl *FD) {
     if (FD->hasBody()) {
         std::string funcName = FD->getNameAsString();
@@ -27,11 +32,13 @@ bool ComprehensiveLoopAnalyzer::VisitFunctionDecl(FunctionDecl *FD) {
         }
         
         currentFunction = funcName;
+        currentFunctionBody = FD->getBody();
         functionLoops[currentFunction].clear();
         
         // Traverse the function body only once
         TraverseStmt(FD->getBody());
         currentFunction = "";
+        currentFunctionBody = nullptr;
     }
     return true;
 }
@@ -64,6 +71,17 @@ bool ComprehensiveLoopAnalyzer::VisitForStmt(ForStmt *FS) {
 bool ComprehensiveLoopAnalyzer::VisitWhileStmt(WhileStmt *WS) {
     if (!currentFunction.empty()) {
         processWhileLoop(WS);
+        
+        // A parallelized while loop owns its body - keep nested loops serial
+        if (functionLoops[currentFunction].back().parallelizable) {
+            bool wasInLoop = insideLoop;
+            int previousDepth = loopDepth;
+            insideLoop = true;
+            loopDepth++;
+            RecursiveASTVisitor::TraverseStmt(WS->getBody());
+            loopDepth = previousDepth;
+            insideLoop = wasInLoop;
+        }
     }
     return true;
 }
@@ -71,6 +89,24 @@ bool ComprehensiveLoopAnalyzer::VisitWhileStmt(WhileStmt *WS) {
 bool ComprehensiveLoopAnalyzer::VisitDoStmt(DoStmt *DS) {
     if (!currentFunction.empty()) {
         processDoWhileLoop(DS);
+        
+        if (functionLoops[currentFunction].back().parallelizable) {
+            bool wasInLoop = insideLoop;
+            int previousDepth = loopDepth;
+            insideLoop = true;
+            loopDepth++;
+            RecursiveASTVisitor::TraverseStmt(DS->getBody());
+            loopDepth = previousDepth;
+            insideLoop = wasInLoop;
+        }
+    }
+    return true;
+}
+
+bool ComprehensiveLoopAnalyzer::VisitCompoundStmt(CompoundStmt *CS) {
+    // Remember each statement's block so while loops can look back for their start value
+    for (Stmt *S : CS->body()) {
+        enclosingCompound[S] = CS;
     }
     return true;
 }
@@ -79,6 +115,114 @@ const std::map<std::string, std::vector<LoopInfo>>& ComprehensiveLoopAnalyzer::g
     return functionLoops; 
 }
 
+std::map<std::string, std::vector<LoopInfo>> ComprehensiveLoopAnalyzer::takeAllFunctionLoops() {
+    std::map<std::string, std::vector<LoopInfo>> loops;
+    loops.swap(functionLoops);
+    return loops;
+}
+
+// Turn a loop test operator into an exclusive upper/lower bound
+static std::string exclusiveBound(BinaryOperatorKind op, const std::string &bound) {
+    if (op == BO_LE) return "(" + bound + ") + 1";
+    if (op == BO_GE) return "(" + bound + ") - 1";
+    return bound;
+}
+
+// Exit statements that leave the loop being analyzed; breaks inside nested
+// loops or switches and continues inside nested loops belong to those.
+struct LoopExits {
+    std::vector<BreakStmt*> breaks;
+    std::vector<ContinueStmt*> continues;
+    std::vector<ReturnStmt*> returns;
+    bool hasGoto = false;
+};
+
+static void scanLoopExits(Stmt *S, bool inNestedLoop, bool inSwitch, LoopExits &exits) {
+    if (!S || isa<LambdaExpr>(S)) return;
+    if (BreakStmt *BS = dyn_cast<BreakStmt>(S)) {
+        if (!inNestedLoop && !inSwitch) exits.breaks.push_back(BS);
+        return;
+    }
+    if (ContinueStmt *CS = dyn_cast<ContinueStmt>(S)) {
+        if (!inNestedLoop) exits.continues.push_back(CS);
+        return;
+    }
+    if (ReturnStmt *RS = dyn_cast<ReturnStmt>(S)) {
+        exits.returns.push_back(RS);
+        return;
+    }
+    if (isa<GotoStmt>(S) || isa<IndirectGotoStmt>(S)) {
+        exits.hasGoto = true;
+    }
+    bool nestedLoop = inNestedLoop || isa<ForStmt>(S) || isa<WhileStmt>(S) ||
+                      isa<DoStmt>(S) || isa<CXXForRangeStmt>(S);
+    bool nestedSwitch = inSwitch || isa<SwitchStmt>(S);
+    for (Stmt *child : S->children()) {
+        scanLoopExits(child, nestedLoop, nestedSwitch, exits);
+    }
+}
+
+static void noteWriteTarget(Expr *target, std::map<std::string, int> &writes) {
+    if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(target->IgnoreParenImpCasts())) {
+        writes[DRE->getDecl()->getNameAsString()]++;
+    }
+}
+
+// Count writes to named variables: assignments, ++/--, address-of,
+// non-const reference arguments and non-const member calls
+static void collectVariableWrites(Stmt *S, std::map<std::string, int> &writes) {
+    if (!S) return;
+    if (BinaryOperator *BO = dyn_cast<BinaryOperator>(S)) {
+        if (BO->isAssignmentOp()) noteWriteTarget(BO->getLHS(), writes);
+    } else if (UnaryOperator *UO = dyn_cast<UnaryOperator>(S)) {
+        if (UO->isIncrementDecrementOp() || UO->getOpcode() == UO_AddrOf) {
+            noteWriteTarget(UO->getSubExpr(), writes);
+        }
+    } else if (CXXMemberCallExpr *MCE = dyn_cast<CXXMemberCallExpr>(S)) {
+        CXXMethodDecl *MD = MCE->getMethodDecl();
+        if (MD && !MD->isConst() && MCE->getImplicitObjectArgument()) {
+            noteWriteTarget(MCE->getImplicitObjectArgument(), writes);
+        }
+    } else if (CallExpr *CE = dyn_cast<CallExpr>(S)) {
+        FunctionDecl *FD = CE->getDirectCallee();
+        if (FD && !isa<CXXOperatorCallExpr>(CE)) {
+            for (unsigned i = 0; i < CE->getNumArgs() && i < FD->getNumParams(); ++i) {
+                QualType paramType = FD->getParamDecl(i)->getType();
+                if (paramType->isReferenceType() && !paramType->getPointeeType().isConstQualified()) {
+                    noteWriteTarget(CE->getArg(i), writes);
+                }
+            }
+        }
+    }
+    for (Stmt *child : S->children()) {
+        collectVariableWrites(child, writes);
+    }
+}
+
+static void collectReferencedVars(Stmt *S, std::set<std::string> &vars) {
+    if (!S) return;
+    if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(S)) {
+        if (isa<VarDecl>(DRE->getDecl())) vars.insert(DRE->getDecl()->getNameAsString());
+    }
+    for (Stmt *child : S->children()) {
+        collectReferencedVars(child, vars);
+    }
+}
+
+// Calls other than const member functions may have side effects when re-evaluated
+static bool hasNonConstCall(Stmt *S) {
+    if (!S) return false;
+    if (CXXMemberCallExpr *MCE = dyn_cast<CXXMemberCallExpr>(S)) {
+        if (!MCE->getMethodDecl() || !MCE->getMethodDecl()->isConst()) return true;
+    } else if (isa<CallExpr>(S)) {
+        return true;
+    }
+    for (Stmt *child : S->children()) {
+        if (hasNonConstCall(child)) return true;
+    }
+    return false;
+}
+
 void ComprehensiveLoopAnalyzer::processForLoop(ForStmt *FS) {
     LoopInfo loop;
     loop.type = "for";
@@ -98,6 +242,7 @@ void ComprehensiveLoopAnalyzer::processForLoop(ForStmt *FS) {
     
     // Extract source code
     loop.source_code = getSourceText(FS->getSourceRange());
+    loop.function_offset = offsetInFunction(FS->getBeginLoc());
     
     // Initialize new fields
     loop.is_canonical = false;
@@ -144,7 +289,8 @@ void ComprehensiveLoopAnalyzer::processForLoop(ForStmt *FS) {
             std::string lhs = getSourceText(BO->getLHS()->getSourceRange());
             // Simple check if LHS contains loop variable
             if (lhs.find(loop.loop_variable) != std::string::npos) {
-                loop.end_expr = getSourceText(BO->getRHS()->getSourceRange());
+                // end_expr is exclusive: i <= n iterates up to n + 1
+                loop.end_expr = exclusiveBound(BO->getOpcode(), getSourceText(BO->getRHS()->getSourceRange()));
             }
         }
     }
@@ -203,11 +349,46 @@ void ComprehensiveLoopAnalyzer::processForLoop(ForStmt *FS) {
         }
     }
     
+    loop.declares_loop_variable = FS->getInit() && isa<DeclStmt>(FS->getInit());
+    
+    // Early exits are kept as body offsets so a search loop can be rewritten
+    if (CompoundStmt *body = dyn_cast_or_null<CompoundStmt>(FS->getBody())) {
+        if (loop.is_canonical && recordExitRanges(body, loop)) {
+            loop.body_source = getSourceText(body->getSourceRange());
+        }
+    }
+    
+    if (FS->getBody()) {
+        loop.body_offset = SM->getFileOffset(FS->getBody()->getBeginLoc()) - SM->getFileOffset(FS->getBeginLoc());
+    }
+    
     // Analyze loop body (includes dependency analysis)
     analyzeLoopBody(FS->getBody(), loop);
     
+    finalizeLoop(loop, loopDepth);
+    
+    functionLoops[currentFunction].push_back(std::move(loop));
+}
+
+// Where a loop starts within the current function body, so codegen can edit it in place
+size_t ComprehensiveLoopAnalyzer::offsetInFunction(SourceLocation loc) const {
+    if (!currentFunctionBody || loc.isMacroID()) return std::string::npos;
+    SourceLocation bodyStart = currentFunctionBody->getBeginLoc();
+    if (bodyStart.isMacroID() || SM->getFileID(loc) != SM->getFileID(bodyStart)) return std::string::npos;
+    return SM->getFileOffset(loc) - SM->getFileOffset(bodyStart);
+}
+
+// Element types MPI_SUM can combine with a datatype from TypeMapper
+static bool isSummableMPIType(const std::string &type) {
+    static const std::set<std::string> summable = {
+        "int", "long", "long long", "unsigned int", "unsigned long", "unsigned long long",
+        "float", "double", "long double"};
+    return summable.count(type) > 0;
+}
+
+void ComprehensiveLoopAnalyzer::finalizeLoop(LoopInfo &loop, int depth) {
     // Only parallelize outermost loops (depth 1) in nested structures
-    if (loopDepth > 1) {
+    if (depth > 1) {
         loop.parallelizable = false;
         loop.analysis_notes = "Inner loop in nested structure - not parallelized to avoid race conditions.";
     }
@@ -217,19 +398,43 @@ void ComprehensiveLoopAnalyzer::processForLoop(ForStmt *FS) {
         loop.pragma_text = generateOpenMPPragma(loop);
         
         // Determine if MPI parallelizable
-        // Must be canonical, not complex, and not have break/continue
+        // Must be canonical, not complex, and not exit early
         // Also, for now, let's only MPI parallelize if it's an outer loop (depth 1)
         // IMPORTANT: Multiplicative reductions (*) do NOT work correctly with MPI loop splitting
         // because partial products from different ranks don't combine correctly
         bool hasMultiplicativeReduction = (loop.reduction_op == "*");
         
-        if (loop.is_canonical && !loop.has_complex_condition && !loop.has_break_continue && 
-            loopDepth == 1 && !hasMultiplicativeReduction) {
+        // Arrays are combined with one MPI_SUM over the whole buffer, which needs
+        // its length and an MPI datatype for the element
+        bool reductionsSummable = true;
+        for (const auto& array : loop.array_reductions) {
+            if (array.op != "+" || array.length_expr.empty() || !isSummableMPIType(array.element_type)) {
+                reductionsSummable = false;
+            }
+        }
+        
+        // Scalar partial results need a datatype of their exact width
+        for (const auto& var : loop.reduction_vars) {
+            auto type = loop.reduction_var_types.find(var);
+            if (type != loop.reduction_var_types.end() && TypeMapper::getMPIDatatype(type->second).empty()) {
+                reductionsSummable = false;
+            }
+        }
+        
+        // Scans sum each rank's block a second time before MPI_Exscan, so the
+        // contribution must be free of side effects
+        if (loop.is_scan_loop && (!loop.scan.update_pure || !isSummableMPIType(loop.scan.type) ||
+                                  !loop.lastprivate_vars.empty())) {
+            reductionsSummable = false;
+        }
+        
+        // Search loops split the iteration space too: each rank probes its own block
+        bool hasEarlyExit = loop.has_break_continue || loop.has_early_return;
+        if (loop.is_canonical && !loop.has_complex_condition && (!hasEarlyExit || loop.is_search_loop) && 
+            depth == 1 && !hasMultiplicativeReduction && reductionsSummable) {
             loop.is_mpi_parallelizable = true;
         }
     }
-    
-    functionLoops[currentFunction].push_back(loop);
 }
 
 void ComprehensiveLoopAnalyzer::processWhileLoop(WhileStmt *WS) {
@@ -242,14 +447,29 @@ void ComprehensiveLoopAnalyzer::processWhileLoop(WhileStmt *WS) {
     
     loop.start_line = SM->getSpellingLineNumber(startLoc);
     loop.end_line = SM->getSpellingLineNumber(endLoc);
+    loop.start_col = SM->getSpellingColumnNumber(startLoc);
+    loop.end_col = SM->getSpellingColumnNumber(endLoc);
     
     loop.source_code = getSourceText(WS->getSourceRange());
-    loop.parallelizable = false; // While loops are harder to parallelize
-    loop.analysis_notes = "While loops require manual analysis for parallelization.";
+    loop.function_offset = offsetInFunction(WS->getBeginLoc());
+    loop.has_thread_unsafe_calls = false;
+    loop.has_complex_condition = false;
+    loop.is_canonical = false;
+    loop.is_mpi_parallelizable = false;
+    loop.step_expr = "1";
+    
+    // while (i < n) { ...; i++; } is a canonical loop in disguise
+    inferIterationSpace(WS, WS->getCond(), WS->getBody(), loop, false);
     
+    if (WS->getBody()) {
+        loop.body_offset = SM->getFileOffset(WS->getBody()->getBeginLoc()) - SM->getFileOffset(WS->getBeginLoc());
+    }
     analyzeLoopBody(WS->getBody(), loop);
     
-    functionLoops[currentFunction].push_back(loop);
+    // The loop itself is not counted in loopDepth yet
+    finalizeLoop(loop, loopDepth + 1);
+    
+    functionLoops[currentFunction].push_back(std::move(loop));
 }
 
 void ComprehensiveLoopAnalyzer::processDoWhileLoop(DoStmt *DS) {
@@ -262,235 +482,1739 @@ void ComprehensiveLoopAnalyzer::processDoWhileLoop(DoStmt *DS) {
     
     loop.start_line = SM->getSpellingLineNumber(startLoc);
     loop.end_line = SM->getSpellingLineNumber(endLoc);
+    loop.start_col = SM->getSpellingColumnNumber(startLoc);
+    loop.end_col = SM->getSpellingColumnNumber(endLoc);
     
     loop.source_code = getSourceText(DS->getSourceRange());
-    loop.parallelizable = false;
-    loop.analysis_notes = "Do-while loops require manual analysis for parallelization.";
+    loop.function_offset = offsetInFunction(DS->getBeginLoc());
+    loop.has_thread_unsafe_calls = false;
+    loop.has_complex_condition = false;
+    loop.is_canonical = false;
+    loop.is_mpi_parallelizable = false;
+    loop.step_expr = "1";
+    
+    inferIterationSpace(DS, DS->getCond(), DS->getBody(), loop, true);
     
+    if (DS->getBody()) {
+        loop.body_offset = SM->getFileOffset(DS->getBody()->getBeginLoc()) - SM->getFileOffset(DS->getBeginLoc());
+    }
     analyzeLoopBody(DS->getBody(), loop);
     
-    functionLoops[currentFunction].push_back(loop);
+    finalizeLoop(loop, loopDepth + 1);
+    
+    functionLoops[currentFunction].push_back(std::move(loop));
 }
 
-void ComprehensiveLoopAnalyzer::analyzeLoopBody(Stmt *body, LoopInfo &loop) {
-    if (!body) return;
+bool ComprehensiveLoopAnalyzer::matchAffineUpdate(Stmt *S, const VarDecl *&var, std::string &step) {
+    Expr *E = dyn_cast_or_null<Expr>(S);
+    if (!E) return false;
+    E = E->IgnoreImplicit();
     
-    // Initialize flags to false (preserve has_complex_condition if already set)
-    loop.has_function_calls = false;
-    loop.has_io_operations = false;
-    loop.has_break_continue = false;
-    // Don't reset has_complex_condition - it may have been set during condition analysis
-    loop.is_nested = false;
+    if (UnaryOperator *UO = dyn_cast<UnaryOperator>(E)) {
+        DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(UO->getSubExpr()->IgnoreParenImpCasts());
+        if (!UO->isIncrementDecrementOp() || !DRE) return false;
+        var = dyn_cast<VarDecl>(DRE->getDecl());
+        step = UO->isIncrementOp() ? "1" : "-1";
+        return var != nullptr;
+    }
     
-    class LoopBodyVisitor : public RecursiveASTVisitor<LoopBodyVisitor> {
-    public:
-        LoopInfo *loop;
-        std::string loopVar;
-        std::set<std::string> *globals;
-        std::set<std::string> localVars;  // Track variables declared inside loop
-        
-        LoopBodyVisitor(LoopInfo *l, const std::string &var, std::set<std::string> *g) 
-            : loop(l), loopVar(var), globals(g) {}
-        
-        bool VisitDeclRefExpr(DeclRefExpr *DRE) {
-            if (VarDecl *VD = dyn_cast<VarDecl>(DRE->getDecl())) {
-                std::string varName = VD->getNameAsString();
-                // Don't add cout/cin as regular variables
-                if (varName != "cout" && varName != "cin" && varName != "endl") {
-                    loop->read_vars.push_back(varName);
-                }
+    BinaryOperator *BO = dyn_cast<BinaryOperator>(E);
+    if (!BO) return false;
+    DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(BO->getLHS()->IgnoreParenImpCasts());
+    if (!DRE || !(var = dyn_cast<VarDecl>(DRE->getDecl()))) return false;
+    
+    Expr *increment = nullptr;
+    bool negate = false;
+    if (BO->getOpcode() == BO_AddAssign || BO->getOpcode() == BO_SubAssign) {
+        increment = BO->getRHS();
+        negate = BO->getOpcode() == BO_SubAssign;
+    } else if (BO->getOpcode() == BO_Assign) {
+        // i = i + c or i = i - c
+        BinaryOperator *RHS = dyn_cast<BinaryOperator>(BO->getRHS()->IgnoreParenImpCasts());
+        if (RHS && (RHS->getOpcode() == BO_Add || RHS->getOpcode() == BO_Sub)) {
+            DeclRefExpr *base = dyn_cast<DeclRefExpr>(RHS->getLHS()->IgnoreParenImpCasts());
+            if (base && base->getDecl() == var) {
+                increment = RHS->getRHS();
+                negate = RHS->getOpcode() == BO_Sub;
             }
-            return true;
         }
+    }
+    
+    // Only constant steps give a known direction and trip count
+    IntegerLiteral *literal = increment ? dyn_cast<IntegerLiteral>(increment->IgnoreParenImpCasts()) : nullptr;
+    if (!literal || literal->getValue() == 0) return false;
+    step = (negate ? "-" : "") + std::to_string(literal->getValue().getZExtValue());
+    return true;
+}
+
+bool ComprehensiveLoopAnalyzer::inferIterationSpace(Stmt *loopStmt, Expr *cond, Stmt *body,
+                                                    LoopInfo &loop, bool isDoWhile) {
+    CompoundStmt *CS = dyn_cast_or_null<CompoundStmt>(body);
+    if (!CS || CS->body_empty() || CS->getBeginLoc().isMacroID()) return false;
+    
+    // The induction update must be the last statement of the body
+    Stmt *update = CS->body_back();
+    const VarDecl *IV = nullptr;
+    std::string step;
+    if (!matchAffineUpdate(update, IV, step) || !IV->hasLocalStorage() ||
+        !IV->getType()->isIntegerType() || update->getBeginLoc().isMacroID()) {
+        return false;
+    }
+    std::string var = IV->getNameAsString();
+    
+    // The test must compare the induction variable against a bound
+    BinaryOperator *test = cond ? dyn_cast<BinaryOperator>(cond->IgnoreParenImpCasts()) : nullptr;
+    if (!test || !test->isComparisonOp()) return false;
+    BinaryOperatorKind op = test->getOpcode();
+    Expr *boundExpr = nullptr;
+    DeclRefExpr *lhs = dyn_cast<DeclRefExpr>(test->getLHS()->IgnoreParenImpCasts());
+    DeclRefExpr *rhs = dyn_cast<DeclRefExpr>(test->getRHS()->IgnoreParenImpCasts());
+    if (lhs && lhs->getDecl() == IV) {
+        boundExpr = test->getRHS();
+    } else if (rhs && rhs->getDecl() == IV) {
+        boundExpr = test->getLHS();
+        op = BinaryOperator::reverseComparisonOp(op);
+    }
+    if (!boundExpr) return false;
+    
+    bool increasing = step[0] != '-';
+    if (((op == BO_LT || op == BO_LE) && !increasing) ||
+        ((op == BO_GT || op == BO_GE) && increasing) ||
+        (op == BO_NE && step != "1" && step != "-1") || op == BO_EQ) {
+        return false;
+    }
+    std::string end = exclusiveBound(op, getSourceText(boundExpr->getSourceRange()));
+    
+    // Only the trailing update may write the induction variable, and the bound must be invariant
+    // (a continue would skip the update, so it cannot be expressed as a for loop)
+    LoopExits exits;
+    scanLoopExits(CS, false, false, exits);
+    if (!exits.continues.empty() || exits.hasGoto) return false;
+    
+    std::map<std::string, int> writes;
+    collectVariableWrites(CS, writes);
+    if (writes[var] != 1) return false;
+    std::set<std::string> boundVars;
+    collectReferencedVars(boundExpr, boundVars);
+    for (const auto &boundVar : boundVars) {
+        if (boundVar == var || writes.count(boundVar)) return false;
+    }
+    if (hasNonConstCall(boundExpr)) return false;
+    
+    // Start value: the last initialization of the induction variable in the enclosing block
+    auto parent = enclosingCompound.find(loopStmt);
+    if (parent == enclosingCompound.end()) return false;
+    std::string start;
+    std::set<std::string> startVars;
+    for (Stmt *S : parent->second->body()) {
+        if (S == loopStmt) break;
         
-        bool VisitBinaryOperator(BinaryOperator *BO) {
-            if (BO->isAssignmentOp()) {
-                if (DeclRefExpr *LHS = dyn_cast<DeclRefExpr>(BO->getLHS()->IgnoreImpCasts())) {
-                    if (VarDecl *VD = dyn_cast<VarDecl>(LHS->getDecl())) {
-                        std::string varName = VD->getNameAsString();
-                        loop->write_vars.push_back(varName);
-                    }
-                }
+        Expr *initExpr = nullptr;
+        if (DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+            for (Decl *D : DS->decls()) {
+                VarDecl *VD = dyn_cast<VarDecl>(D);
+                if (VD == IV && VD->hasInit()) initExpr = VD->getInit();
+            }
+        } else if (BinaryOperator *BO = dyn_cast<BinaryOperator>(S)) {
+            DeclRefExpr *target = dyn_cast<DeclRefExpr>(BO->getLHS()->IgnoreParenImpCasts());
+            if (BO->getOpcode() == BO_Assign && target && target->getDecl() == IV) {
+                initExpr = BO->getRHS();
             }
-            return true;
         }
         
-        bool VisitDeclStmt(DeclStmt *DS) {
-            // Track local variable declarations within the loop
-            for (auto *D : DS->decls()) {
-                if (VarDecl *VD = dyn_cast<VarDecl>(D)) {
-                    localVars.insert(VD->getNameAsString());
-                }
-            }
-            return true;
+        if (initExpr) {
+            start = hasNonConstCall(initExpr) ? "" : getSourceText(initExpr->getSourceRange());
+            startVars.clear();
+            collectReferencedVars(initExpr, startVars);
+            continue;
         }
         
-        bool VisitCompoundAssignOperator(CompoundAssignOperator *CAO) {
-            if (DeclRefExpr *LHS = dyn_cast<DeclRefExpr>(CAO->getLHS()->IgnoreImpCasts())) {
-                if (VarDecl *VD = dyn_cast<VarDecl>(LHS->getDecl())) {
-                    std::string varName = VD->getNameAsString();
-                    // Only add to reduction if it's NOT a local variable declared inside the loop
-                    if (localVars.find(varName) == localVars.end()) {
-                        loop->reduction_vars.push_back(varName);
-                    }
-                    
-                    // Determine reduction operation
-                    switch (CAO->getOpcode()) {
-                        case BO_AddAssign: loop->reduction_op = "+"; break;
-                        case BO_SubAssign: 
-                loop->reduction_op = "-"; 
-                // Subtraction is NOT associative - cannot be parallelized
-                loop->parallelizable = false;
-                loop->analysis_notes += " Subtraction reduction is not parallelizable (non-associative). ";
-                break;
-                        case BO_MulAssign: loop->reduction_op = "*"; break;
-                        case BO_AndAssign: loop->reduction_op = "&"; break;
-                        case BO_OrAssign: loop->reduction_op = "|"; break;
-                        case BO_XorAssign: loop->reduction_op = "^"; break;
-                        default: loop->reduction_op = "+"; break;
-                    }
-                }
-            }
+        // Any later write to the variable or to the start operands invalidates the start value
+        std::map<std::string, int> stmtWrites;
+        collectVariableWrites(S, stmtWrites);
+        if (stmtWrites.count(var)) start.clear();
+        for (const auto &startVar : startVars) {
+            if (stmtWrites.count(startVar)) start.clear();
+        }
+    }
+    if (start.empty()) return false;
+    
+    // A do-while loop runs its first iteration before testing the bound
+    if (isDoWhile) {
+        end = increasing
+            ? "((" + end + ") > (" + start + ") ? (" + end + ") : (" + start + ") + 1)"
+            : "((" + end + ") < (" + start + ") ? (" + end + ") : (" + start + ") - 1)";
+    }
+    
+    // Body text without the update statement (and its line, when it has one to itself)
+    unsigned bodyOffset = SM->getFileOffset(CS->getLBracLoc());
+    std::string bodyText = getSourceText(CS->getSourceRange());
+    size_t updateBegin = SM->getFileOffset(update->getBeginLoc()) - bodyOffset;
+    size_t updateEnd = bodyText.find(';', updateBegin);
+    if (updateEnd == std::string::npos) return false;
+    size_t lineStart = bodyText.rfind('\n', updateBegin);
+    if (lineStart != std::string::npos &&
+        bodyText.find_first_not_of(" \t", lineStart + 1) == updateBegin) {
+        updateBegin = lineStart;
+    }
+    bodyText.erase(updateBegin, updateEnd + 1 - updateBegin);
+    
+    if (!recordExitRanges(CS, loop)) return false;
+    
+    loop.loop_variable = var;
+    loop.loop_variable_type = IV->getType().getAsString();
+    if (loop.loop_variable_type == "_Bool") loop.loop_variable_type = "bool";
+    loop.start_expr = start;
+    loop.end_expr = end;
+    loop.step_expr = step;
+    loop.body_source = bodyText;
+    loop.is_canonical = true;
+    return true;
+}
+
+bool ComprehensiveLoopAnalyzer::recordExitRanges(CompoundStmt *body, LoopInfo &loop) {
+    loop.exit_ranges.clear();
+    LoopExits exits;
+    scanLoopExits(body, false, false, exits);
+    if (exits.hasGoto) return false;
+    
+    // Offsets are relative to the body's opening brace, like body_source
+    unsigned bodyOffset = SM->getFileOffset(body->getLBracLoc());
+    for (BreakStmt *BS : exits.breaks) {
+        if (BS->getBreakLoc().isMacroID()) return false;
+        loop.exit_ranges.push_back({SM->getFileOffset(BS->getBreakLoc()) - bodyOffset, 5});
+    }
+    for (ReturnStmt *RS : exits.returns) {
+        if (RS->getBeginLoc().isMacroID() || RS->getEndLoc().isMacroID()) {
+            loop.exit_ranges.clear();
+            return false;
+        }
+        unsigned length = getSourceText(RS->getSourceRange()).length();
+        loop.exit_ranges.push_back({SM->getFileOffset(RS->getBeginLoc()) - bodyOffset, length});
+    }
+    std::sort(loop.exit_ranges.begin(), loop.exit_ranges.end());
+    return true;
+}
+
+bool ComprehensiveLoopAnalyzer::isSpeculativeSearch(Stmt *body, const LoopInfo &loop,
+                                                    std::vector<std::string> &exitVars) {
+    if (loop.exit_ranges.empty() || loop.has_io_operations || loop.has_thread_unsafe_calls) {
+        return false;
+    }
+    
+    // Only constant steps let the probe and the serial replay agree on direction
+    const std::string &step = loop.step_expr;
+    size_t digits = (!step.empty() && step[0] == '-') ? 1 : 0;
+    if (digits >= step.size() || step.find_first_not_of("0123456789", digits) != std::string::npos) {
+        return false;
+    }
+    
+    // A search body may only write iteration-local variables, the induction
+    // update, and plain assignments sitting right next to a break (the result).
+    // Those results are privatized in the parallel probe and recomputed serially;
+    // a return simply happens again in the serial replay.
+    class SearchBodyChecker : public RecursiveASTVisitor<SearchBodyChecker> {
+    public:
+        std::string inductionVar;
+        std::set<std::string> locals;
+        std::set<const Stmt*> exitAssignments;
+        std::map<std::string, int> exitWrites;
+        std::map<std::string, int> references;
+        bool safe = true;
+        
+        SearchBodyChecker(const std::string &iv) : inductionVar(iv) {}
+        
+        bool TraverseLambdaExpr(LambdaExpr *LE) {
+            safe = false;
             return true;
         }
         
-        bool VisitCallExpr(CallExpr *CE) {
-            if (FunctionDecl *FD = CE->getDirectCallee()) {
-                std::string funcName = FD->getNameAsString();
-                
-                // Check for thread-unsafe functions
-                if (funcName == "rand" || funcName == "srand" ||
-                    funcName == "strtok" || funcName == "asctime" ||
-                    funcName == "ctime" || funcName == "gmtime" ||
-                    funcName == "localtime" || funcName == "strerror") {
-                    loop->has_thread_unsafe_calls = true;
-                    loop->unsafe_functions.push_back(funcName);
-                    
-                    // For rand(), we need a thread-local seed variable
-                    if (funcName == "rand") {
-                        loop->thread_local_vars.insert("__thread_seed");
-                    }
-                }
-                // Check for I/O operations - be more specific
-                else if (funcName == "printf" || funcName == "scanf" ||
-                    funcName == "puts" || funcName == "gets" ||
-                    funcName == "fprintf" || funcName == "fscanf" ||
-                    funcName == "fread" || funcName == "fwrite") {
-                    loop->has_io_operations = true;
-                } else if (funcName == "sin" || funcName == "cos" || 
-                           funcName == "exp" || funcName == "sqrt" ||
-                           funcName == "pow" || funcName == "log") {
-                    // Math functions are safe for parallelization
-                    loop->has_function_calls = true;
-                } else {
-                    // Other function calls
-                    loop->has_function_calls = true;
-                }
+        bool VisitDeclStmt(DeclStmt *DS) {
+            for (auto *D : DS->decls()) {
+                if (VarDecl *VD = dyn_cast<VarDecl>(D)) locals.insert(VD->getNameAsString());
             }
             return true;
         }
         
-        // Check for C++ stream I/O
-        bool VisitCXXOperatorCallExpr(CXXOperatorCallExpr *CE) {
-            if (FunctionDecl *FD = CE->getDirectCallee()) {
-                std::string opName = FD->getNameAsString();
-                // Check for << or >> operators
-                if (opName.find("operator<<") != std::string::npos ||
-                    opName.find("operator>>") != std::string::npos) {
-                    loop->has_io_operations = true;
-                    return true;
+        bool VisitCompoundStmt(CompoundStmt *CS) {
+            bool endsWithBreak = false;
+            for (Stmt *S : CS->body()) {
+                if (isa<BreakStmt>(S)) endsWithBreak = true;
+            }
+            if (endsWithBreak) {
+                for (Stmt *S : CS->body()) {
+                    BinaryOperator *BO = dyn_cast<BinaryOperator>(S);
+                    if (BO && BO->getOpcode() == BO_Assign) exitAssignments.insert(BO);
                 }
             }
             return true;
         }
         
-        bool VisitForStmt(ForStmt *FS) {
-            loop->is_nested = true;
-            return true;
+        void checkWrite(Stmt *S, Expr *target) {
+            DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(target->IgnoreParenImpCasts());
+            if (!DRE) {
+                safe = false; // Element, member or pointer write
+                return;
+            }
+            std::string name = DRE->getDecl()->getNameAsString();
+            if (locals.count(name) || name == inductionVar) return;
+            if (exitAssignments.count(S)) {
+                exitWrites[name]++;
+                return;
+            }
+            safe = false;
         }
         
-        bool VisitWhileStmt(WhileStmt *WS) {
-            loop->is_nested = true;
+        bool VisitBinaryOperator(BinaryOperator *BO) {
+            if (BO->isAssignmentOp()) checkWrite(BO, BO->getLHS());
             return true;
         }
         
-        bool VisitDoStmt(DoStmt *DS) {
-            loop->is_nested = true;
+        bool VisitUnaryOperator(UnaryOperator *UO) {
+            if (UO->isIncrementDecrementOp()) checkWrite(UO, UO->getSubExpr());
+            if (UO->getOpcode() == UO_AddrOf) safe = false;
             return true;
         }
         
-        bool VisitBreakStmt(BreakStmt *BS) {
-            loop->has_break_continue = true;
+        bool VisitCallExpr(CallExpr *CE) {
+            static const std::set<std::string> pureFunctions = {
+                "sin", "cos", "tan", "exp", "log", "log10", "sqrt", "pow", "fabs", "abs",
+                "floor", "ceil", "fmin", "fmax", "fmod", "strcmp", "strncmp", "strlen", "memcmp"
+            };
+            if (CXXOperatorCallExpr *OCE = dyn_cast<CXXOperatorCallExpr>(CE)) {
+                switch (OCE->getOperator()) {
+                    case OO_Subscript: case OO_EqualEqual: case OO_ExclaimEqual:
+                    case OO_Less: case OO_Greater: case OO_LessEqual: case OO_GreaterEqual:
+                        return true;
+                    default:
+                        safe = false;
+                        return true;
+                }
+            }
+            if (CXXMemberCallExpr *MCE = dyn_cast<CXXMemberCallExpr>(CE)) {
+                if (!MCE->getMethodDecl() || !MCE->getMethodDecl()->isConst()) safe = false;
+                return true;
+            }
+            FunctionDecl *FD = CE->getDirectCallee();
+            if (!FD || !pureFunctions.count(FD->getNameAsString())) safe = false;
             return true;
         }
         
-        bool VisitContinueStmt(ContinueStmt *CS) {
-            loop->has_break_continue = true;
+        bool VisitDeclRefExpr(DeclRefExpr *DRE) {
+            if (isa<VarDecl>(DRE->getDecl())) references[DRE->getDecl()->getNameAsString()]++;
             return true;
         }
     };
     
-    LoopBodyVisitor visitor(&loop, loop.loop_variable, &globalVariables);
-    visitor.TraverseStmt(body);
+    // The body of a for loop must not touch its induction variable at all
+    SearchBodyChecker checker(loop.type == "for" ? "" : loop.loop_variable);
+    checker.TraverseStmt(body);
+    if (!checker.safe) return false;
     
-    // Pass local variables to dependency analysis
-    performDependencyAnalysis(loop, visitor.localVars);
+    // Result variables must only be written, never read, inside the loop
+    exitVars.clear();
+    for (const auto &pair : checker.exitWrites) {
+        if (checker.references[pair.first] != pair.second) return false;
+        exitVars.push_back(pair.first);
+    }
+    return true;
 }
 
-void ComprehensiveLoopAnalyzer::performDependencyAnalysis(LoopInfo &loop, const std::set<std::string> &localVars) {
-    // Remove duplicates
-    std::sort(loop.read_vars.begin(), loop.read_vars.end());
-    loop.read_vars.erase(std::unique(loop.read_vars.begin(), loop.read_vars.end()), loop.read_vars.end());
-    
-    std::sort(loop.write_vars.begin(), loop.write_vars.end());
-    loop.write_vars.erase(std::unique(loop.write_vars.begin(), loop.write_vars.end()), loop.write_vars.end());
-    
-    std::sort(loop.reduction_vars.begin(), loop.reduction_vars.end());
-    loop.reduction_vars.erase(std::unique(loop.reduction_vars.begin(), loop.reduction_vars.end()), loop.reduction_vars.end());
+// Variables assigned or incremented in S; element writes count for the array
+static void collectWrittenDecls(Stmt *S, std::set<const VarDecl*> &written) {
+    if (!S) return;
+    Expr *target = nullptr;
+    if (BinaryOperator *BO = dyn_cast<BinaryOperator>(S)) {
+        if (BO->isAssignmentOp()) target = BO->getLHS();
+    } else if (UnaryOperator *UO = dyn_cast<UnaryOperator>(S)) {
+        if (UO->isIncrementDecrementOp()) target = UO->getSubExpr();
+    }
+    if (target) {
+        target = target->IgnoreParenImpCasts();
+        while (ArraySubscriptExpr *ASE = dyn_cast<ArraySubscriptExpr>(target)) {
+            target = ASE->getBase()->IgnoreParenImpCasts();
+        }
+        if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(target)) {
+            if (VarDecl *VD = dyn_cast<VarDecl>(DRE->getDecl())) written.insert(VD);
+        }
+    }
+    for (Stmt *child : S->children()) {
+        collectWrittenDecls(child, written);
+    }
+}
+
+static bool isReferencedOutside(Stmt *S, const VarDecl *VD, SourceRange range, SourceManager &SM) {
+    if (!S) return false;
+    if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(S)) {
+        SourceLocation loc = DRE->getLocation();
+        if (DRE->getDecl() == VD && (SM.isBeforeInTranslationUnit(loc, range.getBegin()) ||
+                                     SM.isBeforeInTranslationUnit(range.getEnd(), loc))) {
+            return true;
+        }
+    }
+    for (Stmt *child : S->children()) {
+        if (isReferencedOutside(child, VD, range, SM)) return true;
+    }
+    return false;
+}
+
+static bool isReferencedBefore(Stmt *S, const VarDecl *VD, SourceLocation loc, SourceManager &SM) {
+    if (!S) return false;
+    if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(S)) {
+        if (DRE->getDecl() == VD && SM.isBeforeInTranslationUnit(DRE->getLocation(), loc)) return true;
+    }
+    for (Stmt *child : S->children()) {
+        if (isReferencedBefore(child, VD, loc, SM)) return true;
+    }
+    return false;
+}
+
+static bool evaluatesTo(Expr *E, uint64_t value, ASTContext &ctx) {
+    Expr::EvalResult result;
+    return E && E->EvaluateAsInt(result, ctx) && result.Val.getInt() == value;
+}
+
+static bool refersTo(Expr *E, const VarDecl *VD) {
+    DeclRefExpr *DRE = E ? dyn_cast<DeclRefExpr>(E->IgnoreParenImpCasts()) : nullptr;
+    return DRE && DRE->getDecl() == VD;
+}
+
+// First access of each candidate within one iteration, in evaluation order.
+// Writes only count when the statement runs unconditionally. An element
+// write makes an array written-first; it is only a fresh temporary when an
+// unconditional sweep (for (k = 0; k < N; k++) a[k] = ...) overwrites all
+// N elements before anything reads it.
+enum class IterationAccess { Unknown, WrittenFirst, ReadFirst };
+
+struct IterationAccessScan {
+    std::map<const VarDecl*, IterationAccess> state;
+    std::set<const VarDecl*> indexedByLoopVar;
+    std::set<const VarDecl*> sweptWhole;
+    std::string loopVar;
     
-    // Check for loop-carried dependencies
-    loop.has_dependencies = false;
-    std::string code = loop.source_code;
-    
-    // Look for array access patterns with loop variable offsets
-    if (!loop.loop_variable.empty()) {
-        // Pattern: array[i-k] or array[i+k] where k is a constant
-        std::regex dependency_pattern(R"((\w+)\s*\[\s*)" + loop.loop_variable + R"(\s*[-+]\s*\d+\s*\])");
-        if (std::regex_search(code, dependency_pattern)) {
-            // Check if the same array is being written to in the loop
-            std::smatch matches;
-            std::string temp_code = code;
-            while (std::regex_search(temp_code, matches, dependency_pattern)) {
-                std::string array_name = matches[1];
-                // Check if this array is also written to
-                std::regex write_pattern(array_name + R"(\s*\[\s*)" + loop.loop_variable + R"(\s*\]\s*=)");
-                if (std::regex_search(code, write_pattern)) {
-                    loop.has_dependencies = true;
+    const VarDecl *candidate(Expr *E) {
+        DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParenImpCasts());
+        const VarDecl *VD = DRE ? dyn_cast<VarDecl>(DRE->getDecl()) : nullptr;
+        return (VD && state.count(VD)) ? VD : nullptr;
+    }
+    
+    void mark(const VarDecl *VD, IterationAccess access) {
+        if (state[VD] == IterationAccess::Unknown) state[VD] = access;
+    }
+    
+    void scan(Stmt *S, bool definite) {
+        if (!S) return;
+        if (ForStmt *FS = dyn_cast<ForStmt>(S)) {
+            if (definite) noteSweep(FS);
+            scan(FS->getInit(), definite);
+            scan(FS->getCond(), definite);
+            scan(FS->getBody(), false);
+            scan(FS->getInc(), false);
+            return;
+        }
+        if (IfStmt *IS = dyn_cast<IfStmt>(S)) {
+            scan(IS->getCond(), definite);
+            scan(IS->getThen(), false);
+            scan(IS->getElse(), false);
+            return;
+        }
+        if (BinaryOperator *BO = dyn_cast<BinaryOperator>(S)) {
+            if (BO->getOpcode() == BO_Assign) {
+                scan(BO->getRHS(), definite);
+                Expr *lhs = BO->getLHS()->IgnoreParenImpCasts();
+                if (const VarDecl *VD = candidate(lhs)) {
+                    if (definite) mark(VD, IterationAccess::WrittenFirst);
+                    return;
+                }
+                Expr *base = lhs;
+                std::vector<Expr*> indices;
+                while (ArraySubscriptExpr *ASE = dyn_cast<ArraySubscriptExpr>(base)) {
+                    indices.push_back(ASE->getIdx());
+                    base = ASE->getBase()->IgnoreParenImpCasts();
+                }
+                if (const VarDecl *VD = indices.empty() ? nullptr : candidate(base)) {
+                    for (Expr *idx : indices) {
+                        noteSubscript(VD, idx);
+                        scan(idx, definite);
+                    }
+                    mark(VD, IterationAccess::WrittenFirst);
+                    return;
+                }
+                scan(BO->getLHS(), definite);
+                return;
+            }
+            if (BO->isLogicalOp()) {
+                scan(BO->getLHS(), definite);
+                scan(BO->getRHS(), false);
+                return;
+            }
+        }
+        if (ConditionalOperator *CO = dyn_cast<ConditionalOperator>(S)) {
+            scan(CO->getCond(), definite);
+            scan(CO->getTrueExpr(), false);
+            scan(CO->getFalseExpr(), false);
+            return;
+        }
+        if (ArraySubscriptExpr *ASE = dyn_cast<ArraySubscriptExpr>(S)) {
+            Expr *base = ASE->getBase()->IgnoreParenImpCasts();
+            while (ArraySubscriptExpr *inner = dyn_cast<ArraySubscriptExpr>(base)) {
+                base = inner->getBase()->IgnoreParenImpCasts();
+            }
+            if (const VarDecl *VD = candidate(base)) noteSubscript(VD, ASE->getIdx());
+        }
+        if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(S)) {
+            if (const VarDecl *VD = candidate(DRE)) mark(VD, IterationAccess::ReadFirst);
+            return;
+        }
+        // Sub-expressions are all evaluated; nested statements (loops, switch) may not run
+        bool childDefinite = definite && (isa<Expr>(S) || isa<CompoundStmt>(S) || isa<DeclStmt>(S));
+        for (Stmt *child : S->children()) {
+            scan(child, childDefinite);
+        }
+    }
+    
+    // for (k = 0; k < N; k++) a[k] = ... as the first access of a, with N its length
+    void noteSweep(ForStmt *FS) {
+        const VarDecl *index = nullptr;
+        Expr *start = nullptr;
+        if (DeclStmt *DS = dyn_cast_or_null<DeclStmt>(FS->getInit())) {
+            VarDecl *VD = DS->isSingleDecl() ? dyn_cast<VarDecl>(DS->getSingleDecl()) : nullptr;
+            if (VD) {
+                index = VD;
+                start = VD->getInit();
+            }
+        } else if (BinaryOperator *BO = dyn_cast_or_null<BinaryOperator>(FS->getInit())) {
+            DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(BO->getLHS()->IgnoreParenImpCasts());
+            if (BO->getOpcode() == BO_Assign && DRE) {
+                index = dyn_cast<VarDecl>(DRE->getDecl());
+                start = BO->getRHS();
+            }
+        }
+        BinaryOperator *cond = dyn_cast_or_null<BinaryOperator>(FS->getCond());
+        UnaryOperator *inc = dyn_cast_or_null<UnaryOperator>(FS->getInc());
+        if (!index || !cond || cond->getOpcode() != BO_LT || !refersTo(cond->getLHS(), index) ||
+            !inc || !inc->isIncrementOp() || !refersTo(inc->getSubExpr(), index)) {
+            return;
+        }
+        ASTContext &ctx = index->getASTContext();
+        if (!evaluatesTo(start, 0, ctx)) return;
+        
+        Stmt *first = FS->getBody();
+        if (CompoundStmt *CS = dyn_cast_or_null<CompoundStmt>(first)) {
+            first = CS->body_empty() ? nullptr : CS->body_front();
+        }
+        BinaryOperator *assign = dyn_cast_or_null<BinaryOperator>(first);
+        if (!assign || assign->getOpcode() != BO_Assign) return;
+        ArraySubscriptExpr *ASE = dyn_cast<ArraySubscriptExpr>(assign->getLHS()->IgnoreParenImpCasts());
+        const VarDecl *VD = ASE ? candidate(ASE->getBase()) : nullptr;
+        if (!VD || state[VD] != IterationAccess::Unknown || !refersTo(ASE->getIdx(), index)) return;
+        const ConstantArrayType *CAT = ctx.getAsConstantArrayType(VD->getType());
+        if (CAT && evaluatesTo(cond->getRHS(), CAT->getSize().getZExtValue(), ctx)) sweptWhole.insert(VD);
+    }
+    
+    // A subscript using the loop variable means one slot per iteration of a shared array
+    void noteSubscript(const VarDecl *VD, Expr *idx) {
+        std::set<std::string> vars;
+        collectReferencedVars(idx, vars);
+        if (vars.count(loopVar)) indexedByLoopVar.insert(VD);
+    }
+};
+
+void ComprehensiveLoopAnalyzer::analyzePrivatization(Stmt *body, LoopInfo &loop) {
+    loop.private_vars.clear();
+    loop.firstprivate_vars.clear();
+    loop.lastprivate_vars.clear();
+    loop.carried_scalars.clear();
+    if (!body || !currentFunctionBody) return;
+    
+    // Variables handled by other clauses keep them
+    std::set<std::string> handled(loop.reduction_vars.begin(), loop.reduction_vars.end());
+    handled.insert(loop.exit_vars.begin(), loop.exit_vars.end());
+    handled.insert(loop.thread_local_vars.begin(), loop.thread_local_vars.end());
+    handled.insert(loop.loop_variable);
+    handled.insert(loop.conflicting_arrays.begin(), loop.conflicting_arrays.end());
+    for (const auto& array : loop.array_reductions) handled.insert(array.name);
+    
+    // Candidates: scalars and fixed-size arrays of the function, declared before the loop body
+    std::set<const VarDecl*> written;
+    collectWrittenDecls(body, written);
+    IterationAccessScan scan;
+    scan.loopVar = loop.loop_variable;
+    for (const VarDecl *VD : written) {
+        QualType type = VD->getType();
+        bool isArray = type->isConstantArrayType() &&
+                       type->castAsArrayTypeUnsafe()->getElementType()->isScalarType();
+        if (!VD->hasLocalStorage() || handled.count(VD->getNameAsString()) ||
+            !(type->isScalarType() || isArray) ||
+            !SM->isBeforeInTranslationUnit(VD->getLocation(), body->getBeginLoc())) {
+            continue;
+        }
+        scan.state[VD] = IterationAccess::Unknown;
+    }
+    scan.scan(body, true);
+    
+    for (const auto &entry : scan.state) {
+        const VarDecl *VD = entry.first;
+        std::string name = VD->getNameAsString();
+        bool isArray = VD->getType()->isConstantArrayType();
+        
+        // Arrays indexed by the loop variable are shared outputs, not temporaries
+        if (isArray && scan.indexedByLoopVar.count(VD)) continue;
+        
+        if (entry.second == IterationAccess::ReadFirst) {
+            if (!isArray) loop.carried_scalars.push_back(name);
+            continue;
+        }
+        // Only written conditionally: left shared as before
+        if (entry.second != IterationAccess::WrittenFirst) continue;
+        
+        // A partly overwritten array keeps its other elements from before the loop
+        bool startsFromInit = isArray && !scan.sweptWhole.count(VD) &&
+                              (VD->hasInit() || isReferencedBefore(currentFunctionBody, VD, body->getBeginLoc(), *SM));
+        if (startsFromInit) loop.firstprivate_vars.push_back(name);
+        if (isReferencedOutside(currentFunctionBody, VD, body->getSourceRange(), *SM)) {
+            loop.lastprivate_vars.push_back(name);
+        } else if (!startsFromInit) {
+            loop.private_vars.push_back(name);
+        }
+    }
+    std::sort(loop.private_vars.begin(), loop.private_vars.end());
+    std::sort(loop.firstprivate_vars.begin(), loop.firstprivate_vars.end());
+    std::sort(loop.lastprivate_vars.begin(), loop.lastprivate_vars.end());
+    std::sort(loop.carried_scalars.begin(), loop.carried_scalars.end());
+}
+
+// Arrays up to this size get a private copy per thread via an array-section reduction;
+// larger or unsized targets are updated in place under omp atomic
+static const uint64_t ARRAY_REDUCTION_MAX_ELEMENTS = 4096;
+
+// One A[idx] op= v / A[idx]++ statement inside a loop body
+struct IndirectUpdate {
+    const VarDecl *array = nullptr;
+    std::string op;
+    std::string elementType;
+    bool arithmetic = false;
+    Stmt *stmt = nullptr;
+    bool standalone = false;   // Own statement, so omp atomic can precede it
+    bool indirect = false;     // Subscript is not just the loop variable
+};
+
+// Resolve an element access to its array: plain arrays, pointers and std::vector
+static const VarDecl *subscriptedArray(Expr *E, Expr *&idx, bool &isContainer) {
+    E = E->IgnoreParenImpCasts();
+    Expr *base = nullptr;
+    isContainer = false;
+    if (ArraySubscriptExpr *ASE = dyn_cast<ArraySubscriptExpr>(E)) {
+        base = ASE->getBase()->IgnoreParenImpCasts();
+        idx = ASE->getIdx();
+    } else if (CXXOperatorCallExpr *OCE = dyn_cast<CXXOperatorCallExpr>(E)) {
+        if (OCE->getOperator() != OO_Subscript || OCE->getNumArgs() != 2) return nullptr;
+        base = OCE->getArg(0)->IgnoreParenImpCasts();
+        idx = OCE->getArg(1);
+        isContainer = true;
+    }
+    DeclRefExpr *DRE = dyn_cast_or_null<DeclRefExpr>(base);
+    if (!DRE) return nullptr;
+    const VarDecl *VD = dyn_cast<VarDecl>(DRE->getDecl());
+    if (!VD) return nullptr;
+    if (isContainer) {
+        const CXXRecordDecl *RD = VD->getType().getNonReferenceType()->getAsCXXRecordDecl();
+        if (!RD || RD->getQualifiedNameAsString() != "std::vector") return nullptr;
+    }
+    return VD;
+}
+
+// Match a statement-level update and report its canonical reduction operator
+static bool matchElementUpdate(Expr *E, Expr *&element, std::string &op) {
+    E = E->IgnoreParens();
+    if (UnaryOperator *UO = dyn_cast<UnaryOperator>(E)) {
+        if (!UO->isIncrementDecrementOp()) return false;
+        element = UO->getSubExpr();
+        op = "+";
+        return true;
+    }
+    if (CompoundAssignOperator *CAO = dyn_cast<CompoundAssignOperator>(E)) {
+        switch (CAO->getOpcode()) {
+            case BO_AddAssign:
+            case BO_SubAssign: op = "+"; break;   // Subtracting v adds -v
+            case BO_MulAssign: op = "*"; break;
+            case BO_AndAssign: op = "&"; break;
+            case BO_OrAssign:  op = "|"; break;
+            case BO_XorAssign: op = "^"; break;
+            default: return false;
+        }
+        element = CAO->getLHS();
+        return true;
+    }
+    return false;
+}
+
+void ComprehensiveLoopAnalyzer::analyzeIndirectUpdates(Stmt *body, LoopInfo &loop) {
+    loop.array_reductions.clear();
+    loop.atomic_offsets.clear();
+    loop.conflicting_arrays.clear();
+    
+    class IndirectUpdateFinder {
+    public:
+        std::string loopVar;
+        std::vector<IndirectUpdate> updates;
+        std::map<const VarDecl*, int> references;
+        
+        void scan(Stmt *S, Stmt *parent) {
+            if (!S) return;
+            if (Expr *E = dyn_cast<Expr>(S)) {
+                Expr *element = nullptr;
+                IndirectUpdate update;
+                if (matchElementUpdate(E, element, update.op)) {
+                    Expr *idx = nullptr;
+                    bool isContainer = false;
+                    if ((update.array = subscriptedArray(element, idx, isContainer))) {
+                        DeclRefExpr *idxRef = dyn_cast<DeclRefExpr>(idx->IgnoreParenImpCasts());
+                        update.indirect = !idxRef || idxRef->getDecl()->getNameAsString() != loopVar;
+                        update.elementType = element->getType().getCanonicalType().getUnqualifiedType().getAsString();
+                        update.arithmetic = element->getType()->isArithmeticType();
+                        update.stmt = S;
+                        update.standalone = isStatementOf(S, parent);
+                        updates.push_back(update);
+                    }
+                }
+            }
+            if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(S)) {
+                if (const VarDecl *VD = dyn_cast<VarDecl>(DRE->getDecl())) references[VD]++;
+            }
+            for (Stmt *child : S->children()) {
+                scan(child, S);
+            }
+        }
+        
+        // omp atomic applies to an expression statement, not to a sub-expression
+        static bool isStatementOf(Stmt *S, Stmt *parent) {
+            if (!parent || isa<CompoundStmt>(parent)) return true;
+            if (IfStmt *IS = dyn_cast<IfStmt>(parent)) return S == IS->getThen() || S == IS->getElse();
+            if (ForStmt *FS = dyn_cast<ForStmt>(parent)) return S == FS->getBody();
+            if (WhileStmt *WS = dyn_cast<WhileStmt>(parent)) return S == WS->getBody();
+            if (DoStmt *DS = dyn_cast<DoStmt>(parent)) return S == DS->getBody();
+            return false;
+        }
+    };
+    
+    IndirectUpdateFinder finder;
+    finder.loopVar = loop.loop_variable;
+    finder.scan(body, nullptr);
+    
+    std::map<const VarDecl*, std::vector<IndirectUpdate>> byArray;
+    std::set<const VarDecl*> indirectArrays;
+    for (const auto& update : finder.updates) {
+        byArray[update.array].push_back(update);
+        if (update.indirect) indirectArrays.insert(update.array);
+    }
+    
+    for (const VarDecl *VD : indirectArrays) {
+        // Arrays declared inside the body are already one per iteration
+        if (!SM->isBeforeInTranslationUnit(VD->getLocation(), body->getBeginLoc())) continue;
+        
+        const auto& updates = byArray[VD];
+        std::string name = VD->getNameAsString();
+        
+        // Every other read or write of the array would race with the combined updates
+        bool consistent = finder.references[VD] == (int)updates.size();
+        for (const auto& update : updates) {
+            if (update.op != updates.front().op || !update.arithmetic) {
+                consistent = false;
+            }
+        }
+        
+        ArrayReduction reduction;
+        reduction.name = name;
+        reduction.op = updates.front().op;
+        reduction.element_type = updates.front().elementType;
+        
+        QualType type = VD->getType().getNonReferenceType();
+        const ConstantArrayType *CAT = VD->getASTContext().getAsConstantArrayType(type);
+        if (CAT && !CAT->getElementType()->isArrayType()) {
+            uint64_t length = CAT->getSize().getZExtValue();
+            reduction.length_expr = std::to_string(length);
+            reduction.use_atomic = length > ARRAY_REDUCTION_MAX_ELEMENTS;
+        } else if (type->getAsCXXRecordDecl()) {
+            reduction.is_container = true;
+            reduction.length_expr = name + ".size()";
+            reduction.use_atomic = true;
+        } else {
+            reduction.use_atomic = true;
+        }
+        
+        if (reduction.use_atomic) {
+            for (const auto& update : updates) {
+                SourceLocation loc = update.stmt->getBeginLoc();
+                if (!update.standalone || loc.isMacroID()) {
+                    consistent = false;
                     break;
                 }
-                temp_code = matches.suffix();
             }
         }
+        
+        if (!consistent) {
+            loop.conflicting_arrays.push_back(name);
+            continue;
+        }
+        
+        if (reduction.use_atomic) {
+            unsigned bodyStart = SM->getFileOffset(body->getBeginLoc());
+            for (const auto& update : updates) {
+                loop.atomic_offsets.push_back(SM->getFileOffset(update.stmt->getBeginLoc()) - bodyStart);
+            }
+        }
+        loop.array_reductions.push_back(reduction);
+    }
+    
+    std::sort(loop.atomic_offsets.begin(), loop.atomic_offsets.end());
+    std::sort(loop.array_reductions.begin(), loop.array_reductions.end(),
+              [](const ArrayReduction &a, const ArrayReduction &b) { return a.name < b.name; });
+    std::sort(loop.conflicting_arrays.begin(), loop.conflicting_arrays.end());
+}
+
+// Number of references to VD under S
+static int countReferences(Stmt *S, const VarDecl *VD) {
+    if (!S) return 0;
+    int count = 0;
+    if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(S)) {
+        if (DRE->getDecl() == VD) count++;
+    }
+    for (Stmt *child : S->children()) {
+        count += countReferences(child, VD);
+    }
+    return count;
+}
+
+// Whether S refers to a variable declared inside body. The MPI block sums
+// evaluate the contribution in a loop of their own, where those do not exist.
+static bool refersToDeclsIn(Stmt *S, Stmt *body, SourceManager &SM) {
+    if (!S) return false;
+    if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(S)) {
+        SourceLocation loc = DRE->getDecl()->getLocation();
+        if (!SM.isBeforeInTranslationUnit(loc, body->getBeginLoc()) &&
+            !SM.isBeforeInTranslationUnit(body->getEndLoc(), loc)) {
+            return true;
+        }
+    }
+    for (Stmt *child : S->children()) {
+        if (refersToDeclsIn(child, body, SM)) return true;
+    }
+    return false;
+}
+
+// A[var - 1] for the given array and loop variable
+static bool isPreviousElement(Expr *E, const VarDecl *array, const std::string &loopVar) {
+    ArraySubscriptExpr *ASE = dyn_cast<ArraySubscriptExpr>(E->IgnoreParenImpCasts());
+    if (!ASE) return false;
+    DeclRefExpr *base = dyn_cast<DeclRefExpr>(ASE->getBase()->IgnoreParenImpCasts());
+    BinaryOperator *idx = dyn_cast<BinaryOperator>(ASE->getIdx()->IgnoreParenImpCasts());
+    if (!base || base->getDecl() != array || !idx || idx->getOpcode() != BO_Sub) return false;
+    DeclRefExpr *var = dyn_cast<DeclRefExpr>(idx->getLHS()->IgnoreParenImpCasts());
+    IntegerLiteral *one = dyn_cast<IntegerLiteral>(idx->getRHS()->IgnoreParenImpCasts());
+    return var && var->getDecl()->getNameAsString() == loopVar && one && one->getValue() == 1;
+}
+
+void ComprehensiveLoopAnalyzer::analyzeScan(Stmt *body, LoopInfo &loop) {
+    loop.is_scan_loop = false;
+    loop.scan = PrefixScan();
+    
+    if (!body) return;
+    
+    // Ascending for-loops with a constant step; omp scan needs the update at the top level of the body
+    CompoundStmt *CS = dyn_cast<CompoundStmt>(body);
+    const std::string &step = loop.step_expr;
+    bool scanShape = CS && loop.type == "for" && loop.is_canonical && !loop.has_break_continue &&
+                     !loop.has_early_return && !step.empty() && step != "0" &&
+                     std::all_of(step.begin(), step.end(), ::isdigit);
+    std::vector<Stmt*> stmts;
+    if (CS) stmts.assign(CS->body_begin(), CS->body_end());
+    else stmts.push_back(body);
+    unsigned bodyStart = SM->getFileOffset(body->getBeginLoc());
+    
+    // Recurrence: the whole body is a[i] = a[i-1] + e, a[i] = e + a[i-1] or a[i] += a[i-1]
+    if (scanShape && stmts.size() == 1 && step == "1") {
+        BinaryOperator *BO = dyn_cast<BinaryOperator>(stmts[0]);
+        ArraySubscriptExpr *LHS = BO ? dyn_cast<ArraySubscriptExpr>(BO->getLHS()->IgnoreParens()) : nullptr;
+        DeclRefExpr *base = LHS ? dyn_cast<DeclRefExpr>(LHS->getBase()->IgnoreParenImpCasts()) : nullptr;
+        DeclRefExpr *idx = LHS ? dyn_cast<DeclRefExpr>(LHS->getIdx()->IgnoreParenImpCasts()) : nullptr;
+        const VarDecl *array = base ? dyn_cast<VarDecl>(base->getDecl()) : nullptr;
+        if (array && idx && idx->getDecl()->getNameAsString() == loop.loop_variable &&
+            LHS->getType()->isArithmeticType()) {
+            Expr *contribution = nullptr;
+            if (BO->getOpcode() == BO_AddAssign && isPreviousElement(BO->getRHS(), array, loop.loop_variable)) {
+                contribution = LHS;
+            } else if (BO->getOpcode() == BO_Assign) {
+                BinaryOperator *sum = dyn_cast<BinaryOperator>(BO->getRHS()->IgnoreParenImpCasts());
+                if (sum && sum->getOpcode() == BO_Add) {
+                    if (isPreviousElement(sum->getLHS(), array, loop.loop_variable)) contribution = sum->getRHS();
+                    else if (isPreviousElement(sum->getRHS(), array, loop.loop_variable)) contribution = sum->getLHS();
+                }
+                if (contribution && countReferences(contribution, array) > 0) contribution = nullptr;
+            }
+            if (contribution) {
+                loop.is_scan_loop = true;
+                loop.scan.var = "_scan_" + array->getNameAsString();
+                loop.scan.type = LHS->getType().getCanonicalType().getUnqualifiedType().getAsString();
+                loop.scan.array = array->getNameAsString();
+                loop.scan.target = getSourceText(LHS->getSourceRange());
+                loop.scan.update_expr = getSourceText(contribution->getSourceRange());
+                loop.scan.update_pure = !contribution->HasSideEffects(array->getASTContext()) &&
+                                        !refersToDeclsIn(contribution, body, *SM);
+                return;
+            }
+        }
+    }
+    
+    // Running sum: one top-level "v += e", with every other use of v a read on one side of it
+    std::set<const VarDecl*> written;
+    collectWrittenDecls(body, written);
+    for (const VarDecl *VD : written) {
+        std::string name = VD->getNameAsString();
+        if (std::find(loop.reduction_vars.begin(), loop.reduction_vars.end(), name) == loop.reduction_vars.end()) continue;
+        
+        std::vector<size_t> updates;
+        for (size_t k = 0; k < stmts.size(); ++k) {
+            CompoundAssignOperator *CAO = dyn_cast<CompoundAssignOperator>(stmts[k]);
+            DeclRefExpr *target = CAO ? dyn_cast<DeclRefExpr>(CAO->getLHS()->IgnoreParenImpCasts()) : nullptr;
+            if (target && target->getDecl() == VD) updates.push_back(k);
+        }
+        
+        // Reads elsewhere in the body; none means an ordinary reduction
+        int reads = countReferences(body, VD) - (int)updates.size();
+        if (reads == 0) continue;
+        
+        // inscan cannot share the construct with other reductions (or atomics in the rebuilt body)
+        bool onlyReduction = loop.reduction_vars.size() == 1 && loop.array_reductions.empty();
+        bool scannable = scanShape && onlyReduction && updates.size() == 1 && VD->getType()->isArithmeticType() &&
+                         cast<CompoundAssignOperator>(stmts[updates[0]])->getOpcode() == BO_AddAssign;
+        bool readsBefore = false, readsAfter = false;
+        for (size_t k = 0; scannable && k < stmts.size(); ++k) {
+            if (k == updates[0]) continue;
+            std::set<const VarDecl*> writes;
+            collectWrittenDecls(stmts[k], writes);
+            if (writes.count(VD)) scannable = false;
+            if (countReferences(stmts[k], VD) > 0) (k < updates[0] ? readsBefore : readsAfter) = true;
+        }
+        Expr *contribution = scannable ? cast<CompoundAssignOperator>(stmts[updates[0]])->getRHS() : nullptr;
+        if (!scannable || (readsBefore && readsAfter) || countReferences(contribution, VD) > 0) {
+            // The running value flows from one iteration into the next
+            loop.reduction_vars.erase(std::remove(loop.reduction_vars.begin(), loop.reduction_vars.end(), name),
+                                      loop.reduction_vars.end());
+            loop.carried_scalars.push_back(name);
+            continue;
+        }
+        
+        // Inclusive: the directive follows the update; exclusive: it precedes it
+        loop.is_scan_loop = true;
+        loop.scan.var = name;
+        loop.scan.type = VD->getType().getCanonicalType().getUnqualifiedType().getAsString();
+        loop.scan.exclusive = readsBefore;
+        Stmt *splitBefore = stmts[readsBefore ? updates[0] : updates[0] + 1];
+        loop.scan.split_offset = SM->getFileOffset(splitBefore->getBeginLoc()) - bodyStart;
+        loop.scan.update_expr = getSourceText(contribution->getSourceRange());
+        loop.scan.update_pure = !contribution->HasSideEffects(VD->getASTContext()) &&
+                                !refersToDeclsIn(contribution, body, *SM);
+        loop.reduction_vars.erase(std::remove(loop.reduction_vars.begin(), loop.reduction_vars.end(), name),
+                                  loop.reduction_vars.end());
+    }
+    std::sort(loop.carried_scalars.begin(), loop.carried_scalars.end());
+}
+
+// Calls the structs could be reached through: anything except element access and
+// library functions such as sqrt
+static bool hasUserCall(Stmt *S, SourceManager &SM) {
+    if (!S) return false;
+    if (CXXOperatorCallExpr *OCE = dyn_cast<CXXOperatorCallExpr>(S)) {
+        if (OCE->getOperator() != OO_Subscript) return true;
+    } else if (CallExpr *CE = dyn_cast<CallExpr>(S)) {
+        const FunctionDecl *FD = CE->getDirectCallee();
+        if (!FD || !SM.isInSystemHeader(FD->getLocation())) return true;
+    }
+    for (Stmt *child : S->children()) {
+        if (hasUserCall(child, SM)) return true;
+    }
+    return false;
+}
+
+// Outermost loop of the function enclosing the for-loop whose body is given
+static Stmt *enclosingRepeatLoop(Stmt *S, Stmt *body, SourceManager &SM) {
+    if (!S || isa<LambdaExpr>(S)) return nullptr;
+    if (SM.isBeforeInTranslationUnit(body->getBeginLoc(), S->getBeginLoc()) ||
+        SM.isBeforeInTranslationUnit(S->getEndLoc(), body->getEndLoc())) {
+        return nullptr;
+    }
+    if (ForStmt *FS = dyn_cast<ForStmt>(S)) {
+        if (FS->getBody() == body) return nullptr;
+    }
+    if (isa<ForStmt>(S) || isa<WhileStmt>(S) || isa<DoStmt>(S) || isa<CXXForRangeStmt>(S)) return S;
+    for (Stmt *child : S->children()) {
+        if (Stmt *loop = enclosingRepeatLoop(child, body, SM)) return loop;
+    }
+    return nullptr;
+}
+
+static int countReferences(Stmt *S, const VarDecl *VD) {
+    if (!S) return 0;
+    DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(S);
+    int count = (DRE && DRE->getDecl() == VD) ? 1 : 0;
+    for (Stmt *child : S->children()) {
+        count += countReferences(child, VD);
+    }
+    return count;
+}
+
+// return, goto or throw would skip code placed after the statement
+static bool leavesStatement(Stmt *S) {
+    if (!S || isa<LambdaExpr>(S)) return false;
+    if (isa<ReturnStmt>(S) || isa<GotoStmt>(S) || isa<IndirectGotoStmt>(S) || isa<CXXThrowExpr>(S)) return true;
+    for (Stmt *child : S->children()) {
+        if (leavesStatement(child)) return true;
+    }
+    return false;
+}
+
+void ComprehensiveLoopAnalyzer::analyzeStructAccesses(Stmt *body, LoopInfo &loop) {
+    loop.soa_candidates.clear();
+    loop.soa_copy_offset = std::string::npos;
+    loop.soa_copy_length = 0;
+    
+    // Accesses are rewritten in the for-loop's own text, so they must be spelled there
+    if (!body || loop.type != "for" || !loop.is_canonical || body->getBeginLoc().isMacroID()) return;
+    if (hasUserCall(body, *SM)) return;
+    
+    // The copies only pay off when they are made once around a loop that runs
+    // this one many times; that loop must keep the structs to this loop as well
+    Stmt *repeat = enclosingRepeatLoop(currentFunctionBody, body, *SM);
+    if (!repeat || hasUserCall(repeat, *SM) || leavesStatement(repeat)) return;
+    SourceLocation repeatEnd = isa<DoStmt>(repeat)
+        ? Lexer::findLocationAfterToken(repeat->getEndLoc(), tok::semi, *SM, LangOptions(), false)
+        : Lexer::getLocForEndOfToken(repeat->getEndLoc(), 0, *SM, LangOptions());
+    size_t repeatStart = offsetInFunction(repeat->getBeginLoc());
+    if (repeatStart == std::string::npos || repeatEnd.isInvalid() || repeatEnd.isMacroID()) return;
+    
+    class StructAccessFinder {
+    public:
+        std::string loopVar;
+        struct Access {
+            const VarDecl *container;
+            const FieldDecl *field;
+            MemberExpr *expr;
+        };
+        std::vector<Access> accesses;
+        std::set<const FieldDecl*> written;
+        bool escapes = false;
+        
+        void scan(Stmt *S) {
+            if (!S) return;
+            if (BinaryOperator *BO = dyn_cast<BinaryOperator>(S)) {
+                if (BO->isAssignmentOp()) noteWrite(BO->getLHS());
+            } else if (UnaryOperator *UO = dyn_cast<UnaryOperator>(S)) {
+                if (UO->isIncrementDecrementOp()) noteWrite(UO->getSubExpr());
+                // A pointer to a field would outlive the copy
+                if (UO->getOpcode() == UO_AddrOf && isa<MemberExpr>(UO->getSubExpr()->IgnoreParens())) escapes = true;
+            }
+            if (DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+                for (Decl *D : DS->decls()) {
+                    VarDecl *VD = dyn_cast<VarDecl>(D);
+                    if (VD && VD->getType()->isReferenceType()) escapes = true;
+                }
+            }
+            if (MemberExpr *ME = dyn_cast<MemberExpr>(S)) {
+                matchAccess(ME);
+            }
+            for (Stmt *child : S->children()) {
+                scan(child);
+            }
+        }
+        
+        void noteWrite(Expr *E) {
+            if (MemberExpr *ME = dyn_cast<MemberExpr>(E->IgnoreParens())) {
+                if (const FieldDecl *FD = dyn_cast<FieldDecl>(ME->getMemberDecl())) written.insert(FD);
+            }
+        }
+        
+        // v[i].f with v an array or std::vector of structs and i the loop variable
+        void matchAccess(MemberExpr *ME) {
+            if (ME->isArrow()) return;
+            const FieldDecl *FD = dyn_cast<FieldDecl>(ME->getMemberDecl());
+            if (!FD || FD->isBitField() || !FD->getType()->isArithmeticType()) return;
+            Expr *idx = nullptr;
+            bool isContainer = false;
+            const VarDecl *VD = subscriptedArray(ME->getBase(), idx, isContainer);
+            if (!VD) return;
+            DeclRefExpr *idxRef = dyn_cast<DeclRefExpr>(idx->IgnoreParenImpCasts());
+            if (!idxRef || idxRef->getDecl()->getNameAsString() != loopVar) return;
+            accesses.push_back({VD, FD, ME});
+        }
+    };
+    
+    StructAccessFinder finder;
+    finder.loopVar = loop.loop_variable;
+    finder.scan(body);
+    if (finder.escapes) return;
+    
+    std::map<const VarDecl*, std::vector<StructAccessFinder::Access>> byContainer;
+    for (const auto& access : finder.accesses) {
+        byContainer[access.container].push_back(access);
+    }
+    
+    unsigned bodyStart = SM->getFileOffset(body->getBeginLoc());
+    for (const auto& entry : byContainer) {
+        const VarDecl *VD = entry.first;
+        const auto& accesses = entry.second;
+        
+        // Containers declared inside the repeat loop are fresh every iteration, and
+        // any other use of the container there (whole elements, other indices,
+        // other loops) would see the structs instead of the copies
+        if (!SM->isBeforeInTranslationUnit(VD->getLocation(), repeat->getBeginLoc())) continue;
+        if (countReferences(repeat, VD) != (int)accesses.size()) continue;
+        
+        const RecordDecl *RD = accesses.front().field->getParent();
+        SoACandidate candidate;
+        candidate.container = VD->getNameAsString();
+        candidate.total_fields = std::distance(RD->field_begin(), RD->field_end());
+        if (candidate.total_fields < 2) continue;
+        
+        QualType type = VD->getType().getNonReferenceType();
+        if (const ConstantArrayType *CAT = VD->getASTContext().getAsConstantArrayType(type)) {
+            if (CAT->getElementType()->isArrayType()) continue;
+            candidate.length_expr = std::to_string(CAT->getSize().getZExtValue());
+        } else if (type->getAsCXXRecordDecl()) {
+            candidate.length_expr = candidate.container + ".size()";
+        } else {
+            continue;   // Pointer parameters carry no length
+        }
+        
+        bool spelled = true;
+        std::set<const FieldDecl*> touched;
+        for (const auto& access : accesses) {
+            SourceLocation begin = access.expr->getBeginLoc();
+            SourceLocation member = access.expr->getMemberLoc();
+            if (begin.isMacroID() || member.isMacroID()) {
+                spelled = false;
+                break;
+            }
+            unsigned start = SM->getFileOffset(begin);
+            unsigned end = SM->getFileOffset(member) + Lexer::MeasureTokenLength(member, *SM, LangOptions());
+            candidate.access_ranges.push_back({start - bodyStart, end - start});
+            candidate.access_fields.push_back(access.field->getNameAsString());
+            touched.insert(access.field);
+        }
+        if (!spelled) continue;
+        
+        for (const FieldDecl *FD : RD->fields()) {
+            if (!touched.count(FD)) continue;
+            SoAField field;
+            field.name = FD->getNameAsString();
+            field.type = FD->getType().getCanonicalType().getUnqualifiedType().getAsString();
+            field.written = finder.written.count(FD) > 0;
+            candidate.fields.push_back(field);
+        }
+        loop.soa_candidates.push_back(candidate);
+    }
+    
+    std::sort(loop.soa_candidates.begin(), loop.soa_candidates.end(),
+              [](const SoACandidate &a, const SoACandidate &b) { return a.container < b.container; });
+    if (!loop.soa_candidates.empty()) {
+        loop.soa_copy_offset = repeatStart;
+        loop.soa_copy_length = SM->getFileOffset(repeatEnd) - SM->getFileOffset(repeat->getBeginLoc());
+    }
+}
+
+void ComprehensiveLoopAnalyzer::analyzeInvariants(Stmt *body, LoopInfo &loop) {
+    loop.invariants.clear();
+    if (!body || loop.type != "for" || !loop.is_canonical || body->getBeginLoc().isMacroID() || !currentFunctionBody) {
+        return;
+    }
+    
+    // Variables are only invariant when nothing in the body can change them: locals
+    // and parameters that are never written and whose address never escapes.
+    // References may alias anything the body stores to through another name.
+    class InvariantFinder {
+    public:
+        SourceManager *SM;
+        const std::map<std::string, FunctionAnalysis> *analysis;
+        Stmt *body;
+        SourceLocation loopBegin;             // The for keyword: for-init declarations are not in scope before it
+        std::string loopVar;
+        std::map<std::string, int> writes;
+        std::set<const VarDecl*> escaped;     // Address taken or bound to a reference in the function
+        bool aliasWrites = false;             // Stores or calls that may reach a referenced object
+        bool elementWrites = false;           // Stores to array elements, which a scalar reference may name
+        bool hasLambda = false;
+        std::vector<Expr*> found;
+        
+        bool pureCall(const FunctionDecl *FD) {
+            if (ComprehensiveFunctionAnalyzer::isPureLibraryFunction(FD)) return true;
+            if (!FD || !analysis || isa<CXXMethodDecl>(FD)) return false;
+            auto it = analysis->find(FD->getNameAsString());
+            return it != analysis->end() && it->second.isPure;
+        }
+        
+        static const VarDecl *namedVar(Expr *E) {
+            DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParenImpCasts());
+            return DRE ? dyn_cast<VarDecl>(DRE->getDecl()) : nullptr;
+        }
+        
+        void noteEscapes(Stmt *S) {
+            if (!S) return;
+            if (isa<LambdaExpr>(S)) hasLambda = true;
+            if (UnaryOperator *UO = dyn_cast<UnaryOperator>(S)) {
+                if (UO->getOpcode() == UO_AddrOf) {
+                    if (const VarDecl *VD = namedVar(UO->getSubExpr())) escaped.insert(VD);
+                }
+            } else if (DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+                for (Decl *D : DS->decls()) {
+                    VarDecl *VD = dyn_cast<VarDecl>(D);
+                    if (VD && VD->getType()->isReferenceType() && VD->getInit()) {
+                        if (const VarDecl *target = namedVar(VD->getInit())) escaped.insert(target);
+                    }
+                }
+            }
+            for (Stmt *child : S->children()) {
+                noteEscapes(child);
+            }
+        }
+        
+        void noteStore(Expr *target) {
+            target = target->IgnoreParenImpCasts();
+            if (isa<ArraySubscriptExpr>(target)) {
+                elementWrites = true;
+            } else if (const VarDecl *VD = namedVar(target)) {
+                if (VD->getType()->isReferenceType()) aliasWrites = true;
+            } else {
+                aliasWrites = true;   // *p = ..., p->x = ...
+            }
+        }
+        
+        void noteAliasWrites(Stmt *S) {
+            if (!S) return;
+            if (BinaryOperator *BO = dyn_cast<BinaryOperator>(S)) {
+                if (BO->isAssignmentOp()) noteStore(BO->getLHS());
+            } else if (UnaryOperator *UO = dyn_cast<UnaryOperator>(S)) {
+                if (UO->isIncrementDecrementOp()) noteStore(UO->getSubExpr());
+            } else if (CXXOperatorCallExpr *OCE = dyn_cast<CXXOperatorCallExpr>(S)) {
+                // Element access leaves the container alone; any other mutating
+                // operator (=, +=, ++) changes its left operand
+                const CXXMethodDecl *MD = dyn_cast_or_null<CXXMethodDecl>(OCE->getDirectCallee());
+                if (OCE->getOperator() == OO_Subscript) {
+                    elementWrites = true;
+                } else if (!MD || !MD->isConst()) {
+                    aliasWrites = true;
+                    if (OCE->getNumArgs() > 0) {
+                        if (const VarDecl *VD = namedVar(OCE->getArg(0))) writes[VD->getNameAsString()]++;
+                    }
+                }
+            } else if (CXXMemberCallExpr *MCE = dyn_cast<CXXMemberCallExpr>(S)) {
+                if (!MCE->getMethodDecl() || !MCE->getMethodDecl()->isConst()) aliasWrites = true;
+            } else if (CallExpr *CE = dyn_cast<CallExpr>(S)) {
+                if (!pureCall(CE->getDirectCallee())) aliasWrites = true;
+            }
+            for (Stmt *child : S->children()) {
+                noteAliasWrites(child);
+            }
+        }
+        
+        bool invariantVar(const VarDecl *VD) {
+            if (!VD->hasLocalStorage() || VD->getNameAsString() == loopVar || writes.count(VD->getNameAsString()) ||
+                escaped.count(VD) || VD->getType().isVolatileQualified() ||
+                !SM->isBeforeInTranslationUnit(VD->getLocation(), loopBegin)) {
+                return false;
+            }
+            if (VD->getType()->isReferenceType()) {
+                if (aliasWrites) return false;
+                if (elementWrites && !VD->getType().getNonReferenceType()->isRecordType()) return false;
+            }
+            return true;
+        }
+        
+        // Side-effect-free and built from invariant parts; calls make it worth hoisting
+        bool invariant(Expr *E, bool &worthwhile) {
+            E = E->IgnoreParens();
+            if (isa<IntegerLiteral>(E) || isa<FloatingLiteral>(E) || isa<CharacterLiteral>(E) ||
+                isa<CXXBoolLiteralExpr>(E)) {
+                return true;
+            }
+            if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E)) {
+                if (isa<EnumConstantDecl>(DRE->getDecl())) return true;
+                const VarDecl *VD = dyn_cast<VarDecl>(DRE->getDecl());
+                return VD && invariantVar(VD);
+            }
+            if (MaterializeTemporaryExpr *MTE = dyn_cast<MaterializeTemporaryExpr>(E)) {
+                return invariant(MTE->getSubExpr(), worthwhile);
+            }
+            if (CastExpr *CE = dyn_cast<CastExpr>(E)) {
+                if (CE->getCastKind() == CK_UserDefinedConversion || CE->getCastKind() == CK_ConstructorConversion) {
+                    return false;
+                }
+                return invariant(CE->getSubExpr(), worthwhile);
+            }
+            if (UnaryOperator *UO = dyn_cast<UnaryOperator>(E)) {
+                UnaryOperatorKind op = UO->getOpcode();
+                return (op == UO_Plus || op == UO_Minus || op == UO_Not || op == UO_LNot) &&
+                       invariant(UO->getSubExpr(), worthwhile);
+            }
+            if (BinaryOperator *BO = dyn_cast<BinaryOperator>(E)) {
+                // Integer division may trap once moved out from under a guard
+                if (BO->isAssignmentOp() || BO->isCommaOp()) return false;
+                if ((BO->getOpcode() == BO_Div || BO->getOpcode() == BO_Rem) && BO->getType()->isIntegerType()) {
+                    return false;
+                }
+                return invariant(BO->getLHS(), worthwhile) && invariant(BO->getRHS(), worthwhile);
+            }
+            if (ConditionalOperator *CO = dyn_cast<ConditionalOperator>(E)) {
+                return invariant(CO->getCond(), worthwhile) && invariant(CO->getTrueExpr(), worthwhile) &&
+                       invariant(CO->getFalseExpr(), worthwhile);
+            }
+            if (CXXMemberCallExpr *MCE = dyn_cast<CXXMemberCallExpr>(E)) {
+                // Container length queries: size(), length(), empty()
+                const CXXMethodDecl *MD = MCE->getMethodDecl();
+                if (!MD || !MD->isConst() || MCE->getNumArgs() != 0 || !MD->getIdentifier() ||
+                    !SM->isInSystemHeader(MD->getLocation())) {
+                    return false;
+                }
+                std::string name = MD->getName().str();
+                const VarDecl *object = MCE->getImplicitObjectArgument() ? namedVar(MCE->getImplicitObjectArgument())
+                                                                        : nullptr;
+                if ((name != "size" && name != "length" && name != "empty") || !object || !invariantVar(object)) {
+                    return false;
+                }
+                worthwhile = true;
+                return true;
+            }
+            if (CallExpr *CE = dyn_cast<CallExpr>(E)) {
+                if (isa<CXXOperatorCallExpr>(CE) || !pureCall(CE->getDirectCallee())) return false;
+                for (Expr *arg : CE->arguments()) {
+                    if (!invariant(arg, worthwhile)) return false;
+                }
+                worthwhile = true;
+                return true;
+            }
+            return false;
+        }
+        
+        // Largest invariant expressions evaluated on every iteration; those under an
+        // if, ?: or short-circuit operator are left alone
+        void scan(Stmt *S, bool conditional) {
+            if (!S || isa<LambdaExpr>(S) || isa<UnaryExprOrTypeTraitExpr>(S)) return;
+            if (Expr *E = dyn_cast<Expr>(S)) {
+                bool worthwhile = false;
+                if (!conditional && !E->isGLValue() && !E->getType()->isVoidType() &&
+                    !E->getBeginLoc().isMacroID() && !E->getEndLoc().isMacroID() &&
+                    invariant(E, worthwhile) && worthwhile) {
+                    found.push_back(E);
+                    return;
+                }
+            }
+            if (IfStmt *IS = dyn_cast<IfStmt>(S)) {
+                scan(IS->getCond(), conditional);
+                scan(IS->getThen(), true);
+                scan(IS->getElse(), true);
+                return;
+            }
+            if (SwitchStmt *SS = dyn_cast<SwitchStmt>(S)) {
+                scan(SS->getCond(), conditional);
+                scan(SS->getBody(), true);
+                return;
+            }
+            if (ConditionalOperator *CO = dyn_cast<ConditionalOperator>(S)) {
+                scan(CO->getCond(), conditional);
+                scan(CO->getTrueExpr(), true);
+                scan(CO->getFalseExpr(), true);
+                return;
+            }
+            if (BinaryOperator *BO = dyn_cast<BinaryOperator>(S)) {
+                if (BO->isLogicalOp()) {
+                    scan(BO->getLHS(), conditional);
+                    scan(BO->getRHS(), true);
+                    return;
+                }
+            }
+            for (Stmt *child : S->children()) {
+                scan(child, conditional);
+            }
+        }
+    };
+    
+    InvariantFinder finder;
+    finder.SM = SM;
+    finder.analysis = functionAnalysis;
+    finder.body = body;
+    finder.loopBegin = body->getBeginLoc().getLocWithOffset(-(int)loop.body_offset);
+    finder.loopVar = loop.loop_variable;
+    collectVariableWrites(body, finder.writes);
+    finder.noteEscapes(currentFunctionBody);
+    finder.noteAliasWrites(body);
+    if (finder.hasLambda) return;
+    finder.scan(body, false);
+    
+    unsigned bodyStart = SM->getFileOffset(body->getBeginLoc());
+    std::map<std::string, size_t> byText;
+    for (Expr *E : finder.found) {
+        std::string text = getSourceText(E->getSourceRange());
+        unsigned start = SM->getFileOffset(E->getBeginLoc());
+        unsigned end = SM->getFileOffset(E->getEndLoc()) + Lexer::MeasureTokenLength(E->getEndLoc(), *SM, LangOptions());
+        if (text.empty() || start < bodyStart || end < start) continue;
+        
+        auto it = byText.find(text);
+        if (it == byText.end()) {
+            it = byText.insert({text, loop.invariants.size()}).first;
+            loop.invariants.push_back({text, {}});
+        }
+        loop.invariants[it->second].ranges.push_back({start - bodyStart, end - start});
+    }
+}
+
+// Every statement of the body stores an element at the loop index: a[i] = e or v[i].f = e
+static bool isArrayInitialization(Stmt *body, const LoopInfo &loop, SourceManager &SM) {
+    if (!body || loop.type != "for" || !loop.is_canonical || hasUserCall(body, SM)) return false;
+    std::vector<Stmt*> stmts;
+    if (CompoundStmt *CS = dyn_cast<CompoundStmt>(body)) stmts.assign(CS->body_begin(), CS->body_end());
+    else stmts.push_back(body);
+    if (stmts.empty()) return false;
+    for (Stmt *S : stmts) {
+        BinaryOperator *BO = dyn_cast<BinaryOperator>(S);
+        if (!BO || BO->getOpcode() != BO_Assign) return false;
+        Expr *target = BO->getLHS()->IgnoreParens();
+        if (MemberExpr *ME = dyn_cast<MemberExpr>(target)) {
+            if (ME->isArrow()) return false;
+            target = ME->getBase();
+        }
+        Expr *idx = nullptr;
+        bool isContainer = false;
+        if (!subscriptedArray(target, idx, isContainer)) return false;
+        DeclRefExpr *idxRef = dyn_cast<DeclRefExpr>(idx->IgnoreParenImpCasts());
+        if (!idxRef || idxRef->getDecl()->getNameAsString() != loop.loop_variable) return false;
+    }
+    return true;
+}
+
+// rand() calls in the body, in source order
+static void collectRandCalls(Stmt *S, std::vector<CallExpr*> &calls) {
+    if (!S) return;
+    if (CallExpr *CE = dyn_cast<CallExpr>(S)) {
+        const FunctionDecl *FD = CE->getDirectCallee();
+        if (FD && FD->getNameAsString() == "rand" && CE->getNumArgs() == 0) calls.push_back(CE);
+    }
+    for (Stmt *child : S->children()) {
+        collectRandCalls(child, calls);
+    }
+}
+
+// a[idx], v[idx] and a[j][idx]: the subscripted variable (or member) and the index
+static bool subscriptAccess(Expr *E, std::string &name, Expr *&idx) {
+    E = E->IgnoreParenImpCasts();
+    Expr *base = nullptr;
+    if (ArraySubscriptExpr *ASE = dyn_cast<ArraySubscriptExpr>(E)) {
+        base = ASE->getBase();
+        idx = ASE->getIdx();
+    } else if (CXXOperatorCallExpr *OCE = dyn_cast<CXXOperatorCallExpr>(E)) {
+        if (OCE->getOperator() != OO_Subscript || OCE->getNumArgs() != 2) return false;
+        base = OCE->getArg(0);
+        idx = OCE->getArg(1);
+    } else {
+        return false;
+    }
+    Expr *inner = nullptr;
+    std::string innerName;
+    if (subscriptAccess(base, innerName, inner)) {
+        name = innerName;
+        return true;
+    }
+    base = base->IgnoreParenImpCasts();
+    if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(base)) {
+        name = DRE->getDecl()->getNameAsString();
+    } else if (MemberExpr *ME = dyn_cast<MemberExpr>(base)) {
+        name = ME->getMemberDecl()->getNameAsString();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool isLoopIndex(Expr *idx, const std::string &loopVar) {
+    DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(idx->IgnoreParenImpCasts());
+    return DRE && DRE->getDecl()->getNameAsString() == loopVar;
+}
+
+// i + c, c + i or i - c for an integer constant c
+static bool isLoopOffset(Expr *idx, const std::string &loopVar) {
+    BinaryOperator *BO = dyn_cast<BinaryOperator>(idx->IgnoreParenImpCasts());
+    if (!BO || (BO->getOpcode() != BO_Add && BO->getOpcode() != BO_Sub)) return false;
+    Expr *lhs = BO->getLHS()->IgnoreParenImpCasts();
+    Expr *rhs = BO->getRHS()->IgnoreParenImpCasts();
+    if (isLoopIndex(lhs, loopVar) && isa<IntegerLiteral>(rhs)) return true;
+    return BO->getOpcode() == BO_Add && isa<IntegerLiteral>(lhs) && isLoopIndex(rhs, loopVar);
+}
+
+// Stores through any subscript of the target that is exactly the loop variable: a[i], a[i][j], a[j][i], v[i].f
+static void noteElementStore(Expr *target, const std::string &loopVar, bool plainAssign, LoopIndexAccesses &accesses) {
+    Expr *E = target->IgnoreParenImpCasts();
+    while (MemberExpr *ME = dyn_cast<MemberExpr>(E)) {
+        if (ME->isArrow()) return;
+        E = ME->getBase()->IgnoreParenImpCasts();
+    }
+    std::string name;
+    Expr *idx = nullptr;
+    while (subscriptAccess(E, name, idx)) {
+        if (isLoopIndex(idx, loopVar)) {
+            accesses.elementStores.insert(name);
+            if (plainAssign) accesses.assignsElement = true;
+            return;
+        }
+        if (ArraySubscriptExpr *ASE = dyn_cast<ArraySubscriptExpr>(E)) {
+            E = ASE->getBase()->IgnoreParenImpCasts();
+        } else {
+            E = cast<CXXOperatorCallExpr>(E)->getArg(0)->IgnoreParenImpCasts();
+        }
     }
+}
+
+void ComprehensiveLoopAnalyzer::analyzeLoopBody(Stmt *body, LoopInfo &loop) {
+    if (!body) return;
+    
+    // Initialize flags to false (preserve has_complex_condition if already set)
+    loop.has_function_calls = false;
+    loop.has_io_operations = false;
+    loop.has_break_continue = false;
+    // Don't reset has_complex_condition - it may have been set during condition analysis
+    loop.is_nested = false;
     
-    // Additional check for sum reduction pattern if not already detected
-    if (loop.reduction_vars.empty() && !loop.loop_variable.empty()) {
-        // Look for pattern: sum += ...
-        std::regex sum_pattern(R"((\w+)\s*\+=)");
-        std::smatch match;
-        if (std::regex_search(code, match, sum_pattern)) {
-            std::string var = match[1];
-            // Make sure this variable is not an array element and not a local variable
-            if (!std::regex_search(code, std::regex(var + R"(\s*\[)")) && 
-                localVars.find(var) == localVars.end()) {
-                loop.reduction_vars.push_back(var);
-                loop.reduction_op = "+";
+    class LoopBodyVisitor : public RecursiveASTVisitor<LoopBodyVisitor> {
+    public:
+        LoopInfo *loop;
+        std::string loopVar;
+        std::set<std::string> *globals;
+        std::set<std::string> localVars;  // Track variables declared inside loop
+        LoopIndexAccesses accesses;       // Element accesses around the loop index
+        
+        LoopBodyVisitor(LoopInfo *l, const std::string &var, std::set<std::string> *g) 
+            : loop(l), loopVar(var), globals(g) {}
+        
+        void noteSubscript(Expr *E) {
+            std::string name;
+            Expr *idx = nullptr;
+            if (!loopVar.empty() && subscriptAccess(E, name, idx) && isLoopOffset(idx, loopVar)) {
+                accesses.offsetReads.insert(name);
             }
         }
+        
+        bool VisitArraySubscriptExpr(ArraySubscriptExpr *ASE) {
+            noteSubscript(ASE);
+            return true;
+        }
+        
+        bool VisitUnaryOperator(UnaryOperator *UO) {
+            if (UO->isIncrementDecrementOp() && !loopVar.empty()) {
+                noteElementStore(UO->getSubExpr(), loopVar, false, accesses);
+            }
+            return true;
+        }
+        
+        bool VisitDeclRefExpr(DeclRefExpr *DRE) {
+            if (VarDecl *VD = dyn_cast<VarDecl>(DRE->getDecl())) {
+                std::string varName = VD->getNameAsString();
+                // Don't add cout/cin as regular variables
+                if (varName != "cout" && varName != "cin" && varName != "endl") {
+                    loop->read_vars.insert(varName);
+                }
+            }
+            return true;
+        }
+        
+        bool VisitBinaryOperator(BinaryOperator *BO) {
+            if (BO->isAssignmentOp() && !loopVar.empty()) {
+                noteElementStore(BO->getLHS(), loopVar, BO->getOpcode() == BO_Assign, accesses);
+            }
+            if (BO->isAssignmentOp()) {
+                if (DeclRefExpr *LHS = dyn_cast<DeclRefExpr>(BO->getLHS()->IgnoreImpCasts())) {
+                    if (VarDecl *VD = dyn_cast<VarDecl>(LHS->getDecl())) {
+                        std::string varName = VD->getNameAsString();
+                        loop->write_vars.insert(varName);
+                    }
+                }
+            }
+            return true;
+        }
+        
+        bool VisitDeclStmt(DeclStmt *DS) {
+            // Track local variable declarations within the loop
+            for (auto *D : DS->decls()) {
+                if (VarDecl *VD = dyn_cast<VarDecl>(D)) {
+                    localVars.insert(VD->getNameAsString());
+                }
+            }
+            return true;
+        }
+        
+        bool VisitCompoundAssignOperator(CompoundAssignOperator *CAO) {
+            if (DeclRefExpr *LHS = dyn_cast<DeclRefExpr>(CAO->getLHS()->IgnoreImpCasts())) {
+                if (VarDecl *VD = dyn_cast<VarDecl>(LHS->getDecl())) {
+                    std::string varName = VD->getNameAsString();
+                    // The induction update of a converted while loop is not a reduction
+                    if (varName == loopVar) return true;
+                    
+                    // Only add to reduction if it's NOT a local variable declared inside the loop
+                    if (localVars.find(varName) == localVars.end()) {
+                        loop->reduction_vars.push_back(varName);
+                        loop->reduction_var_types[varName] = VD->getType().getNonReferenceType().getCanonicalType()
+                                                                 .getUnqualifiedType().getAsString();
+                    }
+                    
+                    // Determine reduction operation
+                    switch (CAO->getOpcode()) {
+                        case BO_AddAssign: loop->reduction_op = "+"; break;
+                        case BO_SubAssign: 
+                loop->reduction_op = "-"; 
+                // Subtraction is NOT associative - cannot be parallelized
+                loop->parallelizable = false;
+                loop->analysis_notes += " Subtraction reduction is not parallelizable (non-associative). ";
+                break;
+                        case BO_MulAssign: loop->reduction_op = "*"; break;
+                        case BO_AndAssign: loop->reduction_op = "&"; break;
+                        case BO_OrAssign: loop->reduction_op = "|"; break;
+                        case BO_XorAssign: loop->reduction_op = "^"; break;
+                        default: loop->reduction_op = "+"; break;
+                    }
+                }
+            }
+            return true;
+        }
+        
+        bool VisitCallExpr(CallExpr *CE) {
+            if (FunctionDecl *FD = CE->getDirectCallee()) {
+                std::string funcName = FD->getNameAsString();
+                
+                // Check for thread-unsafe functions
+                if (funcName == "rand" || funcName == "srand" ||
+                    funcName == "strtok" || funcName == "asctime" ||
+                    funcName == "ctime" || funcName == "gmtime" ||
+                    funcName == "localtime" || funcName == "strerror") {
+                    loop->has_thread_unsafe_calls = true;
+                    loop->unsafe_functions.push_back(funcName);
+                }
+                // Check for I/O operations - be more specific
+                else if (funcName == "printf" || funcName == "scanf" ||
+                    funcName == "puts" || funcName == "gets" ||
+                    funcName == "fprintf" || funcName == "fscanf" ||
+                    funcName == "fread" || funcName == "fwrite") {
+                    loop->has_io_operations = true;
+                } else if (funcName == "sin" || funcName == "cos" || 
+                           funcName == "exp" || funcName == "sqrt" ||
+                           funcName == "pow" || funcName == "log") {
+                    // Math functions are safe for parallelization
+                    loop->has_function_calls = true;
+                } else {
+                    // Other function calls
+                    loop->has_function_calls = true;
+                }
+            }
+            return true;
+        }
+        
+        // Check for C++ stream I/O
+        bool VisitCXXOperatorCallExpr(CXXOperatorCallExpr *CE) {
+            if (CE->getOperator() == OO_Subscript) {
+                noteSubscript(CE);
+                return true;
+            }
+            if (CE->isAssignmentOp() && CE->getNumArgs() == 2 && !loopVar.empty()) {
+                noteElementStore(CE->getArg(0), loopVar, CE->getOperator() == OO_Equal, accesses);
+            }
+            if ((CE->getOperator() == OO_PlusPlus || CE->getOperator() == OO_MinusMinus) && !loopVar.empty()) {
+                noteElementStore(CE->getArg(0), loopVar, false, accesses);
+            }
+            if (FunctionDecl *FD = CE->getDirectCallee()) {
+                std::string opName = FD->getNameAsString();
+                // Check for << or >> operators
+                if (opName.find("operator<<") != std::string::npos ||
+                    opName.find("operator>>") != std::string::npos) {
+                    loop->has_io_operations = true;
+                    return true;
+                }
+            }
+            return true;
+        }
+        
+        bool VisitForStmt(ForStmt *FS) {
+            loop->is_nested = true;
+            return true;
+        }
+        
+        bool VisitWhileStmt(WhileStmt *WS) {
+            loop->is_nested = true;
+            return true;
+        }
+        
+        bool VisitDoStmt(DoStmt *DS) {
+            loop->is_nested = true;
+            return true;
+        }
+        
+    };
+    
+    LoopBodyVisitor visitor(&loop, loop.loop_variable, &globalVariables);
+    visitor.TraverseStmt(body);
+    
+    // Only exits that leave this loop matter: a continue just ends the iteration,
+    // and a break inside a nested loop or switch stays there
+    LoopExits exits;
+    scanLoopExits(body, false, false, exits);
+    loop.has_break_continue = !exits.breaks.empty();
+    loop.has_early_return = !exits.returns.empty() || exits.hasGoto;
+    
+    // Canonical loops that exit early run as speculative searches
+    if (loop.is_canonical && !loop.exit_ranges.empty()) {
+        loop.is_search_loop = isSpeculativeSearch(body, loop, loop.exit_vars);
+    }
+    
+    // Histogram-style updates must run before privatization claims their arrays
+    analyzeIndirectUpdates(body, loop);
+    analyzePrivatization(body, loop);
+    
+    // Running sums read inside the loop are scans, not plain reductions
+    analyzeScan(body, loop);
+    
+    // Struct fields read at the loop index, candidates for a structure-of-arrays copy
+    analyzeStructAccesses(body, loop);
+    loop.is_array_init = isArrayInitialization(body, loop, *SM);
+    
+    // sqrt(n), v.size() and the like, computed once by the MPI split
+    analyzeInvariants(body, loop);
+    
+    // rand() is rewritten to a counter-based draw, so each call must be spelled in the body
+    loop.rand_ranges.clear();
+    std::vector<CallExpr*> randCalls;
+    collectRandCalls(body, randCalls);
+    unsigned bodyStart = SM->getFileOffset(body->getBeginLoc());
+    for (CallExpr *CE : randCalls) {
+        if (CE->getBeginLoc().isMacroID() || CE->getRParenLoc().isMacroID()) continue;
+        unsigned start = SM->getFileOffset(CE->getBeginLoc());
+        unsigned end = SM->getFileOffset(CE->getRParenLoc()) + 1;
+        if (start >= bodyStart && end > start) loop.rand_ranges.push_back({start - bodyStart, end - start});
+    }
+    
+    // Pass the element accesses to dependency analysis
+    performDependencyAnalysis(loop, visitor.accesses);
+}
+
+void ComprehensiveLoopAnalyzer::performDependencyAnalysis(LoopInfo &loop, const LoopIndexAccesses &accesses) {
+    // Remove duplicates
+    std::sort(loop.reduction_vars.begin(), loop.reduction_vars.end());
+    loop.reduction_vars.erase(std::unique(loop.reduction_vars.begin(), loop.reduction_vars.end()), loop.reduction_vars.end());
+    
+    // Loop-carried dependencies: an array read at i +/- c that is also stored at i
+    loop.has_dependencies = false;
+    for (const auto& array : accesses.offsetReads) {
+        if (accesses.elementStores.count(array)) {
+            loop.has_dependencies = true;
+            break;
+        }
     }
     
-    // Determine if parallelizable
-    if (loop.type == "for") {
+    // Determine if parallelizable (while/do-while loops once converted to canonical form)
+    if (loop.type == "for" || loop.is_canonical) {
         loop.parallelizable = true;
         loop.analysis_notes = "";
         
@@ -499,9 +2223,9 @@ void ComprehensiveLoopAnalyzer::performDependencyAnalysis(LoopInfo &loop, const
             loop.analysis_notes += "Contains I/O operations - not parallelizable. ";
         }
         
-        if (loop.has_break_continue) {
-            loop.parallelizable = false;
-            loop.analysis_notes += "Contains break/continue statements - not parallelizable. ";
+        if (loop.type != "for") {
+            loop.analysis_notes += "Affine induction variable '" + loop.loop_variable +
+                                   "' - converted to canonical for-form. ";
         }
         
         if (!loop.reduction_vars.empty()) {
@@ -515,23 +2239,58 @@ void ComprehensiveLoopAnalyzer::performDependencyAnalysis(LoopInfo &loop, const
             }
         }
         
-        if (loop.has_dependencies && loop.reduction_vars.empty()) {
+        if (loop.is_scan_loop) {
+            loop.analysis_notes += "Prefix sum over '" + (loop.scan.array.empty() ? loop.scan.var : loop.scan.array) +
+                                   "' - parallelizable with inscan reduction and omp scan. ";
+        }
+        
+        // Checked after reductions so a reduction cannot re-enable an early-exit loop
+        if (loop.is_search_loop) {
+            loop.analysis_notes += "Early-exit search loop - speculative chunked execution with omp cancel. ";
+        } else if (loop.has_break_continue || loop.has_early_return) {
+            loop.parallelizable = false;
+            loop.analysis_notes += "Contains break/return leaving the loop - not parallelizable. ";
+        }
+        
+        if (loop.has_dependencies && loop.reduction_vars.empty() && !loop.is_scan_loop) {
             loop.parallelizable = false;
             loop.analysis_notes += "Has loop-carried dependencies - not parallelizable. ";
         }
         
+        for (const auto& array : loop.conflicting_arrays) {
+            loop.parallelizable = false;
+            loop.analysis_notes += "Array '" + array + "' is updated through a computed subscript and also accessed otherwise - not parallelizable. ";
+        }
+        
+        if (!loop.array_reductions.empty() && loop.conflicting_arrays.empty()) {
+            bool usesAtomic = !loop.atomic_offsets.empty();
+            loop.analysis_notes += usesAtomic ? "Indirect array updates guarded with omp atomic. "
+                                              : "Indirect array updates - parallelizable with array-section reduction. ";
+        }
+        
+        for (const auto& var : loop.carried_scalars) {
+            loop.parallelizable = false;
+            loop.analysis_notes += "Scalar '" + var + "' is read before it is written - carried across iterations. ";
+        }
+        
+        if (!loop.private_vars.empty() || !loop.firstprivate_vars.empty() || !loop.lastprivate_vars.empty()) {
+            loop.analysis_notes += "Temporaries written before use are privatized. ";
+        }
+        
+        for (const auto& candidate : loop.soa_candidates) {
+            loop.analysis_notes += "Array of structs '" + candidate.container + "' uses " +
+                                   std::to_string(candidate.fields.size()) + " of " +
+                                   std::to_string(candidate.total_fields) +
+                                   " fields - --soa gathers them into contiguous arrays around the enclosing loop. ";
+        }
+        
         // PHASE 3: Enhanced parallelization logic with STL container pattern recognition
         bool hasSTLContainerPattern = false;
         
-        // Check for safe STL container element access patterns
-        std::string code = loop.source_code;
-        if (!loop.loop_variable.empty()) {
-            // Pattern: container[i] = f(container[i]) or similar independent element operations
-            std::string loopVar = loop.loop_variable;
-            std::regex elementAccessPattern(R"(\w+\s*\[\s*)" + loopVar + R"(\s*\]\s*=)");
-            if (std::regex_search(code, elementAccessPattern)) {
-                hasSTLContainerPattern = true;
-            }
+        // Check for safe STL container element access patterns:
+        // container[i] = f(container[i]) or similar independent element operations
+        if (accesses.assignsElement) {
+            hasSTLContainerPattern = true;
         }
         
         // PHASE 3: More intelligent parallelization decision
@@ -548,6 +2307,15 @@ void ComprehensiveLoopAnalyzer::performDependencyAnalysis(LoopInfo &loop, const
             loop.analysis_notes += "STL container element access pattern detected - parallelizable despite complex condition. ";
         }
         
+        // Random draws are indexed by the iteration of a canonical for loop; elsewhere
+        // rand() keeps its sequential order
+        size_t randCalls = std::count(loop.unsafe_functions.begin(), loop.unsafe_functions.end(), "rand");
+        if (randCalls > 0 && (loop.type != "for" || !loop.is_canonical || loop.is_scan_loop ||
+                              loop.rand_ranges.size() != randCalls)) {
+            loop.parallelizable = false;
+            loop.analysis_notes += "rand() outside a canonical for loop keeps its sequential order - not parallelizable. ";
+        }
+        
         if (loop.is_nested && loop.parallelizable) {
             loop.analysis_notes += "Nested loop structure detected. ";
         }
@@ -575,13 +2343,14 @@ void ComprehensiveLoopAnalyzer::performDependencyAnalysis(LoopInfo &loop, const
         }
     } else {
         loop.parallelizable = false;
-        loop.analysis_notes = "Only for-loops are automatically parallelizable. ";
+        loop.analysis_notes = "Only for-loops and while/do-while loops with a single affine induction variable are automatically parallelizable. ";
     }
 }
 
 std::string ComprehensiveLoopAnalyzer::generateOpenMPPragma(const LoopInfo& loop) {
     std::stringstream pragma;
-    pragma << "#pragma omp parallel for";
+    // Speculative search probes are a worksharing loop inside their own parallel region
+    pragma << (loop.is_search_loop ? "#pragma omp for" : "#pragma omp parallel for");
     
     if (!loop.reduction_vars.empty()) {
         // Group reduction variables by operation type
@@ -605,26 +2374,63 @@ std::string ComprehensiveLoopAnalyzer::generateOpenMPPragma(const LoopInfo& loop
         }
     }
     
-    // Add firstprivate clause for thread-local variables (like thread seeds)
-    if (!loop.thread_local_vars.empty()) {
-        pragma << " firstprivate(";
-        bool first = true;
-        for (const auto& var : loop.thread_local_vars) {
-            if (!first) pragma << ",";
-            pragma << var;
-            first = false;
-        }
-        pragma << ")";
+    // The scan directive in the body splits each iteration at the accumulator
+    if (loop.is_scan_loop) {
+        pragma << " reduction(inscan, " << loop.scan.op << ":" << loop.scan.var << ")";
+    }
+    
+    // Small histograms get a private copy per thread; atomics cover the rest
+    for (const auto& array : loop.array_reductions) {
+        if (array.use_atomic) continue;
+        pragma << " reduction(" << array.op << ":" << array.name << "[0:" << array.length_expr << "])";
     }
     
     // Note: Loop variables declared in for-loop are automatically private
-    // Only add private clause for variables declared outside the loop
+    // Only add private clauses for variables declared outside the loop
+    std::vector<std::string> privateVars = loop.private_vars;
+    std::vector<std::string> firstprivateVars(loop.thread_local_vars.begin(), loop.thread_local_vars.end());
+    firstprivateVars.insert(firstprivateVars.end(), loop.firstprivate_vars.begin(), loop.firstprivate_vars.end());
+    std::vector<std::string> lastprivateVars = loop.lastprivate_vars;
+    
+    // lastprivate alone leaves the variable undefined when a team runs no iterations;
+    // starting from the original value keeps it unchanged as in sequential code
+    for (const auto& var : loop.lastprivate_vars) {
+        if (std::find(firstprivateVars.begin(), firstprivateVars.end(), var) == firstprivateVars.end()) {
+            firstprivateVars.push_back(var);
+        }
+    }
+    
+    // Search results are recomputed serially after the probe
+    if (loop.is_search_loop) {
+        privateVars.insert(privateVars.end(), loop.exit_vars.begin(), loop.exit_vars.end());
+    }
     
-    pragma << " schedule(" << loop.schedule_type;
-    if (loop.schedule_type == "dynamic") {
-        pragma << ",100";  // Smaller chunk size for better load balancing
+    // The induction variable of a converted while loop keeps its final value
+    if (loop.type != "for" && loop.is_canonical && !loop.is_search_loop) {
+        lastprivateVars.insert(lastprivateVars.begin(), loop.loop_variable);
+    }
+    
+    auto addClause = [&pragma](const std::string& clause, const std::vector<std::string>& vars) {
+        if (vars.empty()) return;
+        pragma << " " << clause << "(";
+        for (size_t i = 0; i < vars.size(); i++) {
+            if (i > 0) pragma << ",";
+            pragma << vars[i];
+        }
+        pragma << ")";
+    };
+    addClause("private", privateVars);
+    addClause("firstprivate", firstprivateVars);
+    addClause("lastprivate", lastprivateVars);
+    
+    // inscan reductions do not allow a schedule clause
+    if (!loop.is_scan_loop) {
+        pragma << " schedule(" << loop.schedule_type;
+        if (loop.schedule_type == "dynamic") {
+            pragma << ",100";  // Smaller chunk size for better load balancing
+        }
+        pragma << ")";
     }
-    pragma << ")";
     
     return pragma.str();
 }
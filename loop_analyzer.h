@@ -10,32 +10,56 @@
 #include <string>
 #include <vector>
 
+// Element accesses around the loop index, collected by LoopBodyVisitor for the dependence test
+struct LoopIndexAccesses {
+    std::set<std::string> offsetReads;    // a[i + c], a[i - c]
+    std::set<std::string> elementStores;  // a[i] = e, a[i] op= e, a[i]++ (any subscript of the target)
+    bool assignsElement = false;          // Some a[i] = e - independent element updates
+};
+
 // Enhanced loop analyzer that works across all functions
 class ComprehensiveLoopAnalyzer : public clang::RecursiveASTVisitor<ComprehensiveLoopAnalyzer> {
 private:
     clang::SourceManager *SM;
     std::map<std::string, std::vector<LoopInfo>> functionLoops;
     std::string currentFunction;
+    clang::Stmt *currentFunctionBody = nullptr;
     bool insideLoop = false;
     int loopDepth = 0;
     std::set<std::string> globalVariables;
+    std::map<const clang::Stmt*, clang::CompoundStmt*> enclosingCompound; // Statement -> enclosing block
+    const std::map<std::string, FunctionAnalysis> *functionAnalysis = nullptr; // Purity of user functions
     
 public:
     ComprehensiveLoopAnalyzer(clang::SourceManager *sourceManager, const std::set<std::string>& globals);
+    void setFunctionAnalysis(const std::map<std::string, FunctionAnalysis> *analysis);
     
     bool VisitFunctionDecl(clang::FunctionDecl *FD);
     bool VisitForStmt(clang::ForStmt *FS);
     bool VisitWhileStmt(clang::WhileStmt *WS);
     bool VisitDoStmt(clang::DoStmt *DS);
+    bool VisitCompoundStmt(clang::CompoundStmt *CS);
     
     const std::map<std::string, std::vector<LoopInfo>>& getAllFunctionLoops() const;
+    std::map<std::string, std::vector<LoopInfo>> takeAllFunctionLoops();  // Moves the loops out, leaves none behind
     
 private:
     void processForLoop(clang::ForStmt *FS);
     void processWhileLoop(clang::WhileStmt *WS);
     void processDoWhileLoop(clang::DoStmt *DS);
+    void finalizeLoop(LoopInfo &loop, int depth);
+    bool inferIterationSpace(clang::Stmt *loopStmt, clang::Expr *cond, clang::Stmt *body, LoopInfo &loop, bool isDoWhile);
+    bool recordExitRanges(clang::CompoundStmt *body, LoopInfo &loop);
+    bool matchAffineUpdate(clang::Stmt *S, const clang::VarDecl *&var, std::string &step);
+    bool isSpeculativeSearch(clang::Stmt *body, const LoopInfo &loop, std::vector<std::string> &exitVars);
     void analyzeLoopBody(clang::Stmt *body, LoopInfo &loop);
-    void performDependencyAnalysis(LoopInfo &loop, const std::set<std::string> &localVars = std::set<std::string>());
+    void analyzePrivatization(clang::Stmt *body, LoopInfo &loop);
+    void analyzeIndirectUpdates(clang::Stmt *body, LoopInfo &loop);
+    void analyzeScan(clang::Stmt *body, LoopInfo &loop);
+    void analyzeStructAccesses(clang::Stmt *body, LoopInfo &loop);
+    void analyzeInvariants(clang::Stmt *body, LoopInfo &loop);
+    size_t offsetInFunction(clang::SourceLocation loc) const;
+    void performDependencyAnalysis(LoopInfo &loop, const LoopIndexAccesses &accesses);
     std::string generateOpenMPPragma(const LoopInfo& loop);
     std::string getSourceText(clang::SourceRange range);
 };
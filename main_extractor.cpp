@@ -11,6 +11,12 @@ static std::string normalizeTypeName(const std::string& type) {
     return type;
 }
 
+// Spelling of the type with typedefs and references resolved: size_t, int64_t or a
+// user's real_t become the builtin they stand for on this target
+static std::string canonicalTypeName(QualType type) {
+    return normalizeTypeName(type.getNonReferenceType().getCanonicalType().getUnqualifiedType().getAsString());
+}
+
 MainFunctionExtractor::MainFunctionExtractor(SourceManager *sourceManager) 
     : SM(sourceManager), functionAnalysisPtr(nullptr), variableDeclarationCounter(0),
       mainBodyStartLine(0), mainBodyStartColumn(0) {}
@@ -64,6 +70,7 @@ void MainFunctionExtractor::collectLocalVariablesInStmt(Stmt *stmt) {
                 LocalVariable localVar;
                 localVar.name = VD->getNameAsString();
                 localVar.type = normalizeTypeName(VD->getType().getAsString());
+                localVar.canonicalType = canonicalTypeName(VD->getType());
                 localVar.declarationOrder = variableDeclarationCounter++;
                 localVar.definedAtCall = -1;
                 localVar.isParameter = false;
@@ -178,6 +185,7 @@ void MainFunctionExtractor::processStatement(Stmt *stmt) {
                                 } else {
                                     call.returnType = VD->getType().getAsString();
                                 }
+                                call.canonicalReturnType = canonicalTypeName(CE->getType());
                                 
                                 for (unsigned i = 0; i < CE->getNumArgs(); ++i) {
                                     std::set<std::string> argVars;
@@ -231,6 +239,7 @@ void MainFunctionExtractor::processStatement(Stmt *stmt) {
                     } else {
                         call.returnType = CE->getType().getAsString();
                     }
+                    call.canonicalReturnType = canonicalTypeName(CE->getType());
                 } else {
                     call.returnType = "void";
                 }
@@ -41,13 +41,23 @@ namespace {
 #include "clang/Rewrite/Core/Rewriter.h"
 #include "clang/Lex/Lexer.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/TimeProfiler.h"
 
 // Include our modular headers
 #include "data_structures.h"
 #include "ast_consumer.h"
+#include "program_index.h"
+#include "region_planner.h"
 
 // External declaration for global flag
 extern bool enableLoopParallelization;
+extern bool enableSoATransform;
+extern std::string numaProcBind;
+extern bool emitTimers;
+extern bool timePhases;
+extern bool wholeProgram;
+extern bool planRegions;
+extern MachineModel machineModel;
 
 using namespace clang;
 using namespace clang::tooling;
@@ -56,11 +66,51 @@ using namespace llvm;
 // Global flag for loop parallelization
 bool enableLoopParallelization = true;
 
+// Opt-in structure-of-arrays copies for loops over arrays of structs
+bool enableSoATransform = false;
+
+// NUMA mode: proc_bind policy for parallel loops ("spread" or "close"), empty when off
+std::string numaProcBind;
+
+// Generated program times its parallel regions and reports them per rank
+bool emitTimers = false;
+
+// Machine-readable analysis report (--report=json), empty when off
+std::string reportFormat;
+
+// Self-profiling: per-phase table on stderr, Chrome trace file (empty when off)
+bool timePhases = false;
+std::string timeTraceFile;
+
+// All sources are summarized first; only the one with main() is parallelized
+bool wholeProgram = false;
+
+// Each loop runs as MPI+OpenMP, OpenMP, SIMD or serially, whichever the machine model favours
+bool planRegions = false;
+MachineModel machineModel;
+
 int main(int argc, const char **argv) {
     if (argc < 2) {
         llvm::errs() << "Usage: " << argv[0] << " [options] <source-file>\n";
         llvm::errs() << "\nOptions:\n";
         llvm::errs() << "  --no-loops    Disable loop parallelization (MPI-only mode)\n";
+        llvm::errs() << "  --soa         Gather struct fields into contiguous arrays around time-step loops\n";
+        llvm::errs() << "  --numa[=spread|close]\n";
+        llvm::errs() << "                NUMA first-touch: parallel initialization loops, static schedules\n";
+        llvm::errs() << "                and proc_bind (default spread)\n";
+        llvm::errs() << "  --emit-timers Time parallel groups, MPI-split loops and collectives in the\n";
+        llvm::errs() << "                generated program and print a load-imbalance report\n";
+        llvm::errs() << "  --report=json Write loops, dependences and parallel groups to <source>_report.json\n";
+        llvm::errs() << "  --time-phases Print wall time, peak RSS and node counts of each analysis phase\n";
+        llvm::errs() << "  --time-trace[=file]\n";
+        llvm::errs() << "                Write a Chrome trace of parsing and analysis (default mpi-parallelizer-trace.json)\n";
+        llvm::errs() << "  --whole-program <sources...>\n";
+        llvm::errs() << "                Summarize every source, then parallelize the one with main() using\n";
+        llvm::errs() << "                the functions defined in the others\n";
+        llvm::errs() << "  --plan[=latency=2,net=10,cores=16,mem=20,op=0.5,fork=3]\n";
+        llvm::errs() << "                Choose MPI, OpenMP, SIMD or serial per loop from a machine model\n";
+        llvm::errs() << "                (message latency us, network and memory GB/s, cores per rank,\n";
+        llvm::errs() << "                ns per operation, OpenMP fork/join us)\n";
         llvm::errs() << "\nThis enhanced tool generates comprehensive hybrid MPI/OpenMP parallelized code:\n";
         llvm::errs() << "  - MPI for parallelizing independent function calls across processes\n";
         llvm::errs() << "  - OpenMP for parallelizing ALL loops in ALL functions (unless --no-loops)\n";
@@ -76,6 +126,35 @@ int main(int argc, const char **argv) {
         if (arg == "--no-loops") {
             enableLoopParallelization = false;
             llvm::errs() << "Loop parallelization disabled - MPI-only mode enabled\n";
+        } else if (arg == "--soa") {
+            enableSoATransform = true;
+        } else if (arg == "--numa" || arg.rfind("--numa=", 0) == 0) {
+            numaProcBind = arg == "--numa" ? "spread" : arg.substr(7);
+            if (numaProcBind != "spread" && numaProcBind != "close") {
+                llvm::errs() << "Error: --numa expects spread or close, got '" << numaProcBind << "'\n";
+                return 1;
+            }
+        } else if (arg == "--emit-timers") {
+            emitTimers = true;
+        } else if (arg.rfind("--report=", 0) == 0) {
+            reportFormat = arg.substr(9);
+            if (reportFormat != "json") {
+                llvm::errs() << "Error: --report expects json, got '" << reportFormat << "'\n";
+                return 1;
+            }
+        } else if (arg == "--time-phases") {
+            timePhases = true;
+        } else if (arg == "--time-trace" || arg.rfind("--time-trace=", 0) == 0) {
+            timeTraceFile = arg == "--time-trace" ? "mpi-parallelizer-trace.json" : arg.substr(13);
+        } else if (arg == "--whole-program") {
+            wholeProgram = true;
+        } else if (arg == "--plan" || arg.rfind("--plan=", 0) == 0) {
+            planRegions = true;
+            std::string error;
+            if (arg != "--plan" && !MachineModel::parse(arg.substr(7), machineModel, error)) {
+                llvm::errs() << "Error: --plan: " << error << "\n";
+                return 1;
+            }
         } else {
             sources.push_back(arg);
         }
@@ -102,5 +181,42 @@ int main(int argc, const char **argv) {
     
     ClangTool Tool(*Compilations, sources);
     
-    return Tool.run(newFrontendActionFactory<HybridParallelizerAction>().get());
+    // Same granularity as clang -ftime-trace; Clang's own parser and Sema events are included
+    if (!timeTraceFile.empty()) {
+        timeTraceProfilerInitialize(500, "mpi-parallelizer");
+    }
+    
+    int result;
+    if (wholeProgram) {
+        // First pass: function summaries of every translation unit
+        result = Tool.run(newFrontendActionFactory<ProgramSummaryAction>().get());
+        const ProgramIndex& index = programIndex();
+        for (const std::string& name : index.duplicates()) {
+            llvm::errs() << "Warning: " << name << " is defined in several translation units, using the first\n";
+        }
+        if (result == 0 && index.mainFiles().size() != 1) {
+            llvm::errs() << "Error: --whole-program needs exactly one source defining main(), found "
+                         << index.mainFiles().size() << "\n";
+            result = 1;
+        }
+        
+        // Second pass: the unit with main, with the other units' functions from the index
+        if (result == 0) {
+            ClangTool MainTool(*Compilations, index.mainFiles());
+            result = MainTool.run(newFrontendActionFactory<HybridParallelizerAction>().get());
+        }
+    } else {
+        result = Tool.run(newFrontendActionFactory<HybridParallelizerAction>().get());
+    }
+    
+    if (!timeTraceFile.empty()) {
+        if (auto error = timeTraceProfilerWrite(timeTraceFile, "")) {
+            llvm::errs() << "Error: Could not write time trace: " << toString(std::move(error)) << "\n";
+        } else {
+            llvm::errs() << "Time trace written: " << timeTraceFile << "\n";
+        }
+        timeTraceProfilerCleanup();
+    }
+    
+    return result;
 }
\ No newline at end of file
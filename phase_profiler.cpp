@@ -0,0 +1,68 @@
+#include "phase_profiler.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdio>
+#include <sys/resource.h>
+
+PhaseProfiler::PhaseProfiler(bool enabled) : enabled(enabled) {}
+
+bool PhaseProfiler::active() const {
+    return enabled || llvm::timeTraceProfilerEnabled();
+}
+
+void PhaseProfiler::begin(const std::string& name) {
+    if (!active()) return;
+    current = name;
+    started = std::chrono::steady_clock::now();
+    if (llvm::timeTraceProfilerEnabled()) {
+        llvm::timeTraceProfilerBegin(name, "");
+    }
+}
+
+void PhaseProfiler::end(const Counts& counts) {
+    if (!active() || current.empty()) return;
+    if (llvm::timeTraceProfilerEnabled()) {
+        llvm::timeTraceProfilerEnd();
+    }
+    if (enabled) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+        phases.push_back({current, elapsed.count(), peakRssKb(), counts});
+    }
+    current.clear();
+}
+
+// ru_maxrss is in kilobytes on Linux and in bytes on macOS
+long PhaseProfiler::peakRssKb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+void PhaseProfiler::report() const {
+    if (!enabled || phases.empty()) return;
+
+    double total = 0.0;
+    for (const auto& phase : phases) {
+        total += phase.seconds;
+    }
+    char line[256];
+    llvm::errs() << "\n=== Analyzer Phases ===\n";
+    snprintf(line, sizeof(line), "%-34s %10s %7s %13s  %s\n", "phase", "wall [s]", "share", "peak RSS [MB]", "nodes");
+    llvm::errs() << line;
+    for (const auto& phase : phases) {
+        std::string counts;
+        for (const auto& count : phase.counts) {
+            if (!counts.empty()) counts += ", ";
+            counts += count.first + "=" + std::to_string(count.second);
+        }
+        snprintf(line, sizeof(line), "%-34s %10.4f %6.1f%% %13.1f  ", phase.name.c_str(), phase.seconds,
+                 total > 0.0 ? 100.0 * phase.seconds / total : 0.0, phase.peakRssKb / 1024.0);
+        llvm::errs() << line << counts << "\n";
+    }
+    snprintf(line, sizeof(line), "%-34s %10.4f %6.1f%% %13.1f\n", "total", total, 100.0, peakRssKb() / 1024.0);
+    llvm::errs() << line;
+}
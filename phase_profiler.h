@@ -0,0 +1,42 @@
+#ifndef PHASE_PROFILER_H
+#define PHASE_PROFILER_H
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Wall time, peak resident set size and node counts of the analyzer's own
+ * phases (--time-phases). Each phase is also a Chrome trace event when the
+ * LLVM time-trace profiler is running (--time-trace). Does nothing when
+ * neither is enabled.
+ */
+class PhaseProfiler {
+public:
+    typedef std::vector<std::pair<std::string, size_t>> Counts;  // "loops" -> 12
+
+    struct Phase {
+        std::string name;
+        double seconds;
+        long peakRssKb;          // Peak RSS of the process when the phase ended
+        Counts counts;           // Nodes the phase visited or produced
+    };
+
+    explicit PhaseProfiler(bool enabled = false);
+
+    bool active() const;
+    void begin(const std::string& name);
+    void end(const Counts& counts = Counts());
+    void report() const;  // Table on stderr
+
+    static long peakRssKb();
+
+private:
+    bool enabled;
+    std::string current;
+    std::chrono::steady_clock::time_point started;
+    std::vector<Phase> phases;
+};
+
+#endif // PHASE_PROFILER_H
@@ -0,0 +1,56 @@
+#include "program_index.h"
+
+ProgramIndex& programIndex() {
+    static ProgramIndex index;
+    return index;
+}
+
+void ProgramIndex::addTranslationUnit(const std::string& file, std::map<std::string, FunctionInfo>&& functionInfo,
+                                      const std::map<std::string, FunctionAnalysis>& functionAnalysis) {
+    for (auto& pair : functionInfo) {
+        const std::string& name = pair.first;
+        if (name == "main") {
+            filesWithMain.push_back(file);
+            continue;
+        }
+        if (!pair.second.external_linkage) {
+            continue;
+        }
+        
+        // Inline functions from a shared header are summarized by every unit including it
+        auto existing = functions.find(name);
+        if (existing != functions.end()) {
+            if (existing->second.file != file && existing->second.info.start_line != pair.second.start_line) {
+                duplicateNames.push_back(name);
+            }
+            continue;
+        }
+        
+        FunctionSummary summary;
+        summary.file = file;
+        summary.info = std::move(pair.second);
+        auto analysis = functionAnalysis.find(name);
+        if (analysis != functionAnalysis.end()) {
+            summary.analysis = analysis->second;
+        }
+        functions.emplace(name, std::move(summary));
+    }
+}
+
+size_t ProgramIndex::mergeExternal(const std::string& file, const std::set<std::string>& declared,
+                                   std::map<std::string, FunctionInfo>& functionInfo,
+                                   std::map<std::string, FunctionAnalysis>& functionAnalysis) const {
+    size_t added = 0;
+    for (const std::string& name : declared) {
+        auto it = functions.find(name);
+        if (it == functions.end() || it->second.file == file || functionInfo.count(name)) continue;
+        const FunctionSummary& summary = it->second;
+        
+        FunctionInfo info = summary.info;
+        info.defined_in = summary.file;
+        functionInfo[name] = std::move(info);
+        functionAnalysis[name] = summary.analysis;
+        added++;
+    }
+    return added;
+}
@@ -0,0 +1,48 @@
+#ifndef PROGRAM_INDEX_H
+#define PROGRAM_INDEX_H
+
+#include "data_structures.h"
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * Whole-program mode (--whole-program): summaries of the functions defined in
+ * every translation unit. The first pass fills the index from all sources; the
+ * translation unit with main() then takes the functions it only declares from
+ * here instead of treating them as unknown.
+ */
+class ProgramIndex {
+public:
+    struct FunctionSummary {
+        std::string file;            // Translation unit with the definition
+        FunctionInfo info;           // Signature and loops
+        FunctionAnalysis analysis;   // Global reads and writes, purity
+    };
+
+    // Summaries of one translation unit; the first definition of a name wins.
+    // Functions with internal linkage are private to their unit and skipped.
+    void addTranslationUnit(const std::string& file, std::map<std::string, FunctionInfo>&& functionInfo,
+                            const std::map<std::string, FunctionAnalysis>& functionAnalysis);
+
+    // Adds the functions of declared that are defined in other translation units
+    // than file and not in functionInfo already, marked with defined_in. Returns
+    // how many were added.
+    size_t mergeExternal(const std::string& file, const std::set<std::string>& declared,
+                         std::map<std::string, FunctionInfo>& functionInfo,
+                         std::map<std::string, FunctionAnalysis>& functionAnalysis) const;
+
+    const std::vector<std::string>& mainFiles() const { return filesWithMain; }
+    size_t size() const { return functions.size(); }
+    const std::vector<std::string>& duplicates() const { return duplicateNames; }  // Defined in several units
+
+private:
+    std::map<std::string, FunctionSummary> functions;
+    std::vector<std::string> filesWithMain;
+    std::vector<std::string> duplicateNames;
+};
+
+ProgramIndex& programIndex();
+
+#endif // PROGRAM_INDEX_H
@@ -0,0 +1,236 @@
+#include "region_planner.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+bool MachineModel::parse(const std::string& spec, MachineModel& model, std::string& error) {
+    std::stringstream items(spec);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            error = "expected key=value, got '" + item + "'";
+            return false;
+        }
+        std::string key = item.substr(0, eq);
+        std::string text = item.substr(eq + 1);
+        char* end = nullptr;
+        double value = strtod(text.c_str(), &end);
+        if (text.empty() || *end != '\0' || value <= 0.0) {
+            error = "expected a positive number for " + key + ", got '" + text + "'";
+            return false;
+        }
+        if (key == "latency") model.latencyUs = value;
+        else if (key == "net") model.networkGBs = value;
+        else if (key == "cores") model.cores = std::max(1, (int)value);
+        else if (key == "mem") model.memoryGBs = value;
+        else if (key == "op") model.opNs = value;
+        else if (key == "fork") model.forkJoinUs = value;
+        else {
+            error = "unknown machine parameter '" + key + "' (latency, net, cores, mem, op, fork)";
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string MachineModel::describe() const {
+    char text[160];
+    snprintf(text, sizeof(text), "latency %g us, network %g GB/s, %d cores, memory %g GB/s, %g ns/op, fork/join %g us",
+             latencyUs, networkGBs, cores, memoryGBs, opNs, forkJoinUs);
+    return text;
+}
+
+const char* RegionPlan::modeName() const {
+    switch (mode) {
+        case Serial: return "serial";
+        case Simd: return "simd";
+        case OpenMP: return "openmp";
+        case MPI: return "mpi";
+    }
+    return "openmp";
+}
+
+// Integer literal bound ("0", "1000", "-2", "64u"), false for anything else
+static bool constantBound(const std::string& expr, long long& value) {
+    std::string text;
+    for (char c : expr) {
+        if (!std::isspace((unsigned char)c)) text += c;
+    }
+    while (!text.empty() && (text.back() == 'u' || text.back() == 'U' || text.back() == 'l' || text.back() == 'L')) {
+        text.pop_back();
+    }
+    size_t digits = (!text.empty() && text[0] == '-') ? 1 : 0;
+    if (digits >= text.size()) return false;
+    for (size_t i = digits; i < text.size(); i++) {
+        if (!std::isdigit((unsigned char)text[i])) return false;
+    }
+    value = std::atoll(text.c_str());
+    return true;
+}
+
+// Exclusive end bound: a literal, or the "(8) + 1" / "(8) - 1" the analyzer writes for <= and >=
+static bool constantEnd(const std::string& expr, long long& value) {
+    if (constantBound(expr, value)) return true;
+    size_t close = expr.rfind(')');
+    if (expr.empty() || expr[0] != '(' || close == std::string::npos) return false;
+    std::string rest = expr.substr(close + 1);
+    size_t sign = rest.find_first_not_of(" ");
+    long long bound, offset;
+    if (sign == std::string::npos || (rest[sign] != '+' && rest[sign] != '-') ||
+        !constantBound(expr.substr(1, close - 1), bound) || !constantBound(rest.substr(sign + 1), offset)) {
+        return false;
+    }
+    value = rest[sign] == '+' ? bound + offset : bound - offset;
+    return true;
+}
+
+static long long constantTrips(const LoopInfo& loop) {
+    long long start, end, step;
+    if (!constantBound(loop.start_expr, start) || !constantEnd(loop.end_expr, end) ||
+        !constantBound(loop.step_expr, step) || step == 0) {
+        return -1;
+    }
+    long long trips = step > 0 ? (end - start + step - 1) / step : (start - end - step - 1) / -step;
+    return std::max(0LL, trips);
+}
+
+// Nested loops in the body are assumed to run this many times
+static const double NESTED_TRIPS = 100.0;
+// A call costs about as much as this many operations
+static const double CALL_OPS = 20.0;
+
+// Time of one iteration on one core: arithmetic and subscripts counted on the body
+// text, or the bytes its subscripts load, whichever takes longer
+static double iterationCost(const LoopInfo& loop, const MachineModel& model) {
+    const std::string& source = loop.body_source.empty() ? loop.source_code : loop.body_source;
+    size_t bodyStart = loop.body_source.empty() ? std::min<size_t>(loop.body_offset, source.size()) : 0;
+    double ops = 0.0, bytes = 0.0;
+    bool nested = false;
+    std::string word;
+    for (size_t i = bodyStart; i < source.size(); i++) {
+        char c = source[i];
+        if (std::isalnum((unsigned char)c) || c == '_') {
+            word += c;
+            continue;
+        }
+        if (c == '(' && !word.empty()) {
+            if (word == "for" || word == "while") nested = true;
+            else if (word != "if" && word != "switch" && word != "sizeof" && word != "return") ops += CALL_OPS;
+        }
+        word.clear();
+        if (c == '+' || c == '-' || c == '*' || c == '/' || c == '%') ops += 1.0;
+        if (c == '[') {
+            ops += 1.0;
+            bytes += 8.0;
+        }
+    }
+    double nanoseconds = std::max(std::max(ops, 1.0) * model.opNs, bytes / model.memoryGBs);  // GB/s = bytes/ns
+    return nested ? nanoseconds * NESTED_TRIPS : nanoseconds;
+}
+
+// "#pragma omp parallel for reduction(+:s) schedule(static)" -> "#pragma omp simd reduction(+:s)".
+// Only the clauses simd accepts are kept.
+static std::string simdPragma(const std::string& pragma) {
+    static const std::string parallelFor = "#pragma omp parallel for";
+    std::string result = "#pragma omp simd";
+    size_t pos = parallelFor.length();
+    while (pos < pragma.size()) {
+        size_t nameStart = pragma.find_first_not_of(" ", pos);
+        if (nameStart == std::string::npos) break;
+        size_t open = pragma.find('(', nameStart);
+        size_t space = pragma.find(' ', nameStart);
+        if (open == std::string::npos || (space != std::string::npos && space < open)) {
+            pos = space == std::string::npos ? pragma.size() : space;
+            continue;
+        }
+        int depth = 0;
+        size_t close = open;
+        for (; close < pragma.size(); close++) {
+            if (pragma[close] == '(') depth++;
+            if (pragma[close] == ')' && --depth == 0) break;
+        }
+        std::string name = pragma.substr(nameStart, open - nameStart);
+        if (name == "reduction" || name == "private" || name == "lastprivate" || name == "collapse") {
+            result += " " + pragma.substr(nameStart, close + 1 - nameStart);
+        }
+        pos = close + 1;
+    }
+    return result;
+}
+
+static std::string microseconds(double nanoseconds) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.3g us", nanoseconds / 1000.0);
+    return text;
+}
+
+RegionPlan planLoop(const LoopInfo& loop, const MachineModel& model) {
+    RegionPlan plan;
+    plan.pragma = loop.pragma_text;
+    plan.iterationNs = iterationCost(loop, model);
+    plan.trips = constantTrips(loop);
+
+    if (loop.is_search_loop || loop.is_scan_loop) {
+        plan.mode = loop.is_mpi_parallelizable ? RegionPlan::MPI : RegionPlan::OpenMP;
+        plan.reason = "search and scan loops keep their own parallel form";
+        return plan;
+    }
+
+    const double forkNs = model.forkJoinUs * 1000.0;
+    const double latencyNs = model.latencyUs * 1000.0;
+    const double threadShare = 1.0 - 1.0 / model.cores;  // Work the other threads take off this one
+    bool parallelFor = loop.pragma_text.compare(0, 24, "#pragma omp parallel for") == 0;
+    bool simdLegal = loop.type == "for" && parallelFor && !loop.has_function_calls && loop.atomic_offsets.empty() &&
+                     loop.rand_ranges.empty() && loop.firstprivate_vars.empty();
+
+    // One core per rank: no other thread can share the work, only ranks can
+    bool ranksPay = loop.is_mpi_parallelizable && (plan.trips < 0 || plan.trips * plan.iterationNs > 2.0 * latencyNs);
+    if (threadShare <= 0.0 && !ranksPay) {
+        plan.mode = simdLegal ? RegionPlan::Simd : RegionPlan::Serial;
+        plan.pragma = simdLegal ? simdPragma(loop.pragma_text) : "";
+        plan.reason = "one core per rank, threads have nothing to share";
+        return plan;
+    }
+
+    if (plan.trips >= 0 && threadShare > 0.0) {
+        double work = plan.trips * plan.iterationNs;
+        if (work * threadShare <= forkNs) {
+            plan.mode = simdLegal ? RegionPlan::Simd : RegionPlan::Serial;
+            plan.pragma = simdLegal ? simdPragma(loop.pragma_text) : "";
+            plan.reason = microseconds(work) + " of work, threads would not pay for the fork/join";
+            return plan;
+        }
+        // Even with unlimited ranks a rank saves at most its own share of the work
+        if (loop.is_mpi_parallelizable && work / model.cores <= 2.0 * latencyNs) {
+            plan.mode = RegionPlan::OpenMP;
+            plan.reason = microseconds(work / model.cores) + " per rank, less than one reduction round trip";
+            return plan;
+        }
+    }
+
+    if (loop.is_mpi_parallelizable) {
+        plan.mode = RegionPlan::MPI;
+        plan.runtimeGuard = true;
+        plan.reason = "split across ranks when the saved work exceeds the collectives (decided at run time)";
+        return plan;
+    }
+
+    plan.mode = RegionPlan::OpenMP;
+    plan.reason = "threads pay for the fork/join";
+
+    // Unknown trip count: threads only start above the break-even trip count
+    long long step;
+    if (plan.trips < 0 && loop.type == "for" && loop.declares_loop_variable && parallelFor &&
+        constantBound(loop.step_expr, step) && step > 0 && loop.pragma_text.find(" if(") == std::string::npos) {
+        long long minTrips = (long long)std::ceil(forkNs / (plan.iterationNs * threadShare));
+        std::string trips = "((" + loop.end_expr + ") - (" + loop.start_expr + "))";
+        if (step > 1) trips += " / " + std::to_string(step);
+        plan.pragma += " if(" + trips + " > " + std::to_string(minTrips) + ")";
+        plan.reason = "threads above " + std::to_string(minTrips) + " iterations, the fork/join break-even";
+    }
+    return plan;
+}
@@ -0,0 +1,41 @@
+#ifndef REGION_PLANNER_H
+#define REGION_PLANNER_H
+
+#include "data_structures.h"
+#include <string>
+
+/**
+ * Machine the generated program runs on (--plan=latency=2,net=10,...). Only
+ * orders of magnitude matter: the planner compares the work a region saves
+ * against the cost of forking threads or combining results across ranks.
+ */
+struct MachineModel {
+    double latencyUs = 2.0;       // One network message (latency)
+    double networkGBs = 10.0;     // Network bandwidth per rank (net)
+    int cores = 16;               // Cores per rank (cores)
+    double memoryGBs = 20.0;      // Memory bandwidth of one core (mem)
+    double opNs = 0.5;            // One arithmetic operation or subscript (op)
+    double forkJoinUs = 3.0;      // Opening and joining an OpenMP parallel region (fork)
+
+    // "key=value,..." with the keys in parentheses above; false and a message on error
+    static bool parse(const std::string& spec, MachineModel& model, std::string& error);
+    std::string describe() const;
+};
+
+// How one loop runs in the generated program
+struct RegionPlan {
+    enum Mode { Serial, Simd, OpenMP, MPI };
+    Mode mode = OpenMP;
+    bool runtimeGuard = false;    // MPI: the split is decided at run time from the trip count and rank count
+    double iterationNs = 0.0;     // Estimated time of one iteration on one core
+    long long trips = -1;         // Trip count when the bounds are constants, -1 otherwise
+    std::string pragma;           // Directive for the Simd and OpenMP modes, empty when Serial
+    std::string reason;
+
+    const char* modeName() const;
+};
+
+// Plan for a parallelizable loop; MPI only for loops the analyzer marked splittable
+RegionPlan planLoop(const LoopInfo& loop, const MachineModel& model);
+
+#endif // REGION_PLANNER_H
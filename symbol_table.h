@@ -0,0 +1,106 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef uint32_t SymbolId;
+
+/**
+ * Interned identifiers. Every variable name is stored once; analysis sets hold
+ * 4-byte ids instead of their own string copies. Names keep their address for
+ * the lifetime of the table.
+ */
+class SymbolTable {
+public:
+    static const SymbolId npos = UINT32_MAX;
+
+    SymbolId intern(const std::string& name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        SymbolId id = (SymbolId)names.size();
+        names.push_back(name);
+        ids.emplace(names.back(), id);
+        return id;
+    }
+
+    // Id of a name that was interned before, npos otherwise (does not intern)
+    SymbolId find(const std::string& name) const {
+        auto it = ids.find(name);
+        return it == ids.end() ? npos : it->second;
+    }
+
+    const std::string& name(SymbolId id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+
+private:
+    std::deque<std::string> names;
+    std::unordered_map<std::string, SymbolId> ids;
+};
+
+// One table per process, shared by all analyzers
+inline SymbolTable& symbols() {
+    static SymbolTable table;
+    return table;
+}
+
+/**
+ * Set of interned names as a sorted vector of ids. Drop-in for the
+ * std::set<std::string> members it replaces: insert/count take names and
+ * iteration yields names, in interning order.
+ */
+class SymbolSet {
+public:
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::string value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::string* pointer;
+        typedef const std::string& reference;
+
+        explicit const_iterator(std::vector<SymbolId>::const_iterator it) : it(it) {}
+        reference operator*() const { return symbols().name(*it); }
+        pointer operator->() const { return &symbols().name(*it); }
+        const_iterator& operator++() { ++it; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++it; return old; }
+        bool operator==(const const_iterator& other) const { return it == other.it; }
+        bool operator!=(const const_iterator& other) const { return it != other.it; }
+
+    private:
+        std::vector<SymbolId>::const_iterator it;
+    };
+    typedef const_iterator iterator;
+
+    bool insert(SymbolId id) {
+        auto pos = std::lower_bound(items.begin(), items.end(), id);
+        if (pos != items.end() && *pos == id) return false;
+        items.insert(pos, id);
+        return true;
+    }
+    bool insert(const std::string& name) { return insert(symbols().intern(name)); }
+
+    bool contains(SymbolId id) const { return std::binary_search(items.begin(), items.end(), id); }
+    size_t count(const std::string& name) const {
+        SymbolId id = symbols().find(name);
+        return id != SymbolTable::npos && contains(id) ? 1 : 0;
+    }
+
+    bool empty() const { return items.empty(); }
+    size_t size() const { return items.size(); }
+    void clear() { items.clear(); }
+    const std::vector<SymbolId>& ids() const { return items; }
+
+    const_iterator begin() const { return const_iterator(items.begin()); }
+    const_iterator end() const { return const_iterator(items.end()); }
+
+private:
+    std::vector<SymbolId> items;
+};
+
+#endif // SYMBOL_TABLE_H
@@ -0,0 +1,158 @@
+#include "test_framework.h"
+#include "test_phase3_recursive_tasks.cpp"
+#include "test_phase3_while_loops.cpp"
+#include "test_phase3_early_exit_loops.cpp"
+#include "test_phase3_privatization.cpp"
+#include "test_phase3_array_reductions.cpp"
+#include "test_phase3_scan_loops.cpp"
+#include "test_phase3_source_edits.cpp"
+#include "test_phase3_soa_layout.cpp"
+#include "test_phase3_numa_placement.cpp"
+#include "test_phase3_mpi_transfers.cpp"
+#include "test_phase3_invariant_hoisting.cpp"
+#include "test_phase3_counter_rng.cpp"
+#include "test_phase3_emit_timers.cpp"
+#include "test_phase3_json_report.cpp"
+#include "test_phase3_time_phases.cpp"
+#include "test_phase3_index_dependences.cpp"
+#include "test_phase3_whole_program.cpp"
+#include "test_phase3_region_planner.cpp"
+
+int main() {
+    std::cout << "🧪 PHASE 3 TEST SUITE" << std::endl;
+    std::cout << "=====================" << std::endl;
+    std::cout << "Testing Phase 3 parallelization extensions" << std::endl;
+    std::cout << std::endl;
+    
+    TestFramework framework;
+    
+    std::cout << "📁 PHASE 3 RECURSIVE TASK TESTS" << std::endl;
+    std::cout << "--------------------------------" << std::endl;
+    {
+        Phase3RecursiveTaskTests taskTests(framework);
+        taskTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 WHILE LOOP TESTS" << std::endl;
+    std::cout << "---------------------------" << std::endl;
+    {
+        Phase3WhileLoopTests whileTests(framework);
+        whileTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 EARLY-EXIT LOOP TESTS" << std::endl;
+    std::cout << "--------------------------------" << std::endl;
+    {
+        Phase3EarlyExitLoopTests earlyExitTests(framework);
+        earlyExitTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 PRIVATIZATION TESTS" << std::endl;
+    std::cout << "------------------------------" << std::endl;
+    {
+        Phase3PrivatizationTests privatizationTests(framework);
+        privatizationTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 ARRAY REDUCTION TESTS" << std::endl;
+    std::cout << "-------------------------------" << std::endl;
+    {
+        Phase3ArrayReductionTests arrayReductionTests(framework);
+        arrayReductionTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 SCAN LOOP TESTS" << std::endl;
+    std::cout << "--------------------------" << std::endl;
+    {
+        Phase3ScanLoopTests scanTests(framework);
+        scanTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 SOURCE EDIT TESTS" << std::endl;
+    std::cout << "----------------------------" << std::endl;
+    {
+        Phase3SourceEditTests sourceEditTests(framework);
+        sourceEditTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 SOA LAYOUT TESTS" << std::endl;
+    std::cout << "--------------------------" << std::endl;
+    {
+        Phase3SoALayoutTests soaTests(framework);
+        soaTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 NUMA PLACEMENT TESTS" << std::endl;
+    std::cout << "------------------------------" << std::endl;
+    {
+        Phase3NumaPlacementTests numaTests(framework);
+        numaTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 MPI TRANSFER TESTS" << std::endl;
+    std::cout << "-----------------------------" << std::endl;
+    {
+        Phase3MpiTransferTests transferTests(framework);
+        transferTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 INVARIANT HOISTING TESTS" << std::endl;
+    std::cout << "-----------------------------------" << std::endl;
+    {
+        Phase3InvariantHoistingTests invariantTests(framework);
+        invariantTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 COUNTER RNG TESTS" << std::endl;
+    std::cout << "----------------------------" << std::endl;
+    {
+        Phase3CounterRngTests rngTests(framework);
+        rngTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 TIMER TESTS" << std::endl;
+    std::cout << "----------------------" << std::endl;
+    {
+        Phase3EmitTimersTests timerTests(framework);
+        timerTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 JSON REPORT TESTS" << std::endl;
+    std::cout << "----------------------------" << std::endl;
+    {
+        Phase3JsonReportTests reportTests(framework);
+        reportTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 SELF-PROFILING TESTS" << std::endl;
+    std::cout << "-------------------------------" << std::endl;
+    {
+        Phase3TimePhasesTests profilingTests(framework);
+        profilingTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 INDEX DEPENDENCE TESTS" << std::endl;
+    std::cout << "---------------------------------" << std::endl;
+    {
+        Phase3IndexDependenceTests dependenceTests(framework);
+        dependenceTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 WHOLE-PROGRAM TESTS" << std::endl;
+    std::cout << "------------------------------" << std::endl;
+    {
+        Phase3WholeProgramTests wholeProgramTests(framework);
+        wholeProgramTests.run_all_tests();
+    }
+    
+    std::cout << std::endl << "📁 PHASE 3 REGION PLANNER TESTS" << std::endl;
+    std::cout << "-------------------------------" << std::endl;
+    {
+        Phase3RegionPlannerTests regionPlannerTests(framework);
+        regionPlannerTests.run_all_tests();
+    }
+    
+    framework.print_summary();
+    
+    return framework.all_passed() ? 0 : 1;
+}
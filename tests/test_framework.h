@@ -166,9 +166,10 @@ std::string create_temp_cpp_file(const std::string& content, const std::string&
 }
 
 // Helper function to run MPI parallelizer on a test file
-std::string run_parallelizer_on_file(const std::string& filepath) {
+std::string run_parallelizer_on_file(const std::string& filepath, const std::string& options = "") {
     // FIXED: Use the current Phase 2 version (not build/ version)
-    std::string command = "cd /home/khanh/parallel && ./mpi-parallelizer " + filepath + " > /dev/null 2>&1";
+    std::string command = "cd /home/khanh/parallel && ./mpi-parallelizer " +
+                          (options.empty() ? std::string() : options + " ") + filepath + " > /dev/null 2>&1";
     int result = system(command.c_str());
     
     if (result != 0) {
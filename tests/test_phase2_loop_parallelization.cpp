@@ -228,8 +228,8 @@ int main() {
                                 "Thread-unsafe functions are identified");
         
         // Should replace with thread-safe alternative
-        framework.assert_contains(output, "rand_r(&__thread_seed)", 
-                                "rand() is replaced with rand_r()");
+        framework.assert_contains(output, "sum += _counter_rand(", 
+                                "rand() is replaced with the counter-based generator");
         
         // Should still be parallelizable with fixes
         framework.assert_contains(output, "#pragma omp parallel for", 
@@ -0,0 +1,133 @@
+#include "test_framework.h"
+
+class Phase3ArrayReductionTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3ArrayReductionTests(TestFramework& f) : framework(f) {}
+    
+    void test_small_histogram_uses_array_section_reduction() {
+        std::cout << "Testing array-section reduction for small histograms..." << std::endl;
+        
+        std::string testCode = R"(
+int histogram(const int* data, int n) {
+    int hist[16] = {0};
+    for (int i = 0; i < n; i++) {
+        hist[data[i] & 15]++;
+    }
+    return hist[0];
+}
+
+int main() {
+    int data[1000];
+    histogram(data, 1000);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "histogram_reduction_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "reduction(+:hist[0:16])", 
+                                "Small histogram gets a private copy per thread");
+        framework.assert_not_contains(output, "#pragma omp atomic", 
+                                    "Array-section reduction needs no atomics");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_unsized_target_uses_atomic() {
+        std::cout << "Testing omp atomic for updates through a pointer..." << std::endl;
+        
+        std::string testCode = R"(
+void scatter_add(const int* index, const double* value, double* target, int n) {
+    for (int i = 0; i < n; i++) {
+        if (value[i] > 0.0) target[index[i]] += value[i];
+    }
+}
+
+int main() {
+    int index[100];
+    double value[100], target[100];
+    scatter_add(index, value, target, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "scatter_atomic_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "#pragma omp atomic\n", 
+                                "Update of an unsized array is guarded with omp atomic");
+        framework.assert_not_contains(output, "reduction(+:target", 
+                                    "No private copy of an array of unknown length");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_mpi_combines_whole_array() {
+        std::cout << "Testing a single MPI_Allreduce over the whole histogram..." << std::endl;
+        
+        std::string testCode = R"(
+long count_buckets(const int* data, int n) {
+    long buckets[64] = {0};
+    for (int i = 0; i < n; i++) {
+        buckets[data[i] % 64] += 1;
+    }
+    return buckets[1];
+}
+
+int main() {
+    int data[1000];
+    count_buckets(data, 1000);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "histogram_mpi_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "MPI_Allreduce(MPI_IN_PLACE, buckets, (int)(64), MPI_LONG, MPI_SUM, MPI_COMM_WORLD);", 
+                                "Ranks combine the histogram with one collective");
+        framework.assert_contains(output, "if (_mpi_rank != 0) {", 
+                                "Other ranks start from a zeroed histogram");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_mixed_access_stays_serial() {
+        std::cout << "Testing that arrays read elsewhere in the loop block parallelization..." << std::endl;
+        
+        std::string testCode = R"(
+void link(int* next, const int* from, int n) {
+    for (int i = 0; i < n; i++) {
+        next[from[i]] += next[i];
+    }
+}
+
+int main() {
+    int next[100], from[100];
+    link(next, from, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "mixed_array_access_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "Array 'next' is updated through a computed subscript and also accessed otherwise", 
+                                "Conflicting access is reported");
+        framework.assert_not_contains(output, "Enhanced function with OpenMP pragmas: link", 
+                                    "Loop with conflicting array access stays serial");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_small_histogram_uses_array_section_reduction();
+        test_unsized_target_uses_atomic();
+        test_mpi_combines_whole_array();
+        test_mixed_access_stays_serial();
+    }
+};
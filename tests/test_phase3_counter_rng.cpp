@@ -0,0 +1,158 @@
+#include "test_framework.h"
+
+class Phase3CounterRngTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3CounterRngTests(TestFramework& f) : framework(f) {}
+    
+    void test_rand_indexed_by_iteration() {
+        std::cout << "Testing rand() drawn from a counter-based generator..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cstdlib>
+#include <cstdio>
+
+double noise(double* a, int n) {
+    double total = 0.0;
+    for (int i = 0; i < n; i++) {
+        a[i] = rand() % 100;
+        total += rand() % 10;
+    }
+    return total;
+}
+
+int main() {
+    static double a[1000];
+    printf("%f\n", noise(a, 1000));
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "counter_rng_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "static inline int _counter_rand(", 
+                                "The generator is emitted once at file scope");
+        framework.assert_contains(output, "unsigned int _rng_draw[2] = {};", 
+                                "Each call site counts its draws within the iteration");
+        framework.assert_contains(output, "(unsigned long long)(i), _rng_draw[1]++) % 10;", 
+                                "Draws are indexed by the loop variable, not by the thread");
+        framework.assert_contains(output, "unsigned long long _rng_call = _rng_next_call();", 
+                                "Every call of the function gets its own stream");
+        framework.assert_not_contains(output, "rand_r(", 
+                                    "No per-thread seed state is left");
+        framework.assert_not_contains(output, "time(NULL)", 
+                                    "Results no longer depend on the clock");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_while_loop_keeps_sequential_rand() {
+        std::cout << "Testing that rand() in a while loop keeps its sequential order..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cstdlib>
+
+int walk(int n) {
+    int pos = 0;
+    int i = 0;
+    while (i < n) {
+        pos += rand() % 3 - 1;
+        i++;
+    }
+    return pos;
+}
+
+int main() {
+    int p = walk(1000);
+    return p > 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "counter_rng_while_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "pos += rand() % 3 - 1;", 
+                                "rand() outside a canonical for loop is left alone");
+        framework.assert_not_contains(output, "_counter_rand(", 
+                                    "No generator is emitted for serial loops");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_streams_follow_main_calls_not_ranks() {
+        std::cout << "Testing that random streams are numbered by main's calls on every rank..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cstdlib>
+#include <cstdio>
+
+double noise(int n) {
+    double total = 0.0;
+    for (int i = 0; i < n; i++) {
+        total += rand() % 100;
+    }
+    return total;
+}
+
+int main() {
+    double a = noise(1000);
+    double b = noise(1000);
+    printf("%f %f\n", a, b);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "counter_rng_calls_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "_rng_main_call++;", 
+                                "main numbers each call on every rank");
+        framework.assert_contains(output, "call = (_rng_main_call << 32) | _rng_nested_calls++;", 
+                                "The stream comes from main's call number");
+        framework.assert_not_contains(output, "static unsigned long long _rng_calls = 0;", 
+                                    "No per-process call counter is left");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_unbraced_body_counts_draws() {
+        std::cout << "Testing rand() in an inner loop under an unbraced body..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cstdlib>
+
+int grid[64][64];
+
+void fill() {
+    for (int i = 0; i < 64; i++)
+        for (int j = 0; j < 64; j++)
+            grid[i][j] = rand() % 100;
+}
+
+int main() {
+    fill();
+    return grid[1][2];
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "counter_rng_unbraced_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "{ unsigned int _rng_draw[1] = {}; for (int j = 0; j < 64; j++)", 
+                                "The unbraced body gets a block with its draw counters");
+        framework.assert_contains(output, "_rng_draw[0]++) % 100; };", 
+                                "Every inner iteration draws the next number");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_rand_indexed_by_iteration();
+        test_streams_follow_main_calls_not_ranks();
+        test_while_loop_keeps_sequential_rand();
+        test_unbraced_body_counts_draws();
+    }
+};
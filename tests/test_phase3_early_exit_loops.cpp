@@ -0,0 +1,141 @@
+#include "test_framework.h"
+
+class Phase3EarlyExitLoopTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3EarlyExitLoopTests(TestFramework& f) : framework(f) {}
+    
+    void test_continue_does_not_block_parallelization() {
+        std::cout << "Testing that continue is allowed in parallel loops..." << std::endl;
+        
+        std::string testCode = R"(
+void clamp_positive(double* data, int n) {
+    for (int i = 0; i < n; i++) {
+        if (data[i] >= 0.0) continue;
+        data[i] = 0.0;
+    }
+}
+
+int main() {
+    double data[100];
+    clamp_positive(data, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "continue_loop_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "Enhanced function with OpenMP pragmas: clamp_positive", 
+                                "Loop with continue is parallelized");
+        framework.assert_contains(output, "long _loop_end = n;", 
+                                "Loop with continue is still split across MPI ranks");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_break_in_inner_loop_keeps_outer_loop_parallel() {
+        std::cout << "Testing that a break in an inner loop stays local to it..." << std::endl;
+        
+        std::string testCode = R"(
+void mark_rows(int* flags, const int* grid, int rows, int cols) {
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            if (grid[r * cols + c] < 0) {
+                flags[r] = 1;
+                break;
+            }
+        }
+    }
+}
+
+int main() {
+    int flags[10] = {0};
+    int grid[100] = {0};
+    mark_rows(flags, grid, 10, 10);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "inner_break_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "Enhanced function with OpenMP pragmas: mark_rows", 
+                                "Outer loop is parallelized despite the inner break");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_find_first_loop_becomes_distributed_search() {
+        std::cout << "Testing chunked MPI search for find-first loops..." << std::endl;
+        
+        std::string testCode = R"(
+int search_value(const int* arr, int size, int target) {
+    for (int i = 0; i < size; i++) {
+        if (arr[i] == target) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int main() {
+    int data[] = {10, 20, 30, 40, 50};
+    int index = search_value(data, 5, 30);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "find_first_search_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "#pragma omp cancel for", 
+                                "Early return cancels the probe");
+        framework.assert_contains(output, "MPI_Allreduce(&_search_found, &_search_resume, 1, MPI_LONG, MPI_MIN, MPI_COMM_WORLD);", 
+                                "Ranks agree on the earliest chunk with a hit");
+        framework.assert_contains(output, "for (int i = _search_start + _search_resume * _search_step; i < size; i++)", 
+                                "Original loop replays serially from the winning chunk");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_break_with_shared_state_stays_serial() {
+        std::cout << "Testing that breaks depending on accumulated state stay serial..." << std::endl;
+        
+        std::string testCode = R"(
+int accumulate_until(const int* data, int n, int limit) {
+    int total = 0;
+    for (int i = 0; i < n; i++) {
+        total += data[i];
+        if (total > limit) break;
+    }
+    return total;
+}
+
+int main() {
+    int data[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    int total = accumulate_until(data, 10, 20);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "break_shared_state_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_not_contains(output, "Enhanced function with OpenMP pragmas: accumulate_until", 
+                                    "Reduction does not re-enable a loop with break");
+        framework.assert_not_contains(output, "_search_hit", 
+                                    "Accumulating loop is not treated as a search");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_continue_does_not_block_parallelization();
+        test_break_in_inner_loop_keeps_outer_loop_parallel();
+        test_find_first_loop_becomes_distributed_search();
+        test_break_with_shared_state_stays_serial();
+    }
+};
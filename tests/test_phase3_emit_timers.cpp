@@ -0,0 +1,90 @@
+#include "test_framework.h"
+
+class Phase3EmitTimersTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3EmitTimersTests(TestFramework& f) : framework(f) {}
+    
+    void test_regions_timed_and_reported() {
+        std::cout << "Testing --emit-timers instrumentation of parallel regions..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cstdio>
+
+double scale(double* a, int n) {
+    double total = 0.0;
+    for (int i = 0; i < n; i++) {
+        total += a[i] * 0.5;
+    }
+    return total;
+}
+
+int offset(int k) {
+    return k + 1;
+}
+
+int main() {
+    static double a[1000];
+    double s = scale(a, 1000);
+    int o = offset(41);
+    printf("%f %d\n", s, o);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "emit_timers_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath, "--emit-timers");
+        
+        framework.assert_contains(output, "static void _timer_report() {", 
+                                "The report is emitted once at file scope");
+        framework.assert_contains(output, "\"main (total)\"", 
+                                "The whole program is a region");
+        framework.assert_contains(output, " loop\"", 
+                                "The distributed loop is a region");
+        framework.assert_contains(output, " = MPI_Wtime();", 
+                                "Regions are timed with MPI_Wtime");
+        framework.assert_contains(output, "MPI_Gather(_timer_totals", 
+                                "Per-rank totals reach rank 0 in one collective");
+        framework.assert_contains(output, "_timer_report();\n    MPI_Finalize();", 
+                                "The report is printed right before MPI_Finalize");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_no_timers_by_default() {
+        std::cout << "Testing that generated code is untimed without --emit-timers..." << std::endl;
+        
+        std::string testCode = R"(
+double scale(double* a, int n) {
+    double total = 0.0;
+    for (int i = 0; i < n; i++) {
+        total += a[i] * 0.5;
+    }
+    return total;
+}
+
+int main() {
+    static double a[1000];
+    double s = scale(a, 1000);
+    return s > 0.0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "emit_timers_off_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_not_contains(output, "_timer_", 
+                                    "No timer code is generated");
+        framework.assert_not_contains(output, "MPI_Wtime()", 
+                                    "No clock reads are added");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_regions_timed_and_reported();
+        test_no_timers_by_default();
+    }
+};
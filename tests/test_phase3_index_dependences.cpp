@@ -0,0 +1,98 @@
+#include "test_framework.h"
+
+class Phase3IndexDependenceTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3IndexDependenceTests(TestFramework& f) : framework(f) {}
+    
+    void test_comparison_is_not_a_store() {
+        std::cout << "Testing that a[i] == a[i + 1] does not count as a store..." << std::endl;
+        
+        std::string testCode = R"(
+void mark_runs(const int* a, int* same, int n) {
+    for (int i = 0; i < n - 1; i++) {
+        same[i] = (a[i] == a[i + 1]);
+    }
+}
+
+int main() {
+    int a[100], same[100];
+    mark_runs(a, same, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "index_compare_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "#pragma omp parallel for", 
+                                "Reading neighbours of an array that is never stored is independent");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_member_store_carries_dependence() {
+        std::cout << "Testing that v[i].x = v[i - 1].x is a loop-carried dependence..." << std::endl;
+        
+        std::string testCode = R"(
+struct Cell {
+    double x;
+    double y;
+};
+
+void smooth(Cell* v, int n) {
+    for (int i = 1; i < n; i++) {
+        v[i].x = v[i - 1].x * 0.5 + v[i].y;
+    }
+}
+
+int main() {
+    static Cell v[100];
+    smooth(v, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "index_member_dependence_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_not_contains(output, "#pragma omp parallel for", 
+                                    "The previous element's field is read after it was stored");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_compound_store_carries_dependence() {
+        std::cout << "Testing that a[i] *= a[i - 1] is a loop-carried dependence..." << std::endl;
+        
+        std::string testCode = R"(
+void compound(double* a, int n) {
+    for (int i = 1; i < n; i++) {
+        a[i] *= a[i - 1];
+    }
+}
+
+int main() {
+    static double a[100];
+    compound(a, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "index_compound_dependence_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_not_contains(output, "#pragma omp parallel for", 
+                                    "Compound assignments store the element too");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_comparison_is_not_a_store();
+        test_member_store_carries_dependence();
+        test_compound_store_carries_dependence();
+    }
+};
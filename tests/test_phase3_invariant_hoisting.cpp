@@ -0,0 +1,124 @@
+#include "test_framework.h"
+
+class Phase3InvariantHoistingTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3InvariantHoistingTests(TestFramework& f) : framework(f) {}
+    
+    void test_pure_calls_hoisted_into_preamble() {
+        std::cout << "Testing pure calls evaluated once in the MPI preamble..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cmath>
+#include <vector>
+#include <cstdio>
+
+double norm_sum(const std::vector<double>& v, int n) {
+    double s = 0.0;
+    for (int i = 0; i < n; i++) {
+        s += v[i] * sqrt((double)n) / v.size();
+    }
+    return s;
+}
+
+int main() {
+    std::vector<double> v(1000, 1.0);
+    double s = norm_sum(v, 1000);
+    printf("%f\n", s);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "invariant_pure_call_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "const auto _inv_0 = ", 
+                                "Invariant expressions get a constant in the preamble");
+        framework.assert_contains(output, "sqrt((double)n);", 
+                                "sqrt of a loop-invariant argument is hoisted");
+        framework.assert_contains(output, "v.size();", 
+                                "Const size() of an unmodified container is hoisted");
+        framework.assert_not_contains(output, "s += v[i] * sqrt((double)n) / v.size();", 
+                                    "The loop body reads the hoisted constants instead");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_written_variables_not_hoisted() {
+        std::cout << "Testing that expressions over loop-written variables stay in the loop..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cmath>
+#include <cstdio>
+
+double damped(const double* a, int n) {
+    double s = 0.0;
+    double scale = 1.0;
+    for (int i = 0; i < n; i++) {
+        scale = a[i] * 0.5;
+        s += sqrt(scale + 1.0);
+    }
+    return s;
+}
+
+int main() {
+    double a[1000];
+    for (int i = 0; i < 1000; i++) a[i] = i;
+    printf("%f\n", damped(a, 1000));
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "invariant_written_var_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_not_contains(output, "const auto _inv_", 
+                                    "A variable assigned in the body is not invariant");
+        framework.assert_contains(output, "s += sqrt(scale + 1.0);", 
+                                "The call stays in the loop body");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_for_init_variables_not_hoisted() {
+        std::cout << "Testing that variables declared in the for-init stay in the loop..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cmath>
+#include <vector>
+#include <cstdio>
+
+double spread(const std::vector<double>& v) {
+    double s = 0.0;
+    for (int i = 0, len = v.size(); i < len; i++) {
+        s += v[i] * sqrt((double)len);
+    }
+    return s;
+}
+
+int main() {
+    std::vector<double> v(1000, 1.0);
+    printf("%f\n", spread(v));
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "invariant_for_init_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_not_contains(output, "sqrt((double)len);", 
+                                    "An expression over a for-init variable is not hoisted out of its scope");
+        framework.assert_contains(output, "s += v[i] * sqrt((double)len);", 
+                                "The call stays in the loop body");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_pure_calls_hoisted_into_preamble();
+        test_written_variables_not_hoisted();
+        test_for_init_variables_not_hoisted();
+    }
+};
@@ -0,0 +1,106 @@
+#include "test_framework.h"
+
+class Phase3JsonReportTests {
+private:
+    TestFramework& framework;
+    
+    std::string read_report(const std::string& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return "ERROR: Could not open " + path;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+    
+public:
+    Phase3JsonReportTests(TestFramework& f) : framework(f) {}
+    
+    void test_loops_edges_and_groups() {
+        std::cout << "Testing the --report=json analysis report..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cstdio>
+
+int counter = 0;
+
+double sum_array(double* a, int n) {
+    double total = 0.0;
+    for (int i = 0; i < n; i++) {
+        total += a[i];
+    }
+    return total;
+}
+
+void bump() {
+    counter++;
+}
+
+int read_counter() {
+    return counter;
+}
+
+int main() {
+    static double a[1000];
+    double s = sum_array(a, 1000);
+    bump();
+    int c = read_counter();
+    printf("%f %d\n", s, c);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "json_report_test.cpp");
+        run_parallelizer_on_file(filepath, "--report=json");
+        std::string reportPath = "/home/khanh/parallel/json_report_test_report.json";
+        std::string report = read_report(reportPath);
+        
+        framework.assert_contains(report, "\"name\": \"sum_array\"", 
+                                "Every function is reported");
+        framework.assert_contains(report, "\"end\": \"n\"", 
+                                "Loop bounds are reported");
+        framework.assert_contains(report, "\"op\": \"+\"", 
+                                "The reduction operator is reported");
+        framework.assert_contains(report, "\"pragma\": \"#pragma omp parallel for", 
+                                "The generated pragma is reported");
+        framework.assert_contains(report, "\"reason\": \"Global variable RAW: counter\"", 
+                                "Dependence edges carry their own reason");
+        framework.assert_contains(report, "\"groups\": [", 
+                                "The parallel groups are reported");
+        framework.assert_contains(report, "\"loop_coverage\": ", 
+                                "Coverage is summarized for dashboards");
+        
+        remove(filepath.c_str());
+        remove(reportPath.c_str());
+    }
+    
+    void test_no_report_by_default() {
+        std::cout << "Testing that no report is written without --report..." << std::endl;
+        
+        std::string testCode = R"(
+int twice(int x) {
+    return 2 * x;
+}
+
+int main() {
+    int y = twice(21);
+    return y != 42;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "json_report_off_test.cpp");
+        run_parallelizer_on_file(filepath);
+        std::string report = read_report("/home/khanh/parallel/json_report_off_test_report.json");
+        
+        framework.assert_contains(report, "ERROR: Could not open", 
+                                "The report is opt-in");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_loops_edges_and_groups();
+        test_no_report_by_default();
+    }
+};
@@ -0,0 +1,236 @@
+#include "test_framework.h"
+
+class Phase3MpiTransferTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3MpiTransferTests(TestFramework& f) : framework(f) {}
+    
+    void test_vector_result_sends_size_then_data() {
+        std::cout << "Testing std::vector results broadcast as size then data..." << std::endl;
+        
+        std::string testCode = R"(
+#include <vector>
+#include <cstdio>
+
+std::vector<double> make_samples(int n) {
+    std::vector<double> v(n);
+    for (int i = 0; i < n; i++) {
+        v[i] = i * 0.5;
+    }
+    return v;
+}
+
+int main() {
+    std::vector<double> samples = make_samples(1000);
+    printf("%f\n", samples[10]);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "vector_transfer_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "MPI_Bcast(&_count_samples, 1, MPI_LONG, 0, MPI_COMM_WORLD);", 
+                                "Vector length is broadcast first");
+        framework.assert_contains(output, "samples.resize(_count_samples);", 
+                                "Receiving ranks resize before the data arrives");
+        framework.assert_contains(output, "MPI_Bcast(samples.data(), (int)_count_samples, MPI_DOUBLE, 0, MPI_COMM_WORLD);", 
+                                "Vector elements are broadcast from data()");
+        framework.assert_not_contains(output, "Cannot broadcast type", 
+                                    "Vector result is no longer left on rank 0");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_struct_result_uses_derived_datatype() {
+        std::cout << "Testing trivially copyable structs sent with MPI_Type_create_struct..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cstdio>
+
+struct Stats {
+    double mean;
+    int count;
+    double bounds[2];
+};
+
+Stats summarize(int n) {
+    Stats s;
+    s.mean = n / 2.0;
+    s.count = n;
+    s.bounds[0] = 0.0;
+    s.bounds[1] = n;
+    return s;
+}
+
+int main() {
+    Stats stats = summarize(100);
+    printf("%f %d\n", stats.mean, stats.count);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "struct_transfer_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "struct Stats {", 
+                                "Struct definition is carried into the generated program");
+        framework.assert_contains(output, "inline MPI_Datatype _mpi_type_Stats()", 
+                                "Derived datatype helper is generated for the struct");
+        framework.assert_contains(output, "int lengths[3] = {1, 1, 2};", 
+                                "Array fields keep their element count");
+        framework.assert_contains(output, "MPI_Type_create_resized(packed, 0, sizeof(Stats), &type);", 
+                                "Datatype extent covers the struct padding");
+        framework.assert_contains(output, "MPI_Bcast(&stats, 1, _mpi_type_Stats(), 0, MPI_COMM_WORLD);", 
+                                "Struct result is broadcast with its datatype");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_pointer_struct_not_transferred() {
+        std::cout << "Testing that structs holding pointers are not sent by value..." << std::endl;
+        
+        std::string testCode = R"(
+struct Buffer {
+    double* data;
+    int size;
+};
+
+Buffer allocate(int n) {
+    Buffer b;
+    b.data = new double[n];
+    b.size = n;
+    return b;
+}
+
+int main() {
+    Buffer buf = allocate(100);
+    delete[] buf.data;
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "pointer_struct_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_not_contains(output, "_mpi_type_Buffer", 
+                                    "Pointer fields would be meaningless on another rank");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_typedefs_resolve_to_their_width() {
+        std::cout << "Testing MPI datatypes for size_t, int64_t, typedefs and long double..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+typedef double real_t;
+
+size_t count_items(int n) {
+    return (size_t)n * 3;
+}
+
+int64_t checksum(int n) {
+    return (int64_t)n << 40;
+}
+
+real_t scale(int n) {
+    return n * 0.25;
+}
+
+long double precise(int n) {
+    return n / 3.0L;
+}
+
+int main() {
+    size_t items = count_items(10);
+    int64_t sum = checksum(7);
+    real_t factor = scale(4);
+    long double exact = precise(1);
+    printf("%zu %lld %f %Lf\n", items, (long long)sum, factor, exact);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "typedef_transfer_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "MPI_Bcast(&items, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);", 
+                                "size_t is sent at its full width");
+        framework.assert_contains(output, "MPI_Bcast(&sum, 1, MPI_LONG, 0, MPI_COMM_WORLD);", 
+                                "int64_t resolves to its underlying builtin");
+        framework.assert_contains(output, "MPI_Bcast(&factor, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);", 
+                                "User typedefs resolve to the type they name");
+        framework.assert_contains(output, "MPI_Bcast(&exact, 1, MPI_LONG_DOUBLE, 0, MPI_COMM_WORLD);", 
+                                "long double keeps its extended precision");
+        framework.assert_not_contains(output, "MPI_INT, 0, MPI_COMM_WORLD);", 
+                                    "Nothing falls back to MPI_INT");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_repeated_calls_use_persistent_transfers() {
+        std::cout << "Testing persistent broadcasts and RMA windows for calls in loops..." << std::endl;
+        
+        std::string testCode = R"(
+#include <array>
+#include <cstdio>
+
+double step(int it) {
+    return it * 0.5;
+}
+
+std::array<double, 4096> field(int it) {
+    std::array<double, 4096> f;
+    f.fill(it);
+    return f;
+}
+
+int main() {
+    double total = 0.0;
+    for (int it = 0; it < 100; it++) {
+        const double r = step(it);
+        std::array<double, 4096> f = field(it);
+        total += r + f[it];
+    }
+    printf("%f\n", total);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "persistent_transfer_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "MPI_Bcast_init(&_persist_", 
+                                "Small results get a persistent broadcast set up once");
+        framework.assert_contains(output, "MPI_Start(&_persist_req_", 
+                                "Each iteration only restarts the broadcast");
+        framework.assert_not_contains(output, "MPI_Send_init(", 
+                                    "Rank 0 does not send to every rank itself");
+        framework.assert_contains(output, "MPI_Win_create(&_persist_", 
+                                "Large fixed-size results are exposed through a window");
+        framework.assert_contains(output, "MPI_Get(_persist_", 
+                                "The other ranks get the large result from rank 0");
+        framework.assert_not_contains(output, "MPI_Put(", 
+                                    "Rank 0 does not put into every rank itself");
+        framework.assert_contains(output, "MPI_Win_free(&_persist_win_", 
+                                "Window is released after the loop");
+        framework.assert_not_contains(output, "const double _persist_", 
+                                    "The buffer of a const result stays assignable");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_vector_result_sends_size_then_data();
+        test_struct_result_uses_derived_datatype();
+        test_pointer_struct_not_transferred();
+        test_typedefs_resolve_to_their_width();
+        test_repeated_calls_use_persistent_transfers();
+    }
+};
@@ -0,0 +1,117 @@
+#include "test_framework.h"
+
+class Phase3NumaPlacementTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3NumaPlacementTests(TestFramework& f) : framework(f) {}
+    
+    void test_initialization_loop_first_touch() {
+        std::cout << "Testing parallel first-touch initialization with --numa..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cstdio>
+
+double total(const double* a, int n) {
+    double s = 0.0;
+    for (int i = 0; i < n; i++) {
+        s += a[i];
+    }
+    return s;
+}
+
+int main() {
+    int n = 1000000;
+    double* a = new double[n];
+    for (int i = 0; i < n; i++) {
+        a[i] = 0.5 * i;
+    }
+    double s = total(a, n);
+    printf("%f\n", s);
+    delete[] a;
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "numa_first_touch_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath, "--numa");
+        
+        framework.assert_contains(output, "#pragma omp parallel for schedule(static) proc_bind(spread)\n        for (int i = _my_start; i < _my_end; i += _loop_step) {\n            a[i] = 0.5 * i;", 
+                                "Initialization loop in main first touches the rank's block with its threads");
+        framework.assert_contains(output, "for (int i = _my_end; i < _loop_end; i += _loop_step) {", 
+                                "Elements of the other ranks are still initialized");
+        framework.assert_not_contains(output, "proc_bind(spread)\n    for (int i = 0; i < n; i++) {", 
+                                    "The full range is not split over the threads of every rank");
+        framework.assert_contains(output, "reduction(+:s) schedule(static) proc_bind(spread)", 
+                                "Compute loop binds its threads the same way");
+        framework.assert_contains(output, "MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED", 
+                                "Ranks per node are counted for the OMP_PLACES guidance");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_dynamic_schedule_becomes_static() {
+        std::cout << "Testing static schedules and proc_bind(close) with --numa=close..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cmath>
+
+void transform(double* a, int n) {
+    for (int i = 0; i < n; i++) {
+        a[i] = sqrt(a[i]) + 1.0;
+    }
+}
+
+int main() {
+    double a[1000];
+    transform(a, 1000);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "numa_schedule_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath, "--numa=close");
+        
+        framework.assert_contains(output, "schedule(static) proc_bind(close)", 
+                                "Loop keeps the first-touch schedule and binds threads close");
+        framework.assert_not_contains(output, "schedule(dynamic", 
+                                    "Dynamic schedules would move iterations away from their pages");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_default_keeps_runtime_placement() {
+        std::cout << "Testing that placement is left to the runtime by default..." << std::endl;
+        
+        std::string testCode = R"(
+void fill(double* a, int n) {
+    for (int i = 0; i < n; i++) {
+        a[i] = i;
+    }
+}
+
+int main() {
+    double a[1000];
+    fill(a, 1000);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "numa_default_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_not_contains(output, "proc_bind", 
+                                    "No proc_bind clause unless --numa is given");
+        framework.assert_not_contains(output, "MPI_COMM_TYPE_SHARED", 
+                                    "No placement guidance by default");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_initialization_loop_first_touch();
+        test_dynamic_schedule_becomes_static();
+        test_default_keeps_runtime_placement();
+    }
+};
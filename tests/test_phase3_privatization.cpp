@@ -0,0 +1,161 @@
+#include "test_framework.h"
+
+class Phase3PrivatizationTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3PrivatizationTests(TestFramework& f) : framework(f) {}
+    
+    void test_scalar_temporary_is_private() {
+        std::cout << "Testing private clause for scalar temporaries..." << std::endl;
+        
+        std::string testCode = R"(
+void transform(const double* in, double* out, int n) {
+    double t;
+    for (int i = 0; i < n; i++) {
+        t = in[i] * 2.0;
+        out[i] = t + 1.0;
+    }
+}
+
+int main() {
+    double in[100], out[100];
+    transform(in, out, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "private_scalar_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "#pragma omp parallel for private(t)", 
+                                "Temporary written before use is private");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_live_out_temporary_is_lastprivate() {
+        std::cout << "Testing lastprivate for temporaries used after the loop..." << std::endl;
+        
+        std::string testCode = R"(
+double last_square(const double* in, double* out, int n) {
+    double t = 0.0;
+    for (int i = 0; i < n; i++) {
+        t = in[i] * in[i];
+        out[i] = t;
+    }
+    return t;
+}
+
+int main() {
+    double in[100], out[100];
+    double last = last_square(in, out, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "lastprivate_scalar_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "firstprivate(t) lastprivate(t)", 
+                                "Live-out temporary keeps its sequential final value");
+        framework.assert_contains(output, "MPI_Bcast(&t, sizeof(t), MPI_BYTE, _last_owner, MPI_COMM_WORLD);", 
+                                "Final value comes from the rank that ran the last iteration");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_temporary_arrays_are_privatized() {
+        std::cout << "Testing privatization of temporary arrays and inner loop counters..." << std::endl;
+        
+        std::string testCode = R"(
+void smooth(const double* in, double* out, int n) {
+    int k;
+    double window[3];
+    for (int i = 1; i < n - 1; i++) {
+        for (k = 0; k < 3; k++) {
+            window[k] = in[i + k - 1];
+        }
+        out[i] = (window[0] + window[1] + window[2]) / 3.0;
+    }
+}
+
+void weigh(const double* in, double* out, int n) {
+    double w[2] = {0.25, 0.75};
+    for (int i = 0; i < n; i++) {
+        w[0] = in[i];
+        out[i] = w[0] * w[1];
+    }
+}
+
+void blend(const double* in, double* out, int n) {
+    double mix[2];
+    mix[1] = 0.5;
+    for (int i = 0; i < n; i++) {
+        mix[0] = in[i];
+        out[i] = mix[0] * mix[1];
+    }
+}
+
+int main() {
+    double in[100], out[100];
+    smooth(in, out, 100);
+    weigh(in, out, 100);
+    blend(in, out, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "private_array_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "private(k,window)", 
+                                "Inner counter and scratch array are private");
+        framework.assert_contains(output, "firstprivate(w)", 
+                                "Initialized scratch array starts from its initializer");
+        framework.assert_contains(output, "firstprivate(mix)", 
+                                "Partly overwritten array keeps the elements set before the loop");
+        framework.assert_not_contains(output, " private(mix)", 
+                                    "Partly overwritten array is not a fresh temporary");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_carried_scalar_blocks_parallelization() {
+        std::cout << "Testing that scalars carried across iterations block parallelization..." << std::endl;
+        
+        std::string testCode = R"(
+void running(const double* in, double* out, int n) {
+    double prev = 0.0;
+    for (int i = 0; i < n; i++) {
+        out[i] = in[i] + prev;
+        prev = in[i];
+    }
+}
+
+int main() {
+    double in[100], out[100];
+    running(in, out, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "carried_scalar_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "Scalar 'prev' is read before it is written", 
+                                "Carried scalar is reported");
+        framework.assert_not_contains(output, "Enhanced function with OpenMP pragmas: running", 
+                                    "Loop with a carried scalar stays serial");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_scalar_temporary_is_private();
+        test_live_out_temporary_is_lastprivate();
+        test_temporary_arrays_are_privatized();
+        test_carried_scalar_blocks_parallelization();
+    }
+};
@@ -0,0 +1,225 @@
+#include "test_framework.h"
+
+class Phase3RecursiveTaskTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3RecursiveTaskTests(TestFramework& f) : framework(f) {}
+    
+    void test_independent_recursive_calls_become_tasks() {
+        std::cout << "Testing task generation for independent recursive calls..." << std::endl;
+        
+        std::string testCode = R"(
+int fib(int n) {
+    if (n < 2) return n;
+    int x = fib(n - 1);
+    int y = fib(n - 2);
+    return x + y;
+}
+
+int main() {
+    int result = fib(30);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "recursive_fib_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "Enhanced function with OpenMP tasks: fib", 
+                                "Recursive function is marked as task-parallel");
+        framework.assert_contains(output, "int fib_task(int n, int _task_depth)", 
+                                "Task helper threads the recursion depth");
+        framework.assert_contains(output, "#pragma omp task shared(x) if(_task_depth < 8) final(_task_depth >= 8)", 
+                                "Recursive call is wrapped in a task with a depth cutoff");
+        framework.assert_contains(output, "#pragma omp taskwait", 
+                                "Tasks are joined before results are combined");
+        framework.assert_contains(output, "#pragma omp single", 
+                                "Entry point opens a parallel region for the tasks");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_recursive_calls_in_return_expression() {
+        std::cout << "Testing recursive calls combined in a return expression..." << std::endl;
+        
+        std::string testCode = R"(
+struct Node { Node* left; Node* right; int value; };
+
+long tree_sum(Node* node) {
+    if (!node) return 0;
+    return node->value + tree_sum(node->left) + tree_sum(node->right);
+}
+
+int main() {
+    Node leaf = {nullptr, nullptr, 1};
+    long result = tree_sum(&leaf);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "recursive_tree_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "_task_r0_0 = tree_sum_task(node->left, _task_depth + 1);", 
+                                "First call is hoisted into a task temporary");
+        framework.assert_contains(output, "return node->value + _task_r0_0 + _task_r0_1;", 
+                                "Return combines the task results");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_dependent_recursive_calls_stay_serial() {
+        std::cout << "Testing that dependent recursive calls are not tasked..." << std::endl;
+        
+        std::string testCode = R"(
+int counter = 0;
+
+int chain(int n) {
+    if (n <= 0) return 0;
+    int a = chain(n - 1);
+    int b = chain(a - 1);
+    return a + b;
+}
+
+void count_down(int n) {
+    if (n <= 0) return;
+    counter = counter + 1;
+    count_down(n - 1);
+    count_down(n - 2);
+}
+
+int main() {
+    int result = chain(10);
+    count_down(5);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "recursive_dependent_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_not_contains(output, "Enhanced function with OpenMP tasks: chain", 
+                                    "Call consuming a sibling result is not tasked");
+        framework.assert_not_contains(output, "Enhanced function with OpenMP tasks: count_down", 
+                                    "Recursion writing globals is not tasked");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_const_results_are_split() {
+        std::cout << "Testing recursive calls initializing const results..." << std::endl;
+        
+        std::string testCode = R"(
+long fib(int n) {
+    if (n < 2) return n;
+    const long x = fib(n - 1);
+    const long y = fib(n - 2);
+    return x + y;
+}
+
+int main() {
+    long result = fib(30);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "recursive_const_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "Enhanced function with OpenMP tasks: fib", 
+                                "Const results do not keep the calls serial");
+        framework.assert_contains(output, "long x;\n", 
+                                "Result is declared before the task assigns it");
+        framework.assert_not_contains(output, "const long x;", 
+                                    "A const declared without initializer would not compile");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_return_branch_gets_block() {
+        std::cout << "Testing recursive calls in a return that is an if branch..." << std::endl;
+        
+        std::string testCode = R"(
+long fib(int n) {
+    if (n >= 2) return fib(n - 1) + fib(n - 2);
+    return n;
+}
+
+int main() {
+    long result = fib(30);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "recursive_branch_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "if (n >= 2) {\n        long _task_r0_0;", 
+                                "Tasks are spawned inside the branch");
+        framework.assert_contains(output, "return _task_r0_0 + _task_r0_1;\n    }\n    return n;", 
+                                "The branch is closed after its return");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_writes_through_parameters() {
+        std::cout << "Testing recursive calls sharing written pointer parameters..." << std::endl;
+        
+        std::string testCode = R"(
+struct Node { Node* left; Node* right; long value; };
+
+void walk(Node* node, long* total) {
+    if (!node) return;
+    *total += node->value;
+    walk(node->left, total);
+    walk(node->right, total);
+}
+
+void merge(int* a, int* tmp, int lo, int mid, int hi) {
+    int i = lo, j = mid, k = lo;
+    while (i < mid && j < hi) tmp[k++] = a[i] < a[j] ? a[i++] : a[j++];
+    while (i < mid) tmp[k++] = a[i++];
+    while (j < hi) tmp[k++] = a[j++];
+    for (k = lo; k < hi; k++) a[k] = tmp[k];
+}
+
+void msort(int* a, int* tmp, int lo, int hi) {
+    if (hi - lo < 2) return;
+    int mid = (lo + hi) / 2;
+    msort(a, tmp, lo, mid);
+    msort(a, tmp, mid, hi);
+    merge(a, tmp, lo, mid, hi);
+}
+
+int main() {
+    Node leaf = {nullptr, nullptr, 1};
+    long total = 0;
+    walk(&leaf, &total);
+    int a[8] = {5, 3, 7, 1, 8, 2, 6, 4}, tmp[8];
+    msort(a, tmp, 0, 8);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "recursive_pointer_writes_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_not_contains(output, "Enhanced function with OpenMP tasks: walk", 
+                                    "Calls accumulating through a shared pointer would race");
+        framework.assert_contains(output, "Enhanced function with OpenMP tasks: msort", 
+                                "Calls splitting the index range write disjoint elements");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_independent_recursive_calls_become_tasks();
+        test_recursive_calls_in_return_expression();
+        test_const_results_are_split();
+        test_return_branch_gets_block();
+        test_writes_through_parameters();
+        test_dependent_recursive_calls_stay_serial();
+    }
+};
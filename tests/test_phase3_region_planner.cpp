@@ -0,0 +1,107 @@
+#include "test_framework.h"
+
+class Phase3RegionPlannerTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3RegionPlannerTests(TestFramework& f) : framework(f) {}
+    
+    void test_small_loops_skip_ranks_and_threads() {
+        std::cout << "Testing --plan on loops of different sizes..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cstdio>
+
+double small_sum(double* a) {
+    double s = 0.0;
+    for (int i = 0; i < 8; i++) {
+        s += a[i];
+    }
+    return s;
+}
+
+double large_sum(double* a, int n) {
+    double s = 0.0;
+    for (int i = 0; i < n; i++) {
+        s += a[i] * 0.5;
+    }
+    return s;
+}
+
+int main() {
+    static double a[100000];
+    double s = small_sum(a);
+    double t = large_sum(a, 100000);
+    printf("%f %f\n", s, t);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "region_planner.cpp");
+        std::string output = run_parallelizer_on_file(filepath, "--plan=latency=2,cores=16");
+        
+        framework.assert_contains(output, "#pragma omp simd reduction(+:s)", 
+                                "An eight-iteration loop runs as SIMD on one thread");
+        framework.assert_not_contains(output, "_loop_end = 8;", 
+                                    "An eight-iteration loop is not split across ranks");
+        framework.assert_contains(output, "static inline bool _plan_split(", 
+                                "The machine model is compiled into the program");
+        framework.assert_contains(output, "bool _split = _plan_split((double)_total_iters", 
+                                "A loop of unknown length decides its split at run time");
+        framework.assert_contains(output, "if (_split) {", 
+                                "Collectives are skipped when the loop is not split");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_inclusive_bounds_and_single_core() {
+        std::cout << "Testing --plan with inclusive bounds and one core per rank..." << std::endl;
+        
+        std::string testCode = R"(
+#include <cstdio>
+
+double small_sum(double* a) {
+    double s = 0.0;
+    for (int i = 0; i <= 8; i++) {
+        s += a[i];
+    }
+    return s;
+}
+
+void scale(double* a, int n) {
+    for (int i = 0; i < n; i++) {
+        a[i] = a[i] * 0.5;
+    }
+}
+
+int main() {
+    static double a[100000];
+    scale(a, 100000);
+    double s = small_sum(a);
+    printf("%f\n", s);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "region_planner_bounds.cpp");
+        std::string output = run_parallelizer_on_file(filepath, "--plan=cores=16");
+        
+        framework.assert_contains(output, "#pragma omp simd reduction(+:s)", 
+                                "A nine-iteration loop written with <= runs as SIMD");
+        
+        output = run_parallelizer_on_file(filepath, "--plan=cores=1");
+        
+        framework.assert_not_contains(output, "#pragma omp parallel for reduction(+:s)", 
+                                    "One core per rank starts no threads for a short loop");
+        framework.assert_not_contains(output, " if(((", 
+                                    "One core per rank has no thread break-even to test");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_small_loops_skip_ranks_and_threads();
+        test_inclusive_bounds_and_single_core();
+    }
+};
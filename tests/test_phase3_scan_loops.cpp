@@ -0,0 +1,173 @@
+#include "test_framework.h"
+
+class Phase3ScanLoopTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3ScanLoopTests(TestFramework& f) : framework(f) {}
+    
+    void test_inclusive_running_sum() {
+        std::cout << "Testing inclusive scan for running sums..." << std::endl;
+        
+        std::string testCode = R"(
+double running_total(const double* x, double* y, int n) {
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        sum += x[i];
+        y[i] = sum;
+    }
+    return sum;
+}
+
+int main() {
+    double x[100], y[100];
+    running_total(x, y, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "inclusive_scan_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "#pragma omp parallel for reduction(inscan, +:sum)", 
+                                "Running sum uses an inscan reduction");
+        framework.assert_contains(output, "#pragma omp scan inclusive(sum)", 
+                                "Scan directive follows the update");
+        framework.assert_contains(output, "MPI_Exscan(&_scan_local, &_scan_offset, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);", 
+                                "Ranks start from the sum of the blocks before them");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_exclusive_running_sum() {
+        std::cout << "Testing exclusive scan for offsets computed before the update..." << std::endl;
+        
+        std::string testCode = R"(
+void bucket_offsets(const int* count, int* offset, int n) {
+    int next = 0;
+    for (int i = 0; i < n; i++) {
+        offset[i] = next;
+        next += count[i];
+    }
+}
+
+int main() {
+    int count[64], offset[64];
+    bucket_offsets(count, offset, 64);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "exclusive_scan_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "#pragma omp scan exclusive(next)", 
+                                "Scan directive precedes the update");
+        framework.assert_not_contains(output, "reduction(inscan, +:next) schedule", 
+                                    "No schedule clause with an inscan reduction");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_array_recurrence() {
+        std::cout << "Testing prefix sums written as a[i] = a[i-1] + b[i]..." << std::endl;
+        
+        std::string testCode = R"(
+void prefix(long* a, const long* b, int n) {
+    for (int i = 1; i < n; i++) {
+        a[i] = a[i - 1] + b[i];
+    }
+}
+
+int main() {
+    long a[100], b[100];
+    prefix(a, b, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "recurrence_scan_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "reduction(inscan, +:_scan_a)", 
+                                "Recurrence gets a fresh accumulator");
+        framework.assert_contains(output, "_scan_a += b[i];", 
+                                "Accumulator adds each contribution");
+        framework.assert_contains(output, "a[i] = _scan_a;", 
+                                "Array is written from the accumulator");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_sum_read_on_both_sides_stays_serial() {
+        std::cout << "Testing that running sums read before and after the update stay serial..." << std::endl;
+        
+        std::string testCode = R"(
+void both_sides(const double* x, double* lo, double* hi, int n) {
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        lo[i] = sum;
+        sum += x[i];
+        hi[i] = sum;
+    }
+}
+
+int main() {
+    double x[100], lo[100], hi[100];
+    both_sides(x, lo, hi, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "two_sided_scan_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "Scalar 'sum' is read before it is written", 
+                                "Carried running sum is reported");
+        framework.assert_not_contains(output, "Enhanced function with OpenMP pragmas: both_sides", 
+                                    "Loop stays serial");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_body_local_contribution_stays_on_threads() {
+        std::cout << "Testing scans whose contribution uses a body-local variable..." << std::endl;
+        
+        std::string testCode = R"(
+double weighted_total(const double* x, double* y, double w, int n) {
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        double t = x[i] * w;
+        sum += t;
+        y[i] = sum;
+    }
+    return sum;
+}
+
+int main() {
+    double x[100], y[100];
+    weighted_total(x, y, 0.5, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "body_local_scan_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "#pragma omp scan inclusive(sum)", 
+                                "The loop is still scanned on threads");
+        framework.assert_not_contains(output, "MPI_Exscan", 
+                                    "The contribution is not copied out of the body for block sums");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_inclusive_running_sum();
+        test_exclusive_running_sum();
+        test_array_recurrence();
+        test_sum_read_on_both_sides_stays_serial();
+        test_body_local_contribution_stays_on_threads();
+    }
+};
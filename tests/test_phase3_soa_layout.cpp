@@ -0,0 +1,181 @@
+#include "test_framework.h"
+
+class Phase3SoALayoutTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3SoALayoutTests(TestFramework& f) : framework(f) {}
+    
+    void test_fields_gathered_around_repeat_loop() {
+        std::cout << "Testing structure-of-arrays copies around a time-step loop with --soa..." << std::endl;
+        
+        std::string testCode = R"(
+#include <vector>
+
+struct Particle {
+    double x, y, z;
+    double vx, vy, vz;
+    int id;
+};
+
+void advance(std::vector<Particle>& particles, int steps, double dt) {
+    int n = particles.size();
+    int t = 0;
+    while (t < steps) {
+        for (int i = 0; i < n; i++) {
+            particles[i].x += particles[i].vx * dt;
+        }
+        t++;
+    }
+}
+
+int main() {
+    std::vector<Particle> particles(1000);
+    advance(particles, 100, 0.1);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "soa_layout_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath, "--soa");
+        
+        framework.assert_contains(output, "std::vector<double> _soa_particles_x((size_t)(particles.size()));", 
+                                "Each touched field gets a contiguous buffer");
+        framework.assert_contains(output, "_soa_particles_x[i] += _soa_particles_vx[i] * dt;", 
+                                "Loop reads the copies at unit stride");
+        framework.assert_not_contains(output, "particles[_soa_k].vx = ", 
+                                    "Read-only field is not written back");
+        
+        // One gather before the time-step loop and one scatter after it, not one per step
+        size_t gather = output.find("_soa_particles_x[_soa_k] = particles[_soa_k].x;");
+        size_t repeat = output.find("while (t < steps) {");
+        size_t lastStep = output.find("t++;", repeat == std::string::npos ? 0 : repeat);
+        size_t scatter = output.find("particles[_soa_k].x = _soa_particles_x[_soa_k];");
+        framework.assert_true(gather != std::string::npos && repeat != std::string::npos && gather < repeat, 
+                              "Fields are gathered once, before the time-step loop");
+        framework.assert_true(scatter != std::string::npos && lastStep != std::string::npos && scatter > lastStep, 
+                              "Written field is scattered back once, after the time-step loop");
+        framework.assert_true(output.find("_soa_particles_x[_soa_k] = particles[_soa_k].x;", gather + 1) == std::string::npos, 
+                              "The copy is not repeated around the inner loop");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_single_pass_loop_keeps_layout() {
+        std::cout << "Testing that a loop run once per call keeps the struct layout..." << std::endl;
+        
+        std::string testCode = R"(
+#include <vector>
+
+struct Particle {
+    double x, y, z;
+    double vx, vy, vz;
+    int id;
+};
+
+void advance(std::vector<Particle>& particles, double dt) {
+    int n = particles.size();
+    for (int i = 0; i < n; i++) {
+        particles[i].x += particles[i].vx * dt;
+    }
+}
+
+int main() {
+    std::vector<Particle> particles(1000);
+    advance(particles, 0.1);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "soa_single_pass_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath, "--soa");
+        
+        framework.assert_not_contains(output, "_soa_particles_", 
+                                    "Gathering and scattering every call costs more than the loop saves");
+        framework.assert_contains(output, "particles[i].x += particles[i].vx * dt;", 
+                                "Loop body keeps the struct accesses");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_layout_unchanged_without_flag() {
+        std::cout << "Testing that the struct layout is kept by default..." << std::endl;
+        
+        std::string testCode = R"(
+struct Point {
+    float x, y;
+};
+
+float sum_x() {
+    Point points[256];
+    float total = 0.0f;
+    for (int i = 0; i < 256; i++) {
+        total += points[i].x;
+    }
+    return total;
+}
+
+int main() {
+    sum_x();
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "soa_default_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_not_contains(output, "_soa_", 
+                                    "No field copies unless --soa is given");
+        framework.assert_contains(output, "total += points[i].x;", 
+                                "Loop body keeps the struct accesses");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_struct_passed_to_call_keeps_layout() {
+        std::cout << "Testing that structs reachable from a call are not copied..." << std::endl;
+        
+        std::string testCode = R"(
+struct Cell {
+    double value, weight;
+};
+
+Cell cells[128];
+
+double weigh(int i) {
+    return cells[i].weight;
+}
+
+void update(int n, int steps) {
+    int t = 0;
+    while (t < steps) {
+        for (int i = 0; i < n; i++) {
+            cells[i].value = weigh(i) * 2.0;
+        }
+        t++;
+    }
+}
+
+int main() {
+    update(128, 10);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "soa_call_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath, "--soa");
+        
+        framework.assert_not_contains(output, "_soa_cells_", 
+                                    "A callee could read the structs instead of the copies");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_fields_gathered_around_repeat_loop();
+        test_single_pass_loop_keeps_layout();
+        test_layout_unchanged_without_flag();
+        test_struct_passed_to_call_keeps_layout();
+    }
+};
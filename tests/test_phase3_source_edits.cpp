@@ -0,0 +1,81 @@
+#include "test_framework.h"
+
+class Phase3SourceEditTests {
+private:
+    TestFramework& framework;
+    
+    static int count_occurrences(const std::string& text, const std::string& pattern) {
+        int count = 0;
+        for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1)) {
+            count++;
+        }
+        return count;
+    }
+    
+public:
+    Phase3SourceEditTests(TestFramework& f) : framework(f) {}
+    
+    void test_identical_loops_are_both_rewritten() {
+        std::cout << "Testing that textually identical loops are each rewritten..." << std::endl;
+        
+        std::string testCode = R"(
+void reset_twice(double* a, int n) {
+    for (int i = 0; i < n; i++) {
+        a[i] = 0.0;
+    }
+    a[0] = 1.0;
+    for (int i = 0; i < n; i++) {
+        a[i] = 0.0;
+    }
+}
+
+int main() {
+    double a[100];
+    reset_twice(a, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "identical_loops_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_equals(2, count_occurrences(output, "// Hybrid MPI+OpenMP Parallel Loop"), 
+                              "Both loops are split across ranks");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_single_statement_body() {
+        std::cout << "Testing loops whose body is a single statement without braces..." << std::endl;
+        
+        std::string testCode = R"(
+void scale(const double* in, double* out, int n) {
+    for (int i = 0; i < n; i++) out[i] = in[i] * 2.0;
+    if (n > 0) {
+        out[0] = in[0];
+    }
+}
+
+int main() {
+    double in[100], out[100];
+    scale(in, out, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "braceless_loop_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "for (int i = _my_start; i < _my_end; i += 1) out[i] = in[i] * 2.0;", 
+                                "Rank loop keeps the single-statement body");
+        framework.assert_contains(output, "if (n > 0) {\n        out[0] = in[0];\n    }", 
+                                "Code after the loop is left untouched");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_identical_loops_are_both_rewritten();
+        test_single_statement_body();
+    }
+};
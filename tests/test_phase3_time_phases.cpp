@@ -0,0 +1,92 @@
+#include "test_framework.h"
+
+class Phase3TimePhasesTests {
+private:
+    TestFramework& framework;
+    
+    // The phase table goes to stderr, which run_parallelizer_on_file discards
+    std::string run_and_capture_stderr(const std::string& filepath, const std::string& options) {
+        std::string logPath = "/home/khanh/parallel/tests/time_phases_stderr.log";
+        std::string command = "cd /home/khanh/parallel && ./mpi-parallelizer " + options + " " + filepath +
+                              " > /dev/null 2> " + logPath;
+        system(command.c_str());
+        std::ifstream log(logPath);
+        std::stringstream buffer;
+        buffer << log.rdbuf();
+        remove(logPath.c_str());
+        return buffer.str();
+    }
+    
+    std::string read_file(const std::string& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return "ERROR: Could not open " + path;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+    
+    const char* testCode = R"(
+double sum_array(double* a, int n) {
+    double total = 0.0;
+    for (int i = 0; i < n; i++) {
+        total += a[i];
+    }
+    return total;
+}
+
+int main() {
+    static double a[1000];
+    double s = sum_array(a, 1000);
+    return s > 0.0;
+}
+)";
+    
+public:
+    Phase3TimePhasesTests(TestFramework& f) : framework(f) {}
+    
+    void test_phase_table() {
+        std::cout << "Testing the --time-phases table..." << std::endl;
+        
+        std::string filepath = create_temp_cpp_file(testCode, "time_phases_test.cpp");
+        std::string log = run_and_capture_stderr(filepath, "--time-phases");
+        
+        framework.assert_contains(log, "=== Analyzer Phases ===", 
+                                "The phase table is printed");
+        framework.assert_contains(log, "Clang parse and Sema", 
+                                "Parsing is timed separately from the analysis");
+        framework.assert_contains(log, "loops=1", 
+                                "Loop analysis reports its node count");
+        framework.assert_contains(log, "Generate hybrid code", 
+                                "Code generation is a phase");
+        framework.assert_contains(log, "peak RSS [MB]", 
+                                "Peak memory is reported");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_chrome_trace() {
+        std::cout << "Testing the --time-trace Chrome trace..." << std::endl;
+        
+        std::string filepath = create_temp_cpp_file(testCode, "time_trace_test.cpp");
+        std::string tracePath = "/home/khanh/parallel/tests/time_trace_test.json";
+        std::string log = run_and_capture_stderr(filepath, "--time-trace=" + tracePath);
+        std::string trace = read_file(tracePath);
+        
+        framework.assert_contains(trace, "\"traceEvents\"", 
+                                "The trace is in Chrome trace format");
+        framework.assert_contains(trace, "\"Analyze loops\"", 
+                                "Analysis phases are trace events");
+        framework.assert_not_contains(log, "=== Analyzer Phases ===", 
+                                    "Tracing alone does not print the table");
+        
+        remove(filepath.c_str());
+        remove(tracePath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_phase_table();
+        test_chrome_trace();
+    }
+};
@@ -0,0 +1,160 @@
+#include "test_framework.h"
+
+class Phase3WhileLoopTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3WhileLoopTests(TestFramework& f) : framework(f) {}
+    
+    void test_affine_while_loop_becomes_for_loop() {
+        std::cout << "Testing iteration-space inference for while loops..." << std::endl;
+        
+        std::string testCode = R"(
+void scale(double* data, int n) {
+    int i = 0;
+    while (i < n) {
+        data[i] = data[i] * 2.0;
+        i++;
+    }
+}
+
+int main() {
+    double data[100];
+    scale(data, 100);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "while_affine_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "Enhanced function with OpenMP pragmas: scale", 
+                                "Affine while loop is parallelized");
+        framework.assert_contains(output, "lastprivate(i)", 
+                                "Induction variable keeps its sequential final value");
+        framework.assert_contains(output, "i = _loop_start + _total_iters * _loop_step;", 
+                                "MPI split restores the induction variable after the loop");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_do_while_loop_runs_at_least_once() {
+        std::cout << "Testing do-while conversion keeps the first iteration..." << std::endl;
+        
+        std::string testCode = R"(
+void fill(int* out, int m) {
+    int k = 0;
+    do {
+        out[k] = k * k;
+        k += 2;
+    } while (k <= m);
+}
+
+int main() {
+    int out[64];
+    fill(out, 40);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "do_while_affine_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "long _loop_end = (((m) + 1) > (0) ? ((m) + 1) : (0) + 1);", 
+                                "Inclusive bound is made exclusive and covers the first iteration");
+        framework.assert_contains(output, "k += 2) {", 
+                                "Constant step is carried into the canonical loop");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_early_exit_search_runs_speculatively() {
+        std::cout << "Testing speculative execution of search loops..." << std::endl;
+        
+        std::string testCode = R"(
+int find_first(const int* data, int n, int key) {
+    int pos = -1;
+    int i = 0;
+    while (i < n) {
+        if (data[i] == key) {
+            pos = i;
+            break;
+        }
+        i++;
+    }
+    return pos;
+}
+
+int main() {
+    int data[100] = {0};
+    int pos = find_first(data, 100, 7);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "while_search_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_contains(output, "#pragma omp for schedule(static) private(pos)", 
+                                "Search result is private in the speculative probe");
+        framework.assert_contains(output, "#pragma omp cancel for", 
+                                "Break cancels the worksharing loop");
+        framework.assert_contains(output, "for (i = _search_start + _search_resume * _search_step; i < n; i++)", 
+                                "Serial loop replays from the chunk that hit");
+        framework.assert_not_contains(output, "long _loop_end = n;", 
+                                    "Search loop is not split across MPI ranks");
+        
+        remove(filepath.c_str());
+    }
+    
+    void test_irregular_while_loop_stays_serial() {
+        std::cout << "Testing that non-affine while loops are left alone..." << std::endl;
+        
+        std::string testCode = R"(
+struct Node { Node* next; int value; };
+
+int list_sum(Node* node) {
+    int total = 0;
+    while (node) {
+        total += node->value;
+        node = node->next;
+    }
+    return total;
+}
+
+int halve(int n) {
+    int steps = 0;
+    while (n > 1) {
+        steps++;
+        n = n / 2;
+    }
+    return steps;
+}
+
+int main() {
+    Node tail = {nullptr, 1};
+    int total = list_sum(&tail);
+    int steps = halve(64);
+    return 0;
+}
+)";
+        
+        std::string filepath = create_temp_cpp_file(testCode, "while_irregular_test.cpp");
+        std::string output = run_parallelizer_on_file(filepath);
+        
+        framework.assert_not_contains(output, "Enhanced function with OpenMP pragmas: list_sum", 
+                                    "Pointer-chasing loop is not parallelized");
+        framework.assert_not_contains(output, "Enhanced function with OpenMP pragmas: halve", 
+                                    "Geometric update is not an affine induction variable");
+        
+        remove(filepath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_affine_while_loop_becomes_for_loop();
+        test_do_while_loop_runs_at_least_once();
+        test_early_exit_search_runs_speculatively();
+        test_irregular_while_loop_stays_serial();
+    }
+};
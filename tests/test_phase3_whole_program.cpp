@@ -0,0 +1,190 @@
+#include "test_framework.h"
+
+class Phase3WholeProgramTests {
+private:
+    TestFramework& framework;
+    
+public:
+    Phase3WholeProgramTests(TestFramework& f) : framework(f) {}
+    
+    void test_functions_from_other_units() {
+        std::cout << "Testing --whole-program summaries of other translation units..." << std::endl;
+        
+        std::string libCode = R"(
+int total = 0;
+
+double scale(double* a, int n) {
+    double s = 0.0;
+    for (int i = 0; i < n; i++) {
+        s += a[i] * 2.0;
+    }
+    return s;
+}
+
+void record(int n) {
+    total += n;
+}
+
+int read_total() {
+    return total;
+}
+)";
+        
+        std::string mainCode = R"(
+#include <cstdio>
+
+double scale(double* a, int n);
+void record(int n);
+int read_total();
+
+int main() {
+    static double a[1000];
+    double s = scale(a, 1000);
+    record(3);
+    int t = read_total();
+    printf("%f %d\n", s, t);
+    return 0;
+}
+)";
+        
+        std::string libpath = create_temp_cpp_file(libCode, "whole_program_lib.cpp");
+        std::string mainpath = create_temp_cpp_file(mainCode, "whole_program_main.cpp");
+        std::string output = run_parallelizer_on_file(mainpath, "--whole-program " + libpath);
+        
+        framework.assert_not_contains(output, "Function definition not found", 
+                                    "Functions of other units are not stubbed");
+        framework.assert_contains(output, "double scale(double *, int);", 
+                                "Functions of other units are declared for linking");
+        framework.assert_not_contains(output, "s += a[i] * 2.0", 
+                                    "Functions of other units are not copied into the output");
+        framework.assert_contains(output, "// Defined in " + libpath, 
+                                "The defining unit is named");
+        
+        remove(libpath.c_str());
+        remove(mainpath.c_str());
+    }
+    
+    void test_private_functions_stay_in_their_unit() {
+        std::cout << "Testing --whole-program with unit-private types and static helpers..." << std::endl;
+        
+        std::string libCode = R"(
+struct Node {
+    int value;
+    Node* next;
+};
+
+int total = 0;
+
+static void helper(Node* node) {
+    total += node->value;
+}
+
+void record(int n) {
+    Node node = {n, nullptr};
+    helper(&node);
+}
+
+int read_total() {
+    return total;
+}
+)";
+        
+        std::string otherCode = R"(
+static void helper(int* count) {
+    (*count)++;
+}
+
+int counted(int n) {
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        helper(&count);
+    }
+    return count;
+}
+)";
+        
+        std::string mainCode = R"(
+#include <cstdio>
+
+void record(int n);
+int read_total();
+
+int main() {
+    record(3);
+    int t = read_total();
+    printf("%d\n", t);
+    return 0;
+}
+)";
+        
+        std::string libpath = create_temp_cpp_file(libCode, "whole_program_private_lib.cpp");
+        std::string otherpath = create_temp_cpp_file(otherCode, "whole_program_private_other.cpp");
+        std::string mainpath = create_temp_cpp_file(mainCode, "whole_program_private_main.cpp");
+        std::string output = run_parallelizer_on_file(mainpath, "--whole-program --report=json " + libpath + " " + otherpath);
+        std::string reportPath = "/home/khanh/parallel/whole_program_private_main_report.json";
+        std::ifstream reportFile(reportPath);
+        std::stringstream report;
+        report << reportFile.rdbuf();
+        
+        framework.assert_not_contains(output, "helper", 
+                                    "Static helpers of other units are not declared");
+        framework.assert_not_contains(output, "Node", 
+                                    "Types private to other units do not leak into the output");
+        framework.assert_not_contains(output, "counted", 
+                                    "Functions main does not declare are not merged");
+        framework.assert_contains(output, "void record(int);", 
+                                "Declared functions of other units are merged");
+        framework.assert_contains(report.str(), "\"reason\": \"Global variable RAW: total\"", 
+                                "record() and read_total() are ordered by the global they share");
+        framework.assert_not_contains(report.str(), "\"record\",\n        \"read_total\"", 
+                                    "record() and read_total() are not in the same parallel group");
+        
+        remove(libpath.c_str());
+        remove(otherpath.c_str());
+        remove(mainpath.c_str());
+        remove(reportPath.c_str());
+    }
+    
+    void test_extern_globals_are_not_redefined() {
+        std::cout << "Testing --whole-program with a global defined in another unit..." << std::endl;
+        
+        std::string libCode = R"(
+int total = 0;
+
+void record(int n) {
+    total += n;
+}
+)";
+        
+        std::string mainCode = R"(
+#include <cstdio>
+
+extern int total;
+void record(int n);
+
+int main() {
+    record(3);
+    printf("%d\n", total);
+    return 0;
+}
+)";
+        
+        std::string libpath = create_temp_cpp_file(libCode, "whole_program_extern_lib.cpp");
+        std::string mainpath = create_temp_cpp_file(mainCode, "whole_program_extern_main.cpp");
+        std::string output = run_parallelizer_on_file(mainpath, "--whole-program " + libpath);
+        
+        framework.assert_contains(output, "extern int total;", 
+                                "The global is declared extern");
+        framework.assert_not_contains(output, "int total = 0;", 
+                                    "The global is not defined a second time");
+        
+        remove(libpath.c_str());
+        remove(mainpath.c_str());
+    }
+    
+    void run_all_tests() {
+        test_functions_from_other_units();
+        test_private_functions_stay_in_their_unit();
+        test_extern_globals_are_not_redefined();
+    }
+};
@@ -2,15 +2,34 @@
 
 // Static member initialization
 const std::map<std::string, TypeMapper::TypeInfo> TypeMapper::TYPE_MAP = {
-    // Basic C++ types
+    // Basic C++ types, spelled the way Clang prints canonical builtin types
     {"int",          TypeInfo("MPI_INT", "0")},
     {"double",       TypeInfo("MPI_DOUBLE", "0.0")},
     {"float",        TypeInfo("MPI_FLOAT", "0.0f")},
-    {"bool",         TypeInfo("MPI_C_BOOL", "false")},
+    {"bool",         TypeInfo("MPI_CXX_BOOL", "false")},
     {"char",         TypeInfo("MPI_CHAR", "'\\0'")},
+    {"signed char",  TypeInfo("MPI_SIGNED_CHAR", "0")},
+    {"unsigned char", TypeInfo("MPI_UNSIGNED_CHAR", "0")},
+    {"wchar_t",      TypeInfo("MPI_WCHAR", "0")},
+    {"short",        TypeInfo("MPI_SHORT", "0")},
+    {"unsigned short", TypeInfo("MPI_UNSIGNED_SHORT", "0")},
     {"long",         TypeInfo("MPI_LONG", "0L")},
     {"unsigned int", TypeInfo("MPI_UNSIGNED", "0U")},
+    {"unsigned long", TypeInfo("MPI_UNSIGNED_LONG", "0UL")},
     {"long long",    TypeInfo("MPI_LONG_LONG", "0LL")},
+    {"unsigned long long", TypeInfo("MPI_UNSIGNED_LONG_LONG", "0ULL")},
+    {"long double",  TypeInfo("MPI_LONG_DOUBLE", "0.0L")},
+    
+    // Fixed-width integers, for types that reach us only as written; canonical
+    // types from the analyzers already resolve them to one of the builtins above
+    {"int8_t",       TypeInfo("MPI_INT8_T", "0")},
+    {"int16_t",      TypeInfo("MPI_INT16_T", "0")},
+    {"int32_t",      TypeInfo("MPI_INT32_T", "0")},
+    {"int64_t",      TypeInfo("MPI_INT64_T", "0")},
+    {"uint8_t",      TypeInfo("MPI_UINT8_T", "0")},
+    {"uint16_t",     TypeInfo("MPI_UINT16_T", "0")},
+    {"uint32_t",     TypeInfo("MPI_UINT32_T", "0")},
+    {"uint64_t",     TypeInfo("MPI_UINT64_T", "0")},
     
     // Common STL types that need special handling
     {"std::string",  TypeInfo("", "\"\"", false, true)},
@@ -35,6 +54,11 @@ std::string TypeMapper::normalizeType(const std::string& cppType) {
 std::string TypeMapper::getMPIDatatype(const std::string& cppType) {
     std::string normalizedType = normalizeType(cppType);
     
+    // <cstdint> names may come with or without their namespace
+    if (normalizedType.compare(0, 5, "std::") == 0 && TYPE_MAP.count(normalizedType.substr(5))) {
+        normalizedType = normalizedType.substr(5);
+    }
+    
     // Check main type map first
     auto it = TYPE_MAP.find(normalizedType);
     if (it != TYPE_MAP.end()) {
@@ -47,13 +71,9 @@ std::string TypeMapper::getMPIDatatype(const std::string& cppType) {
         return specialType.mpiType;
     }
     
-    // Check for unsupported patterns
-    if (matchesUnsupportedPattern(normalizedType)) {
-        return ""; // Unsupported type
-    }
-    
-    // Default fallback for simple unrecognized types
-    return "MPI_INT";
+    // Anything else - typedefs we could not resolve, enums, classes - has no datatype.
+    // Guessing MPI_INT would move the wrong number of bytes.
+    return "";
 }
 
 std::string TypeMapper::getDefaultValue(const std::string& cppType) {
@@ -80,8 +100,8 @@ std::string TypeMapper::getDefaultValue(const std::string& cppType) {
         return normalizedType + "{}";
     }
     
-    // Default fallback
-    return "0";
+    // Default fallback: value-initialization also covers structs from the input
+    return "{}";
 }
 
 bool TypeMapper::isTypeSupported(const std::string& cppType) {
@@ -129,4 +149,114 @@ bool TypeMapper::matchesUnsupportedPattern(const std::string& type) {
         }
     }
     return false;
-}
\ No newline at end of file
+}
+std::string TypeMapper::stripQualifiers(const std::string& cppType) {
+    std::string type = cppType;
+    
+    // Trailing references and cv-qualifiers
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        size_t end = type.find_last_not_of(" \t");
+        type = end == std::string::npos ? "" : type.substr(0, end + 1);
+        for (const char *suffixText : {"&", "const", "volatile"}) {
+            std::string suffix = suffixText;
+            if (type.size() >= suffix.size() && type.compare(type.size() - suffix.size(), suffix.size(), suffix) == 0 &&
+                (suffix == "&" || type.size() == suffix.size() || type[type.size() - suffix.size() - 1] == ' ')) {
+                type.erase(type.size() - suffix.size());
+                changed = true;
+            }
+        }
+    }
+    
+    // Leading cv-qualifiers and elaborated type keywords
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (const char *prefixText : {"const ", "volatile ", "struct ", "class "}) {
+            std::string prefix = prefixText;
+            if (type.compare(0, prefix.size(), prefix) == 0) {
+                type.erase(0, prefix.size());
+                changed = true;
+            }
+        }
+    }
+    return normalizeType(type);
+}
+
+std::vector<std::string> TypeMapper::templateArguments(const std::string& type, const std::string& name) {
+    std::vector<std::string> args;
+    for (const std::string& prefix : {"std::" + name + "<", name + "<"}) {
+        if (type.compare(0, prefix.size(), prefix) != 0 || type.back() != '>') continue;
+        
+        // Split at commas outside nested template argument lists
+        int depth = 0;
+        std::string current;
+        for (size_t i = prefix.size(); i + 1 < type.size(); i++) {
+            char c = type[i];
+            if (c == '<') depth++;
+            if (c == '>') depth--;
+            if (c == ',' && depth == 0) {
+                args.push_back(current);
+                current.clear();
+                continue;
+            }
+            current += c;
+        }
+        args.push_back(current);
+        for (auto& arg : args) {
+            size_t start = arg.find_first_not_of(" ");
+            size_t end = arg.find_last_not_of(" ");
+            arg = start == std::string::npos ? "" : arg.substr(start, end - start + 1);
+        }
+        return args;
+    }
+    return args;
+}
+
+TypeMapper::TransferShape TypeMapper::getTransferShape(const std::string& cppType) {
+    std::string type = stripQualifiers(cppType);
+    TransferShape shape;
+    shape.elementType = type;
+    if (type.empty()) return shape;
+    
+    // Strings are resizable runs of char, like vectors
+    if (type == "std::string" || type == "string" || type.compare(0, 22, "std::basic_string<char") == 0) {
+        shape.elementType = "char";
+        shape.count.clear();
+        shape.isContainer = true;
+        return shape;
+    }
+    
+    std::vector<std::string> args = templateArguments(type, "vector");
+    if (!args.empty()) {
+        shape.elementType = stripQualifiers(args[0]);
+        shape.count.clear();
+        shape.isContainer = true;
+        return shape;
+    }
+    
+    args = templateArguments(type, "array");
+    if (args.size() == 2) {
+        // Canonical spellings carry a suffix on the size ("3UL")
+        std::string count = args[1];
+        while (!count.empty() && (count.back() == 'U' || count.back() == 'L' || count.back() == 'u' || count.back() == 'l')) {
+            count.pop_back();
+        }
+        shape.elementType = stripQualifiers(args[0]);
+        shape.count = count;
+        shape.isContainer = true;
+        return shape;
+    }
+    
+    // Built-in arrays: "double [8]" or "double[8]"
+    if (type.back() == ']') {
+        size_t open = type.rfind('[');
+        std::string count = open == std::string::npos ? "" : type.substr(open + 1, type.size() - open - 2);
+        if (!count.empty() && type.find('[') == open) {
+            shape.elementType = stripQualifiers(type.substr(0, open));
+            shape.count = count;
+        }
+    }
+    return shape;
+}
@@ -4,6 +4,7 @@
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
 
 /**
  * Utility class for handling C++ to MPI type mappings and default value generation.
@@ -21,6 +22,19 @@ public:
                 bool supported = true, bool stl = false) 
             : mpiType(mpi), defaultValue(def), isSupported(supported), isSTLType(stl) {}
     };
+    
+    /**
+     * How a value travels between ranks: a run of elements of one type, either
+     * a fixed count (single values, T[N], std::array) or a count sent first
+     * (std::vector, std::string)
+     */
+    struct TransferShape {
+        std::string elementType;    // Element type, the type itself for single values
+        std::string count = "1";    // Fixed element count, empty when sized at run time
+        bool isContainer = false;   // Elements reached through data()
+        
+        bool isDynamic() const { return count.empty(); }
+    };
 
 private:
     static const std::map<std::string, TypeInfo> TYPE_MAP;
@@ -52,6 +66,17 @@ public:
      * Check if a type is an STL type
      */
     static bool isSTLType(const std::string& cppType);
+    
+    /**
+     * Describe how to transfer a value of this type: std::vector<T>, std::string,
+     * std::array<T, N> and T[N] become element runs, anything else a single value
+     */
+    static TransferShape getTransferShape(const std::string& cppType);
+    
+    /**
+     * Strip const/volatile, references and struct/class keywords from a type name
+     */
+    static std::string stripQualifiers(const std::string& cppType);
 
 private:
     /**
@@ -63,6 +88,11 @@ private:
      * Check if type matches unsupported patterns
      */
     static bool matchesUnsupportedPattern(const std::string& type);
+    
+    /**
+     * Top-level template arguments of "name<args>", empty if the type is not one
+     */
+    static std::vector<std::string> templateArguments(const std::string& type, const std::string& name);
 };
 
 #endif // TYPE_MAPPING_H
\ No newline at end of file